@@ -1,9 +1,19 @@
 #pragma once
 
-#include <typeindex>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <format>
 #include <map>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include "game_system.hpp"
 #include "game_component.hpp"
+#include "game_entity.hpp"
 #include "game_scene.hpp"
\ No newline at end of file
@@ -22,7 +22,7 @@ namespace arx
 	struct StaticComponentComposition<This, Rest...>
 	{
 	public:
-		StaticComponentComposition(This this_conponent, Rest... rests) : component{ this_conponent }, others{ rests } {
+		StaticComponentComposition(This this_conponent, Rest... rests) : component{ this_conponent }, others{ rests... } {
 		}
 		~StaticComponentComposition() = default;
 
@@ -53,64 +53,80 @@ namespace arx
 	struct DynamicComponent
 	{
 		void* component;
-		std::type_index type;
+		size_t type;
+
+		template<typename Component>
+		static auto type_id() noexcept -> size_t {
+			return DenseTypeId<DynamicComponent>::of<Component>();
+		}
 
 		template<typename Component> requires Registrable<Component>
 		constexpr DynamicComponent(Component* component) :
-			component{ reinterpret_cast<void*>(component) }, type{ typeid(Component) },
-			register_function{ &DynamicComponent::register_component<Component> } {
+			component{ static_cast<void*>(component) }, type{ type_id<Component>() },
+			register_function{ [](void* component, DynamicSystemComposition* systems) { static_cast<Component*>(component)->register_to_systems(systems); } } {
 		}
 		DynamicComponent() = delete;
 
 		auto register_to_systems(DynamicSystemComposition* systems) -> void {
-			(this->*(this->register_function))(systems);
+			register_function(component, systems);
 		}
 
 		template<typename Component> requires Registrable<Component>
 		auto get_component() noexcept -> Component* {
-			if (std::type_index{ typeid(Component) } == type) {
-				return reinterpret_cast<Component*>(component);
+			if (type_id<Component>() == type) {
+				return static_cast<Component*>(component);
 			}
 			return nullptr;
 		}
 
 	private:
-		auto (DynamicComponent::* register_function)(DynamicSystemComposition*) -> void;
-
-		template<typename Component>
-		auto register_component(DynamicSystemComposition* systems) -> void {
-			reinterpret_cast<Component*>(component)->register_to_systems(systems);
-		}
+		auto (*register_function)(void*, DynamicSystemComposition*) -> void;
 	};
 
 	struct DynamicComponentComposition
 	{
-		std::vector<DynamicComponent> components;
+		std::vector<DynamicComponent> components; // added by `add_component`, which indexes them.
 
 		template<typename S>
 		auto register_to_systems(S* systems) -> void {
-			auto dynamic_systems = DynamicSystemComposition(systems);
-			for (auto& component : components) {
-				component.register_to_systems(&dynamic_systems);
+			if constexpr (std::same_as<S, DynamicSystemComposition>) {
+				for (auto& component : components) {
+					component.register_to_systems(systems);
+				}
+			}
+			else {
+				auto dynamic_systems = DynamicSystemComposition(systems); // on the stack, no allocation.
+				for (auto& component : components) {
+					component.register_to_systems(&dynamic_systems);
+				}
 			}
 		}
 		auto add_component(DynamicComponent component) -> void {
+			if (component.type >= slots.size()) {
+				slots.resize(component.type + 1, 0);
+			}
+			if (slots[component.type] == 0) {
+				slots[component.type] = components.size() + 1;
+			}
 			components.push_back(component);
 		}
 
 		template<typename Component> requires Registrable<Component>
 		auto add_component(Component* component) -> void {
-			components.push_back(DynamicComponent{ component });
+			add_component(DynamicComponent{ component });
 		}
 
+		// The first component of the type added.
 		template<typename Component> requires Registrable<Component>
 		auto get() noexcept -> Component* {
-			for (auto& component : components) {
-				if (auto c = component.get_component<Component>(); c != nullptr) {
-					return c;
-				}
+			size_t type = DynamicComponent::type_id<Component>();
+			if (type < slots.size() && slots[type] != 0) {
+				return components[slots[type] - 1].get_component<Component>();
 			}
 			return nullptr;
 		}
+
+	private:
+		std::vector<size_t> slots; // by component type, 1 + the index of its first component in `components`, 0 when there's none.
 	};
 }
\ No newline at end of file
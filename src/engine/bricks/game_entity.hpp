@@ -0,0 +1,411 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// A handle to an entity of an `EntityWorld`, which is only data: its components are stored by the world.
+	/// The generation tells apart the entities reusing the index of a destroyed one, so a handle to a destroyed entity is never alive again.
+	/// Generations start at 1, so a default `Entity` is never alive.
+	/// </summary>
+	struct Entity
+	{
+		uint32_t index = 0;
+		uint32_t generation = 0;
+
+		auto operator==(const Entity&) const -> bool = default;
+	};
+
+	/// <summary>
+	/// The components of one type of the entities of an archetype, contiguous, a row per entity.
+	/// </summary>
+	struct EntityColumn
+	{
+		virtual ~EntityColumn() = default;
+
+		// Removes a row, moving the last one into it.
+		virtual auto remove(size_t row) -> void = 0;
+		// Appends a row to a column of the same type, leaving it moved from.
+		virtual auto move_to(size_t row, EntityColumn& other) -> void = 0;
+		// An empty column of the same type.
+		virtual auto empty_copy() const -> std::unique_ptr<EntityColumn> = 0;
+	};
+
+	template<typename Component>
+	struct EntityColumnOf : EntityColumn
+	{
+		std::vector<Component> values;
+
+		auto remove(size_t row) -> void override {
+			if (row + 1 != values.size()) {
+				values[row] = std::move(values.back());
+			}
+			values.pop_back();
+		}
+		auto move_to(size_t row, EntityColumn& other) -> void override {
+			static_cast<EntityColumnOf&>(other).values.push_back(std::move(values[row]));
+		}
+		auto empty_copy() const -> std::unique_ptr<EntityColumn> override {
+			return std::make_unique<EntityColumnOf>();
+		}
+	};
+
+	/// <summary>
+	/// The entities having exactly the same types of components, whose components are stored in a column per type.
+	/// Iterating a type of components of an archetype reads an array, whatever the other components are.
+	/// </summary>
+	struct EntityArchetype
+	{
+		std::vector<size_t> types; // sorted ids of the types of components.
+		std::vector<std::unique_ptr<EntityColumn>> columns; // in the order of `types`.
+		std::vector<Entity> entities; // by row.
+		std::unordered_map<size_t, EntityArchetype*> with; // the archetypes with one more type, found once.
+		std::unordered_map<size_t, EntityArchetype*> without; // the archetypes with one less type, found once.
+
+		template<typename Component>
+		static auto type_id() noexcept -> size_t {
+			return DenseTypeId<EntityArchetype>::of<Component>();
+		}
+
+		auto size() const noexcept -> size_t {
+			return entities.size();
+		}
+
+		auto contains(size_t type) const noexcept -> bool {
+			return std::binary_search(types.begin(), types.end(), type);
+		}
+
+		auto column(size_t type) noexcept -> EntityColumn* {
+			auto found = std::lower_bound(types.begin(), types.end(), type);
+			if (found == types.end() || *found != type) {
+				return nullptr;
+			}
+			return columns[found - types.begin()].get();
+		}
+
+		// The components of a type contained, as an array of `size()`.
+		template<typename Component>
+		auto values() noexcept -> Component* {
+			return static_cast<EntityColumnOf<Component>*>(column(type_id<Component>()))->values.data();
+		}
+	};
+
+	/// <summary>
+	/// The entities having at least all of `Components`, found when the query is made, and iterated archetype by archetype.
+	/// `each(function)` calls `function(components&...)`, or `function(entity, components&...)`, with a loop over the arrays of each archetype,
+	/// and is the fastest way through the entities. A range-for gives `std::tuple<Components&...>`, and `iterator.entity()` the entity, the iterators pointing into the query.
+	/// Creating or destroying entities, or adding or removing components, while iterating, invalidates the query.
+	/// </summary>
+	template<typename... Components>
+	struct EntityQuery
+	{
+		static_assert(sizeof...(Components) > 0, "A query needs at least one type of components.");
+
+		struct iterator
+		{
+			using value_type = std::tuple<Components&...>;
+			using difference_type = std::ptrdiff_t;
+
+			EntityArchetype* const* archetype = nullptr;
+			EntityArchetype* const* last = nullptr;
+			size_t row = 0;
+			std::tuple<Components*...> arrays{ };
+
+			auto operator*() const -> value_type {
+				return { std::get<Components*>(arrays)[row]... };
+			}
+			auto entity() const -> Entity {
+				return (*archetype)->entities[row];
+			}
+			auto operator++() -> iterator& {
+				if (++row == (*archetype)->size()) {
+					++archetype;
+					row = 0;
+					settle();
+				}
+				return *this;
+			}
+			auto operator++(int) -> iterator {
+				auto previous = *this;
+				++*this;
+				return previous;
+			}
+			auto operator==(const iterator& other) const -> bool {
+				return archetype == other.archetype && row == other.row;
+			}
+
+			// Skips empty archetypes, and points the arrays to the components of the current one.
+			auto settle() -> void {
+				while (archetype != last && (*archetype)->size() == 0) {
+					++archetype;
+				}
+				if (archetype != last) {
+					arrays = { (*archetype)->template values<Components>()... };
+				}
+			}
+		};
+
+		std::vector<EntityArchetype*> archetypes;
+
+		auto begin() const -> iterator {
+			iterator begin{ archetypes.data(), archetypes.data() + archetypes.size() };
+			begin.settle();
+			return begin;
+		}
+		auto end() const -> iterator {
+			auto last = archetypes.data() + archetypes.size();
+			return { last, last };
+		}
+
+		// The entities found.
+		auto size() const -> size_t {
+			size_t size = 0;
+			for (auto archetype : archetypes) {
+				size += archetype->size();
+			}
+			return size;
+		}
+
+		template<typename Function>
+		auto each(Function&& function) const -> void {
+			for (auto archetype : archetypes) {
+				auto size = archetype->size();
+				std::tuple<Components*...> arrays{ archetype->template values<Components>()... };
+				if constexpr (std::is_invocable_v<Function&, Entity, Components&...>) {
+					auto entities = archetype->entities.data();
+					for (size_t row = 0; row < size; ++row) {
+						function(entities[row], std::get<Components*>(arrays)[row]...);
+					}
+				}
+				else {
+					for (size_t row = 0; row < size; ++row) {
+						function(std::get<Components*>(arrays)[row]...);
+					}
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// Entities made of components of any movable types, stored by archetype, so the components of a type are contiguous,
+	/// which is what systems iterating tens of thousands of entities need, instead of following a pointer per component.
+	/// `create(components...)` makes an entity, `add` and `remove` move it to the archetype of its new types of components,
+	/// and `query<Components...>()` finds the entities having all of `Components`.
+	/// Components move when entities are created, destroyed, or change archetype, as the columns grow and rows are moved into the removed ones,
+	/// so a pointer to a component is only valid until the next of these changes, while an `Entity` stays valid until the entity is destroyed.
+	/// </summary>
+	struct EntityWorld
+	{
+	public:
+		EntityWorld() {
+			archetypes.push_back(std::make_unique<EntityArchetype>());
+			signatures[{ }] = archetypes.back().get();
+		}
+		EntityWorld(const EntityWorld&) = delete;
+		auto operator=(const EntityWorld&) -> EntityWorld& = delete;
+
+		template<typename... Components>
+		auto create(Components... components) -> Entity {
+			static_assert(distinct<Components...>(), "An entity has one component of each type.");
+			std::vector<size_t> types{ EntityArchetype::type_id<Components>()... };
+			std::sort(types.begin(), types.end());
+			auto archetype = find(types);
+			if (archetype == nullptr) {
+				std::vector<std::pair<size_t, std::unique_ptr<EntityColumn>>> columns;
+				(columns.emplace_back(EntityArchetype::type_id<Components>(), std::make_unique<EntityColumnOf<Components>>()), ...);
+				std::sort(columns.begin(), columns.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+				std::vector<std::unique_ptr<EntityColumn>> sorted;
+				for (auto& [type, column] : columns) {
+					sorted.push_back(std::move(column));
+				}
+				archetype = make(std::move(types), std::move(sorted));
+			}
+
+			Entity entity;
+			if (free_indices.empty()) {
+				entity = { static_cast<uint32_t>(locations.size()), 1 };
+				locations.push_back({ archetype, 0, 1 });
+			}
+			else {
+				entity = { free_indices.back(), locations[free_indices.back()].generation };
+				free_indices.pop_back();
+			}
+			locations[entity.index].archetype = archetype;
+			locations[entity.index].row = static_cast<uint32_t>(archetype->size());
+			(static_cast<EntityColumnOf<Components>*>(archetype->column(EntityArchetype::type_id<Components>()))->values.push_back(std::move(components)), ...);
+			archetype->entities.push_back(entity);
+			++count;
+			return entity;
+		}
+
+		auto destroy(Entity entity) -> void {
+			if (!alive(entity)) {
+				return;
+			}
+			auto& location = locations[entity.index];
+			remove_row(location.archetype, location.row);
+			++location.generation;
+			location.archetype = nullptr;
+			free_indices.push_back(entity.index);
+			--count;
+		}
+
+		auto alive(Entity entity) const noexcept -> bool {
+			return entity.index < locations.size() && locations[entity.index].generation == entity.generation && locations[entity.index].archetype != nullptr;
+		}
+
+		// Adds a component to an entity, or replaces the one of its type.
+		template<typename Component>
+		auto add(Entity entity, Component component) -> Component& {
+			if (!alive(entity)) {
+				throw std::runtime_error("Adding a component to an entity not alive.");
+			}
+			if (auto existing = get<Component>(entity); existing != nullptr) {
+				*existing = std::move(component);
+				return *existing;
+			}
+			auto type = EntityArchetype::type_id<Component>();
+			auto& location = locations[entity.index];
+			auto source = location.archetype;
+			auto& target = source->with[type];
+			if (target == nullptr) {
+				auto types = source->types;
+				types.insert(std::lower_bound(types.begin(), types.end(), type), type);
+				target = find(types);
+				if (target == nullptr) {
+					std::vector<std::unique_ptr<EntityColumn>> columns;
+					for (size_t i = 0; i < types.size(); ++i) {
+						columns.push_back(types[i] == type ? std::make_unique<EntityColumnOf<Component>>() : source->column(types[i])->empty_copy());
+					}
+					target = make(std::move(types), std::move(columns));
+				}
+			}
+			move_row(entity, target);
+			auto& values = static_cast<EntityColumnOf<Component>*>(target->column(type))->values;
+			values.push_back(std::move(component));
+			return values.back();
+		}
+
+		template<typename Component>
+		auto remove(Entity entity) -> void {
+			if (!has<Component>(entity)) {
+				return;
+			}
+			auto type = EntityArchetype::type_id<Component>();
+			auto source = locations[entity.index].archetype;
+			auto& target = source->without[type];
+			if (target == nullptr) {
+				auto types = source->types;
+				types.erase(std::lower_bound(types.begin(), types.end(), type));
+				target = find(types);
+				if (target == nullptr) {
+					std::vector<std::unique_ptr<EntityColumn>> columns;
+					for (auto other : types) {
+						columns.push_back(source->column(other)->empty_copy());
+					}
+					target = make(std::move(types), std::move(columns));
+				}
+			}
+			move_row(entity, target);
+		}
+
+		// The component of the type of an entity, or nullptr if it has none or isn't alive.
+		template<typename Component>
+		auto get(Entity entity) noexcept -> Component* {
+			if (!alive(entity)) {
+				return nullptr;
+			}
+			auto& location = locations[entity.index];
+			auto column = location.archetype->column(EntityArchetype::type_id<Component>());
+			if (column == nullptr) {
+				return nullptr;
+			}
+			return &static_cast<EntityColumnOf<Component>*>(column)->values[location.row];
+		}
+
+		template<typename Component>
+		auto has(Entity entity) const noexcept -> bool {
+			return alive(entity) && locations[entity.index].archetype->contains(EntityArchetype::type_id<Component>());
+		}
+
+		template<typename... Components>
+		auto query() -> EntityQuery<Components...> {
+			static_assert(distinct<Components...>(), "A query names a type of components once.");
+			EntityQuery<Components...> query;
+			for (auto& archetype : archetypes) {
+				if ((archetype->contains(EntityArchetype::type_id<Components>()) && ...)) {
+					query.archetypes.push_back(archetype.get());
+				}
+			}
+			return query;
+		}
+
+		// The entities alive.
+		auto size() const noexcept -> size_t {
+			return count;
+		}
+
+	private:
+		struct Location
+		{
+			EntityArchetype* archetype;
+			uint32_t row;
+			uint32_t generation;
+		};
+
+		std::vector<Location> locations; // by entity index.
+		std::vector<uint32_t> free_indices;
+		size_t count = 0;
+		std::vector<std::unique_ptr<EntityArchetype>> archetypes;
+		std::map<std::vector<size_t>, EntityArchetype*> signatures;
+
+		template<typename Type, typename... Types>
+		static constexpr size_t occurrences = (size_t{ std::same_as<Type, Types> } + ... + 0);
+
+		template<typename... Types>
+		static constexpr auto distinct() -> bool {
+			return ((occurrences<Types, Types...> == 1) && ...);
+		}
+
+		auto find(const std::vector<size_t>& types) -> EntityArchetype* {
+			auto found = signatures.find(types);
+			return found == signatures.end() ? nullptr : found->second;
+		}
+
+		auto make(std::vector<size_t> types, std::vector<std::unique_ptr<EntityColumn>> columns) -> EntityArchetype* {
+			auto& archetype = archetypes.emplace_back(std::make_unique<EntityArchetype>());
+			archetype->types = std::move(types);
+			archetype->columns = std::move(columns);
+			signatures[archetype->types] = archetype.get();
+			return archetype.get();
+		}
+
+		// Moves the components an entity keeps to another archetype, whose columns it lacks are filled by the caller.
+		auto move_row(Entity entity, EntityArchetype* target) -> void {
+			auto& location = locations[entity.index];
+			auto source = location.archetype;
+			for (size_t i = 0; i < source->types.size(); ++i) {
+				if (auto column = target->column(source->types[i]); column != nullptr) {
+					source->columns[i]->move_to(location.row, *column);
+				}
+			}
+			auto row = location.row;
+			location.archetype = target;
+			location.row = static_cast<uint32_t>(target->size());
+			target->entities.push_back(entity);
+			remove_row(source, row);
+		}
+
+		// Removes a row from an archetype, moving its last row into it.
+		auto remove_row(EntityArchetype* archetype, uint32_t row) -> void {
+			for (auto& column : archetype->columns) {
+				column->remove(row);
+			}
+			auto& entities = archetype->entities;
+			if (row + 1 != entities.size()) {
+				entities[row] = entities.back();
+				locations[entities[row].index].row = row;
+			}
+			entities.pop_back();
+		}
+	};
+}
@@ -28,7 +28,7 @@ namespace arx
 	struct StaticSystemComposition<This, Rest...>
 	{
 	public:
-		StaticSystemComposition(This* this_system, Rest*... rests) : this_system{ this_system }, others{ rests } {
+		StaticSystemComposition(This* this_system, Rest*... rests) : this_system{ this_system }, others{ rests... } {
 		}
 		~StaticSystemComposition() = default;
 		This* this_system;
@@ -68,80 +68,100 @@ namespace arx
 		}
 	};
 
+	/// <summary>
+	/// Dense ids of the types registered dynamically, counted from 0 in the order the types are first used,
+	/// so a type is found by indexing an array with its id instead of comparing `std::type_index`es.
+	/// Systems and components are counted apart, so the ids of systems stay small.
+	/// </summary>
+	template<typename Kind>
+	struct DenseTypeId
+	{
+		template<typename T>
+		static auto of() noexcept -> size_t {
+			static const size_t id = next.fetch_add(1, std::memory_order_relaxed);
+			return id;
+		}
+
+	private:
+		static inline std::atomic<size_t> next = 0;
+	};
+
 	struct DynamicSystem
 	{
 	public: // concept: System.
 		auto mobilize() -> void {
-			(this->*mobilize_function)();
+			mobilize_function(system);
 		}
 		auto freeze() -> void {
-			(this->*freeze_function)();
+			freeze_function(system);
 		}
 		auto update() -> void {
-			(this->*update_function)();
+			update_function(system);
 		}
 
 	public:
 		void* system;
-		std::type_index type;
+		size_t type;
+
+		template<typename S>
+		static auto type_id() noexcept -> size_t {
+			return DenseTypeId<DynamicSystem>::of<S>();
+		}
 
 		template<typename S>
 		requires System<S>
-		DynamicSystem(S* system) : system{ system }, type{ typeid(S) } {
-			mobilize_function = &DynamicSystem::mobilize_internal<S>;
-			freeze_function = &DynamicSystem::freeze_internal<S>;
-			update_function = &DynamicSystem::update_internal<S>;
+		DynamicSystem(S* system) : system{ system }, type{ type_id<S>() },
+			mobilize_function{ [](void* system) { static_cast<S*>(system)->mobilize(); } },
+			freeze_function{ [](void* system) { static_cast<S*>(system)->freeze(); } },
+			update_function{ [](void* system) { static_cast<S*>(system)->update(); } } {
 		}
-		DynamicSystem() = delete;
+		DynamicSystem() = default; // left uninitialized, for the slots of compositions.
 
 		template<typename S>
 		auto get_system() -> S* {
-			if (std::type_index{ typeid(S) } == type) {
-				return reinterpret_cast<S*>(system);
+			if (type_id<S>() == type) {
+				return static_cast<S*>(system);
 			}
 			return nullptr;
 		}
 
 	private:
-		auto (DynamicSystem::* mobilize_function)() -> void;
-		auto (DynamicSystem::* freeze_function)() -> void;
-		auto (DynamicSystem::* update_function)() -> void;
-
-		template<typename S>
-		auto mobilize_internal() -> void {
-			reinterpret_cast<S*>(system)->mobilize();
-		}
-		template<typename S>
-		auto freeze_internal() -> void {
-			reinterpret_cast<S*>(system)->freeze();
-		}
-		template<typename S>
-		auto update_internal() -> void {
-			reinterpret_cast<S*>(system)->update();
-		}
+		auto (*mobilize_function)(void*) -> void;
+		auto (*freeze_function)(void*) -> void;
+		auto (*update_function)(void*) -> void;
 	};
 
+	/// <summary>
+	/// Systems known at runtime, stored in place, so a composition is built on the stack without allocating,
+	/// as `DynamicComponentComposition::register_to_systems` does for every registration.
+	/// `get<S>()` indexes `slots` with the dense id of `S`, and the systems are updated in the order they were added.
+	/// </summary>
 	struct DynamicSystemComposition
 	{
 	public:	// concept: System.
 		auto mobilize() -> void {
-			for (auto& system : systems) {
-				system.second.mobilize();
+			for (size_t i = 0; i < count; ++i) {
+				systems[i].mobilize();
 			}
 		}
 		auto freeze() -> void {
-			for (auto& system : systems) {
-				system.second.freeze();
+			for (size_t i = 0; i < count; ++i) {
+				systems[i].freeze();
 			}
 		}
 		auto update() -> void {
-			for (auto& system : systems) {
-				system.second.update();
+			for (size_t i = 0; i < count; ++i) {
+				systems[i].update();
 			}
 		}
 
 	public:
-		std::map<std::type_index, DynamicSystem> systems;
+		static constexpr size_t capacity = 32; // system types in the whole program, beyond which systems can't be added.
+
+		std::array<DynamicSystem, capacity> systems; // the first `count` are added.
+		size_t count = 0;
+
+		DynamicSystemComposition() = default;
 
 		template<typename... types>
 		DynamicSystemComposition(StaticSystemComposition<types...>* static_systems) {
@@ -150,16 +170,26 @@ namespace arx
 
 		template<typename S> requires System<S>
 		auto add_system(S* system) -> void {
-			systems[std::type_index{ typeid(S) }] = DynamicSystem{ system };
+			size_t type = DynamicSystem::type_id<S>();
+			if (type >= capacity) {
+				throw std::runtime_error(std::format("Too many system types, a DynamicSystemComposition holds {} at most.", capacity));
+			}
+			if (slots[type] == 0) {
+				slots[type] = static_cast<uint8_t>(++count);
+			}
+			systems[slots[type] - 1] = DynamicSystem{ system };
 		}
 
 		template<typename S> requires System<S>
 		auto get() noexcept -> S* {
-			auto it = systems.find(std::type_index{ typeid(S) });
-			if (it != systems.end()) {
-				return it->second.get_system<S>();
+			size_t type = DynamicSystem::type_id<S>();
+			if (type < capacity && slots[type] != 0) {
+				return static_cast<S*>(systems[slots[type] - 1].system);
 			}
 			return nullptr;
 		}
+
+	private:
+		std::array<uint8_t, capacity> slots{ }; // by system type, 1 + the index of the system in `systems`, 0 when there's none.
 	};
 }
\ No newline at end of file
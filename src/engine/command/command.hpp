@@ -13,9 +13,36 @@
 #include <unordered_set>
 #include <optional>
 #include <memory>
+#include <deque>
+#include <limits>
+#include <atomic>
+#include <span>
+#include <charconv>
+#include <list>
+#include <tuple>
+#include <algorithm>
+#include <mutex>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
 
 namespace arx 
 {
+	/// <summary>
+	/// Line and column of a token or node in its source, both counted from 1. A line of 0 means the position is unknown.
+	/// </summary>
+	struct CommandSourcePosition
+	{
+		uint32_t line = 0;
+		uint32_t column = 0;
+
+		auto known() const -> bool {
+			return line != 0;
+		}
+	};
+
 	struct CommandException : public std::exception
 	{
 		CommandException(const std::string& message) : message{ message } {
@@ -33,6 +60,19 @@ namespace arx
 			return message.c_str();
 		}
 
+		/// <summary>
+		/// Prefixes the message with where the error happened, unless it's already located.
+		/// Handlers closer to the error locate it first, so the most precise known position is kept.
+		/// </summary>
+		auto locate(CommandSourcePosition at) -> void {
+			if (!position.known() && at.known()) {
+				position = at;
+				message = std::format("{}:{}: {}", at.line, at.column, message);
+			}
+		}
+
+		CommandSourcePosition position;
+
 	private:
 		std::string message;
 	};
@@ -40,9 +80,24 @@ namespace arx
 
 #include "command_ast.hpp"
 #include "command_formatter.hpp"
+#include "command_value.hpp"
+#include "command_collector.hpp"
+#include "command_optimizer.hpp"
+#include "command_profiler.hpp"
 #include "command_kernel.hpp"
+#include "command_compiler.hpp"
+#include "command_machine.hpp"
 #include "command_reader.hpp"
 #include "command_parser.hpp"
+#include "command_binding.hpp"
+#include "command_sink.hpp"
 #include "command_library.hpp"
 #include "command_ast_printer.hpp"
-#include "command_runtime.hpp"
\ No newline at end of file
+#include "command_cache.hpp"
+#include "command_archive.hpp"
+#include "command_queue.hpp"
+#include "command_module.hpp"
+#include "command_context.hpp"
+#include "command_runtime.hpp"
+#include "command_scheduler.hpp"
+#include "command_watcher.hpp"
\ No newline at end of file
@@ -0,0 +1,521 @@
+#pragma once
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace arx
+{
+	/// <summary>
+	/// A file mapped read only into memory, empty if it couldn't be opened.
+	/// </summary>
+	struct CommandMappedFile
+	{
+		CommandMappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+			file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return;
+			}
+			LARGE_INTEGER file_size{ };
+			if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+				return;
+			}
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping == nullptr) {
+				return;
+			}
+			auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (view != nullptr) {
+				bytes = { static_cast<const std::byte*>(view), static_cast<size_t>(file_size.QuadPart) };
+			}
+#else
+			auto descriptor = ::open(path.c_str(), O_RDONLY);
+			if (descriptor < 0) {
+				return;
+			}
+			struct stat status{ };
+			if (::fstat(descriptor, &status) == 0 && status.st_size > 0) {
+				auto view = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+				if (view != MAP_FAILED) {
+					bytes = { static_cast<const std::byte*>(view), static_cast<size_t>(status.st_size) };
+				}
+			}
+			::close(descriptor);
+#endif
+		}
+
+		CommandMappedFile(const CommandMappedFile&) = delete;
+
+		~CommandMappedFile() {
+#if defined(_WIN32)
+			if (!bytes.empty()) {
+				UnmapViewOfFile(bytes.data());
+			}
+			if (mapping != nullptr) {
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+			}
+#else
+			if (!bytes.empty()) {
+				::munmap(const_cast<std::byte*>(bytes.data()), bytes.size());
+			}
+#endif
+		}
+
+		std::span<const std::byte> bytes;
+
+	private:
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#endif
+	};
+
+	/// <summary>
+	/// Compiled scripts saved to disk (`.arxc`), so running an unchanged script again skips lexing, parsing and compiling.
+	/// An archive is only loaded if it was saved from the same source, by the same version of the compiler, with the same optimizing,
+	/// anything else, a truncated or a damaged file included, makes `load` return `nullptr` and the caller compile the source again.
+	/// The layout is a header followed by arrays of fixed size records at aligned offsets, read directly from the mapped file:
+	/// chunks are listed children first, and symbols are indices into the archive's own table of names,
+	/// which are interned by the loading kernel.
+	/// </summary>
+	struct CommandScriptArchive
+	{
+		static constexpr char magic[4] = { 'A', 'R', 'X', 'C' };
+		static constexpr uint32_t format = 3;
+
+		struct Header
+		{
+			char magic[4];
+			uint32_t format;
+			uint32_t compiler;
+			uint32_t optimizing;
+			uint64_t source_hash;
+			uint64_t source_size;
+			uint64_t size;
+			uint64_t checksum; // of everything after the header, since damaged instructions would be excuted as they are.
+			uint32_t name_count;
+			uint32_t chunk_count;
+			uint32_t step_count;
+			uint32_t padding;
+			uint64_t names; // offset of the table of names, each a `Text`.
+			uint64_t chunks; // offset of the `ChunkRecord`s.
+			uint64_t steps; // offset of the `StepRecord`s.
+		};
+
+		struct Text
+		{
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		struct ChunkRecord
+		{
+			uint64_t instructions; // `instruction_count` instructions, then as many positions.
+			uint64_t numbers;
+			uint64_t integers;
+			uint64_t strings; // `Text`s.
+			uint64_t chunks; // indices of earlier chunks.
+			uint32_t instruction_count;
+			uint32_t number_count;
+			uint32_t integer_count;
+			uint32_t string_count;
+			uint32_t chunk_count;
+			uint32_t register_count;
+			uint32_t reference_count;
+			uint32_t reaches_outer;
+			uint32_t line; // of the body the chunk is compiled from.
+			uint32_t column;
+			uint32_t padding;
+		};
+
+		struct StepRecord
+		{
+			uint32_t chunk; // `none` for an error.
+			uint32_t padding;
+			Text error;
+		};
+
+		static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+		static_assert(std::is_trivially_copyable_v<CommandInstruction> && sizeof(CommandInstruction) == 16);
+		static_assert(std::is_trivially_copyable_v<CommandSourcePosition> && sizeof(CommandSourcePosition) == 8);
+
+		// FNV-1a, which unlike `std::hash` is the same on every build.
+		static auto hash(std::string_view source) -> uint64_t {
+			uint64_t hash = 14695981039346656037ull;
+			for (auto c : source) {
+				hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+			}
+			return hash;
+		}
+
+		/// <summary>
+		/// Writes a script whose every statement is compiled (`Step::chunk`) or an error. Returns false if it couldn't be written.
+		/// </summary>
+		static auto save(const std::filesystem::path& path, const CommandScript& script, std::string_view source, const CommandSymbols& symbols, bool optimizing) -> bool {
+			Writer writer{ symbols };
+			writer.bytes.resize(sizeof(Header));
+			std::vector<StepRecord> steps;
+			for (auto& step : script.steps) {
+				if (step.chunk == nullptr && step.error.empty()) {
+					return false;
+				}
+				steps.push_back({ step.chunk != nullptr ? writer.add_chunk(*step.chunk) : none, 0, { } });
+			}
+
+			Header header{ };
+			std::copy(std::begin(magic), std::end(magic), header.magic);
+			header.format = format;
+			header.compiler = CommandCompiler::version;
+			header.optimizing = optimizing;
+			header.source_hash = hash(source);
+			header.source_size = source.size();
+
+			for (size_t i = 0; i < steps.size(); ++i) {
+				if (steps[i].chunk == none) {
+					steps[i].error = writer.write_text(script.steps[i].error);
+				}
+			}
+			std::vector<Text> names;
+			for (auto& name : writer.names) {
+				names.push_back(writer.write_text(name));
+			}
+			header.name_count = static_cast<uint32_t>(names.size());
+			header.names = writer.write_array(std::span<const Text>{ names });
+			header.chunk_count = static_cast<uint32_t>(writer.chunks.size());
+			header.chunks = writer.write_array(std::span<const ChunkRecord>{ writer.chunks });
+			header.step_count = static_cast<uint32_t>(steps.size());
+			header.steps = writer.write_array(std::span<const StepRecord>{ steps });
+			header.size = writer.bytes.size();
+			header.checksum = hash(writer.payload());
+			std::memcpy(writer.bytes.data(), &header, sizeof(Header));
+
+			// Written aside and renamed, so a reader never maps a partly written archive.
+			auto temporary = path;
+			temporary += ".tmp";
+			{
+				std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+				if (!file.write(reinterpret_cast<const char*>(writer.bytes.data()), writer.bytes.size())) {
+					return false;
+				}
+			}
+			std::error_code error;
+			std::filesystem::rename(temporary, path, error);
+			return !error;
+		}
+
+		/// <summary>
+		/// The script saved at `path` from `source`, with its symbols interned into `symbols`, or `nullptr` if there's none which is fresh.
+		/// </summary>
+		static auto load(const std::filesystem::path& path, std::string_view source, CommandSymbols& symbols, bool optimizing) -> std::shared_ptr<CommandScript> {
+			CommandMappedFile file{ path };
+			Reader reader{ file.bytes };
+			auto header = reader.get<Header>(0);
+			if (header == nullptr || !std::equal(std::begin(magic), std::end(magic), header->magic)
+				|| header->format != format || header->compiler != CommandCompiler::version || header->optimizing != static_cast<uint32_t>(optimizing)
+				|| header->size != file.bytes.size() || header->source_size != source.size() || header->source_hash != hash(source)
+				|| header->checksum != hash(reader.payload())) {
+				return nullptr;
+			}
+
+			auto names = reader.get_array<Text>(header->names, header->name_count);
+			auto chunk_records = reader.get_array<ChunkRecord>(header->chunks, header->chunk_count);
+			auto step_records = reader.get_array<StepRecord>(header->steps, header->step_count);
+			if (!reader.valid) {
+				return nullptr;
+			}
+			std::vector<uint32_t> interned;
+			for (auto& name : names) {
+				interned.push_back(symbols.intern(std::string{ reader.get_text(name) }));
+			}
+
+			std::vector<std::shared_ptr<const CommandChunk>> chunks;
+			for (auto& record : chunk_records) {
+				auto chunk = reader.read_chunk(record, interned, chunks);
+				if (chunk == nullptr) {
+					return nullptr;
+				}
+				chunks.push_back(std::move(chunk));
+			}
+
+			auto script = std::make_shared<CommandScript>();
+			for (auto& record : step_records) {
+				if (record.chunk == none) {
+					script->steps.push_back({ std::nullopt, nullptr, std::string{ reader.get_text(record.error) } });
+				}
+				else if (record.chunk < chunks.size()) {
+					script->steps.push_back({ std::nullopt, chunks[record.chunk], { } });
+				}
+				else {
+					return nullptr;
+				}
+			}
+			return reader.valid ? script : nullptr;
+		}
+
+	private:
+		struct Writer
+		{
+			const CommandSymbols& symbols;
+			std::vector<std::byte> bytes{ };
+			std::vector<ChunkRecord> chunks{ };
+			std::vector<std::string> names{ };
+			std::unordered_map<uint32_t, uint32_t> name_indices{ }; // from the symbols of the saving kernel.
+			std::unordered_map<const CommandChunk*, uint32_t> chunk_indices{ };
+
+			auto payload() const -> std::string_view {
+				return { reinterpret_cast<const char*>(bytes.data()) + sizeof(Header), bytes.size() - sizeof(Header) };
+			}
+
+			auto align(size_t alignment) -> void {
+				bytes.resize((bytes.size() + alignment - 1) / alignment * alignment);
+			}
+
+			template<typename T>
+			auto write_array(std::span<const T> values) -> uint64_t {
+				align(alignof(T) < 8 ? 8 : alignof(T));
+				auto offset = bytes.size();
+				bytes.resize(offset + values.size_bytes());
+				if (!values.empty()) {
+					std::memcpy(bytes.data() + offset, values.data(), values.size_bytes());
+				}
+				return offset;
+			}
+
+			auto write_text(std::string_view text) -> Text {
+				auto offset = bytes.size();
+				bytes.resize(offset + text.size());
+				std::memcpy(bytes.data() + offset, text.data(), text.size());
+				return { offset, text.size() };
+			}
+
+			auto name_of(uint32_t symbol) -> uint32_t {
+				auto [found, inserted] = name_indices.try_emplace(symbol, static_cast<uint32_t>(names.size()));
+				if (inserted) {
+					names.push_back(symbols.name(symbol));
+				}
+				return found->second;
+			}
+
+			// Children are added before their parents, so loading never refers to a chunk which isn't loaded yet.
+			auto add_chunk(const CommandChunk& chunk) -> uint32_t {
+				if (auto found = chunk_indices.find(&chunk); found != chunk_indices.end()) {
+					return found->second;
+				}
+				std::vector<uint32_t> children;
+				for (auto& child : chunk.chunks) {
+					children.push_back(add_chunk(*child));
+				}
+				auto instructions = chunk.instructions;
+				for (auto& instruction : instructions) {
+					if (auto symbol = instruction.symbol_operand()) {
+						*symbol = name_of(*symbol);
+					}
+				}
+				std::vector<Text> strings;
+				for (auto& string : chunk.strings) {
+					strings.push_back(write_text(string));
+				}
+
+				ChunkRecord record{ };
+				record.instructions = write_array(std::span<const CommandInstruction>{ instructions });
+				write_array(std::span<const CommandSourcePosition>{ chunk.positions });
+				record.numbers = write_array(std::span<const double>{ chunk.numbers });
+				record.integers = write_array(std::span<const int64_t>{ chunk.integers });
+				record.strings = write_array(std::span<const Text>{ strings });
+				record.chunks = write_array(std::span<const uint32_t>{ children });
+				record.instruction_count = static_cast<uint32_t>(instructions.size());
+				record.number_count = static_cast<uint32_t>(chunk.numbers.size());
+				record.integer_count = static_cast<uint32_t>(chunk.integers.size());
+				record.string_count = static_cast<uint32_t>(strings.size());
+				record.chunk_count = static_cast<uint32_t>(children.size());
+				record.register_count = chunk.register_count;
+				record.reference_count = chunk.reference_count;
+				record.reaches_outer = chunk.reaches_outer;
+				record.line = chunk.position.line;
+				record.column = chunk.position.column;
+				chunks.push_back(record);
+				auto index = static_cast<uint32_t>(chunks.size() - 1);
+				chunk_indices.emplace(&chunk, index);
+				return index;
+			}
+		};
+
+		// Every read is bounds checked, a failed one clears `valid` and reads nothing.
+		struct Reader
+		{
+			std::span<const std::byte> bytes;
+			bool valid = true;
+
+			auto fits(uint64_t offset, uint64_t size, size_t alignment) -> bool {
+				if (offset > bytes.size() || size > bytes.size() - offset || offset % alignment != 0) {
+					valid = false;
+				}
+				return valid;
+			}
+
+			auto payload() const -> std::string_view {
+				return { reinterpret_cast<const char*>(bytes.data()) + sizeof(Header), bytes.size() - sizeof(Header) };
+			}
+
+			template<typename T>
+			auto get(uint64_t offset) -> const T* {
+				return fits(offset, sizeof(T), alignof(T)) ? reinterpret_cast<const T*>(bytes.data() + offset) : nullptr;
+			}
+
+			template<typename T>
+			auto get_array(uint64_t offset, uint64_t count) -> std::span<const T> {
+				if (count > bytes.size() / sizeof(T) || !fits(offset, count * sizeof(T), alignof(T))) {
+					return { };
+				}
+				return { reinterpret_cast<const T*>(bytes.data() + offset), static_cast<size_t>(count) };
+			}
+
+			auto get_text(const Text& text) -> std::string_view {
+				if (!fits(text.offset, text.size, 1)) {
+					return { };
+				}
+				return { reinterpret_cast<const char*>(bytes.data() + text.offset), static_cast<size_t>(text.size) };
+			}
+
+			auto read_chunk(const ChunkRecord& record, const std::vector<uint32_t>& interned, const std::vector<std::shared_ptr<const CommandChunk>>& loaded) -> std::shared_ptr<const CommandChunk> {
+				auto instructions = get_array<CommandInstruction>(record.instructions, record.instruction_count);
+				auto positions = get_array<CommandSourcePosition>(record.instructions + instructions.size_bytes(), record.instruction_count);
+				auto numbers = get_array<double>(record.numbers, record.number_count);
+				auto integers = get_array<int64_t>(record.integers, record.integer_count);
+				auto strings = get_array<Text>(record.strings, record.string_count);
+				auto children = get_array<uint32_t>(record.chunks, record.chunk_count);
+				if (!valid) {
+					return nullptr;
+				}
+				// The compiler writes every register and reference it allocates, so neither outnumbers the instructions, which keeps damaged counts from reserving the memory.
+				if (record.register_count > record.instruction_count || record.reference_count > record.instruction_count) {
+					return nullptr;
+				}
+
+				auto chunk = std::make_shared<CommandChunk>();
+				chunk->instructions.assign(instructions.begin(), instructions.end());
+				for (auto& instruction : chunk->instructions) {
+					if (auto symbol = instruction.symbol_operand()) {
+						if (*symbol >= interned.size()) {
+							return nullptr;
+						}
+						*symbol = interned[*symbol];
+					}
+				}
+				chunk->positions.assign(positions.begin(), positions.end());
+				chunk->numbers.assign(numbers.begin(), numbers.end());
+				chunk->integers.assign(integers.begin(), integers.end());
+				for (auto& string : strings) {
+					chunk->strings.emplace_back(get_text(string));
+				}
+				for (auto child : children) {
+					if (child >= loaded.size()) {
+						return nullptr;
+					}
+					chunk->chunks.push_back(loaded[child]);
+				}
+				chunk->register_count = record.register_count;
+				chunk->reference_count = record.reference_count;
+				chunk->reaches_outer = record.reaches_outer != 0;
+				chunk->position = { record.line, record.column };
+				for (auto& instruction : chunk->instructions) {
+					if (!operands_fit(instruction, *chunk)) {
+						return nullptr;
+					}
+				}
+				return valid ? chunk : nullptr;
+			}
+
+			// Whether the operands of an instruction are in the registers, references, constants and code of its chunk, as the machine doesn't check them.
+			static auto operands_fit(const CommandInstruction& instruction, const CommandChunk& chunk) -> bool {
+				using Code = CommandInstruction::Code;
+				auto registers = [&](uint64_t first, uint64_t count = 1) { return first + count <= chunk.register_count; };
+				auto reference = [&](uint32_t index) { return index < chunk.reference_count; };
+				auto name = [&] { return instruction.c == 0 || registers(instruction.b); }; // a symbol, mapped by then, or a register.
+				switch (instruction.code) {
+				case Code::Empty:
+					return registers(instruction.a);
+				case Code::Number:
+					return registers(instruction.a) && instruction.b < chunk.numbers.size();
+				case Code::Integer:
+					return registers(instruction.a) && instruction.b < chunk.integers.size();
+				case Code::String:
+					return registers(instruction.a) && instruction.b < chunk.strings.size();
+				case Code::Identifier:
+					return registers(instruction.a);
+				case Code::Positive:
+				case Code::Negative:
+				case Code::Not:
+				case Code::Access:
+					return registers(instruction.a) && registers(instruction.b);
+				case Code::Add:
+				case Code::Subtract:
+				case Code::Multiply:
+				case Code::Divide:
+				case Code::Modulo:
+				case Code::Exponent:
+				case Code::Equal:
+				case Code::NotEqual:
+				case Code::LessThan:
+				case Code::LessThanOrEqual:
+				case Code::GreaterThan:
+				case Code::GreaterThanOrEqual:
+				case Code::Call:
+				case Code::TailCall:
+					return registers(instruction.a) && registers(instruction.b) && registers(instruction.c);
+				case Code::List:
+					return registers(instruction.a) && registers(instruction.b, instruction.c);
+				case Code::Function:
+					return registers(instruction.a) && instruction.b < chunk.chunks.size();
+				case Code::Jump:
+					return instruction.a <= chunk.instructions.size();
+				case Code::JumpIfNegative:
+					return registers(instruction.a) && instruction.b <= chunk.instructions.size();
+				case Code::Argument:
+				case Code::Return:
+				case Code::Self:
+				case Code::Loop:
+					return registers(instruction.a) && instruction.b >= 1;
+				case Code::Protect:
+				case Code::Delete:
+					return registers(instruction.a) && name();
+				case Code::ReferIdentifier:
+					return reference(instruction.a);
+				case Code::ReferLocal:
+				case Code::ReferProtection:
+					return reference(instruction.a) && name();
+				case Code::ReferIndex:
+					return reference(instruction.a) && reference(instruction.b) && registers(instruction.c);
+				case Code::ReferAccess:
+					return reference(instruction.a) && registers(instruction.b);
+				case Code::Guard:
+					return reference(instruction.a);
+				case Code::Load:
+					return registers(instruction.a) && reference(instruction.b);
+				case Code::Store:
+					return registers(instruction.a) && reference(instruction.b) && registers(instruction.c);
+				case Code::Throw:
+					return instruction.a < chunk.strings.size();
+				default:
+					return false;
+				}
+			}
+		};
+	};
+}
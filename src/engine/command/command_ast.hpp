@@ -31,19 +31,31 @@ namespace arx
 
 	struct CommandASTNumberNode
 	{
-		float value;
+		double value; // of a number which isn't `integral`.
+		int64_t integer = 0;
+		bool integral = false;
 
 		CommandASTNumberNode(CommandASTNumberNode&&) = default;
 		CommandASTNumberNode& operator=(CommandASTNumberNode&&) = default;
 
-		CommandASTNumberNode(float value) : value(value) { }
+		CommandASTNumberNode(double value) : value(value) { }
 
-		static auto make(float value) -> CommandASTNumberNode {
+		static auto make(double value) -> CommandASTNumberNode {
 			return CommandASTNumberNode{ value };
 		}
 
+		static auto make_integer(int64_t integer) -> CommandASTNumberNode {
+			CommandASTNumberNode node{ static_cast<double>(integer) };
+			node.integer = integer;
+			node.integral = true;
+			return node;
+		}
+
 		auto clone() const -> CommandASTNumberNode {
-			return CommandASTNumberNode{ value };
+			auto node = CommandASTNumberNode{ value };
+			node.integer = integer;
+			node.integral = integral;
+			return node;
 		}
 	};
 
@@ -179,19 +191,20 @@ namespace arx
 
 	struct CommandASTFunctionBodyNode
 	{
-		std::vector<CommandASTStatementNode> commands;
+		// Shared by the functions made from the body instead of being copied into each of them, so it's only modified while it's parsed.
+		std::shared_ptr<std::vector<CommandASTStatementNode>> commands;
 
 		CommandASTFunctionBodyNode(CommandASTFunctionBodyNode&&) = default;
 		CommandASTFunctionBodyNode& operator=(CommandASTFunctionBodyNode&&) = default;
 
-		CommandASTFunctionBodyNode(std::vector<CommandASTStatementNode>&& commands) : commands(std::move(commands)) { }
+		CommandASTFunctionBodyNode(std::vector<CommandASTStatementNode>&& commands) : commands(std::make_shared<std::vector<CommandASTStatementNode>>(std::move(commands))) { }
 
 		static auto make(std::vector<CommandASTStatementNode>&& commands) -> CommandASTFunctionBodyNode {
 			return CommandASTFunctionBodyNode{ std::move(commands) };
 		}
 
 		auto clone() const -> CommandASTFunctionBodyNode {
-			return CommandASTFunctionBodyNode{ clone_vector(commands) };
+			return CommandASTFunctionBodyNode{ clone_vector(*commands) };
 		}
 	};
 
@@ -259,7 +272,7 @@ namespace arx
 		CommandASTDeleteNode(CommandASTDeleteNode&&) = default;
 		CommandASTDeleteNode& operator=(CommandASTDeleteNode&&) = default;
 
-		CommandASTDeleteNode(std::unique_ptr<CommandASTExpressionNode>&& name) : target(std::move(target)) { }
+		CommandASTDeleteNode(std::unique_ptr<CommandASTExpressionNode>&& target) : target(std::move(target)) { }
 
 		static auto make(std::unique_ptr<CommandASTExpressionNode>&& target) -> CommandASTDeleteNode {
 			return CommandASTDeleteNode{ std::move(target) };
@@ -438,16 +451,31 @@ namespace arx
 				CommandASTAccessingNode
 			>&& value) : type(type), value(std::move(value)) { }
 
+		CommandSourcePosition position;
+
+		/// <summary>
+		/// Sets where the node is in its source, as in `make_number(value).at(token.position)`.
+		/// </summary>
+		auto at(CommandSourcePosition position) && -> CommandASTExpressionNode&& {
+			this->position = position;
+			return std::move(*this);
+		}
+
 		static auto make_empty() -> CommandASTExpressionNode {
 			return CommandASTExpressionNode { CommandASTExpressionNode::Type::Empty,
 				CommandASTNoneNode{ }
 			};
 		}
-		static auto make_number(float value) -> CommandASTExpressionNode {
+		static auto make_number(double value) -> CommandASTExpressionNode {
 			return CommandASTExpressionNode{ CommandASTExpressionNode::Type::Number,
 				CommandASTNumberNode{ value }
 			};
 		}
+		static auto make_integer(int64_t value) -> CommandASTExpressionNode {
+			return CommandASTExpressionNode{ CommandASTExpressionNode::Type::Number,
+				CommandASTNumberNode::make_integer(value)
+			};
+		}
 		static auto make_string(const std::string& value) -> CommandASTExpressionNode {
 			return CommandASTExpressionNode{ CommandASTExpressionNode::Type::String,
 				CommandASTStringNode{ value }
@@ -530,7 +558,7 @@ namespace arx
 		}
 
 		auto clone() const -> CommandASTExpressionNode {
-			return CommandASTExpressionNode{ type, std::visit( [](auto& v) -> decltype(value) { return v.clone(); }, value) };
+			return CommandASTExpressionNode{ type, std::visit( [](auto& v) -> decltype(value) { return v.clone(); }, value) }.at(position);
 		}
 	}; 
 	// ExpressionNode complete.
@@ -600,7 +628,7 @@ namespace arx
 				CommandASTExpressionNode { CommandASTExpressionNode::Type::Empty, { } }
 			};
 		}
-		static auto make_number(float value) -> CommandASTNode {
+		static auto make_number(double value) -> CommandASTNode {
 			return CommandASTNode{ CommandASTNode::Type::Expression,
 				CommandASTExpressionNode{ CommandASTExpressionNode::Type::Number,
 					CommandASTNumberNode{ value }
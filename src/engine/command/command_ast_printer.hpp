@@ -34,7 +34,12 @@ namespace arx
 			case arx::CommandASTExpressionNode::Type::Number:
 			{
 				print_indent(indent + 1);
-				std::cout << "value = " << std::get<CommandASTNumberNode>(expression.value).value << std::endl;
+				if (auto& number = std::get<CommandASTNumberNode>(expression.value); number.integral) {
+					std::cout << "value = " << number.integer << std::endl;
+				}
+				else {
+					std::cout << "value = " << number.value << std::endl;
+				}
 				break;
 			}
 			case arx::CommandASTExpressionNode::Type::String:
@@ -94,10 +99,10 @@ namespace arx
 			case arx::CommandASTExpressionNode::Type::FunctionBody:
 			{
 				auto& function_body = std::get<CommandASTFunctionBodyNode>(expression.value);
-				for (size_t i = 0; i < function_body.commands.size(); ++i) {
+				for (size_t i = 0; i < function_body.commands->size(); ++i) {
 					print_indent(indent + 1);
 					std::cout << std::format("statement_{} = ", i);
-					print_statement(function_body.commands[i], indent + 1);
+					print_statement((*function_body.commands)[i], indent + 1);
 				}
 				break;
 			}
@@ -211,26 +216,38 @@ namespace arx
 		}
 
 		auto run() -> void {
+			std::string line;
 			while (true) {
-				std::string line;
 				std::getline(input, line);
-				run_code(line);
+				line += '\n';
+				stream(line, false);
 				if (input.eof()) {
 					break;
 				}
 			}
+			stream({ }, true);
+		}
+
+		auto run_code(std::string_view code) -> void {
+			lexer.reader.restart();
+			stream(code, true);
 		}
 
-		auto run_code(const std::string& code) -> void {
-			try {
-				lexer << code;
-			}
-			catch (const CommandException& exception) {
-				error << exception.what() << std::endl;
-				parser.awaiting_expression = CommandASTExpressionNode::make_empty();
-				while (parser.processing_nodes.size() > 1) {
-					parser.processing_nodes.pop();
+	private:
+		auto stream(std::string_view text, bool finishing) -> void {
+			lexer.reader.feed(text);
+			while (true) {
+				try {
+					lexer.read(finishing);
+					break;
 				}
+				catch (const CommandException& exception) {
+					error << exception.what() << std::endl;
+					parser.recover();
+				}
+			}
+			if (finishing) {
+				lexer.reader.clear();
 			}
 		}
 	};
@@ -0,0 +1,343 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// The numbers of a list taken by a bound function: a view of a packed list's array,
+	/// or of the values of a list which isn't packed, which are only copied out as floats if `floats` is called.
+	/// </summary>
+	struct CommandNumbers
+	{
+		std::span<const float> packed;
+		std::span<const CommandValue> values; // empty for a packed list.
+
+		CommandNumbers(const CommandValue& list) {
+			if (list.is_packed()) {
+				packed = list.as_numbers();
+				return;
+			}
+			values = list.as_list();
+		}
+		CommandNumbers(CommandValue::Arguments values) : values{ values } { }
+		CommandNumbers(const CommandNumbers&) = delete;
+		CommandNumbers(CommandNumbers&&) = default;
+
+		auto is_packed() const -> bool {
+			return values.empty();
+		}
+
+		auto size() const -> size_t {
+			return is_packed() ? packed.size() : values.size();
+		}
+
+		auto number(size_t index) const -> double {
+			return is_packed() ? packed[index] : values[index].as_number();
+		}
+
+		// The numbers as a float array, for functions making packed lists.
+		auto floats() const -> std::span<const float> {
+			if (is_packed()) {
+				return packed;
+			}
+			if (storage.size() != values.size()) {
+				storage.reserve(values.size());
+				for (auto& value : values) {
+					storage.push_back(static_cast<float>(value.as_number()));
+				}
+			}
+			return storage;
+		}
+
+	private:
+		mutable std::vector<float> storage;
+	};
+
+	/// <summary>
+	/// How a C++ parameter of a bound function is taken from a `CommandValue`:
+	/// whether an argument is accepted, what is expected otherwise, and the conversion of an accepted argument.
+	/// </summary>
+	template<typename T, typename = void>
+	struct CommandBindingParameter;
+
+	template<typename T>
+	struct CommandBindingParameter<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+	{
+		static constexpr std::string_view expected = "a number";
+		static auto accepts(const CommandValue& value) -> bool {
+			return value.type == CommandValue::Type::Number;
+		}
+		static auto from(const CommandValue& value) -> T {
+			if constexpr (std::is_integral_v<T>) {
+				return value.integral ? static_cast<T>(value.integer) : static_cast<T>(value.number);
+			}
+			else {
+				return static_cast<T>(value.as_number());
+			}
+		}
+	};
+
+	template<>
+	struct CommandBindingParameter<std::string>
+	{
+		static constexpr std::string_view expected = "a string";
+		static auto accepts(const CommandValue& value) -> bool {
+			return value.type == CommandValue::Type::String;
+		}
+		static auto from(const CommandValue& value) -> const std::string& {
+			return value.as_string();
+		}
+	};
+
+	template<>
+	struct CommandBindingParameter<std::string_view>
+	{
+		static constexpr std::string_view expected = "a string";
+		static auto accepts(const CommandValue& value) -> bool {
+			return value.type == CommandValue::Type::String;
+		}
+		static auto from(const CommandValue& value) -> std::string_view {
+			return value.as_string();
+		}
+	};
+
+	template<>
+	struct CommandBindingParameter<CommandValue::List>
+	{
+		static constexpr std::string_view expected = "a list";
+		static auto accepts(const CommandValue& value) -> bool {
+			return value.type == CommandValue::Type::List;
+		}
+		static auto from(const CommandValue& value) -> const CommandValue::List& {
+			return value.as_list();
+		}
+	};
+
+	template<>
+	struct CommandBindingParameter<CommandNumbers>
+	{
+		static constexpr std::string_view expected = "a list of numbers";
+		static auto accepts(const CommandValue& value) -> bool {
+			if (value.type != CommandValue::Type::List) {
+				return false;
+			}
+			return value.is_packed() || std::all_of(value.as_list().begin(), value.as_list().end(), [](const CommandValue& element) {
+				return element.type == CommandValue::Type::Number;
+			});
+		}
+		static auto from(const CommandValue& value) -> CommandNumbers {
+			return CommandNumbers{ value };
+		}
+	};
+
+	template<>
+	struct CommandBindingParameter<CommandValue>
+	{
+		static constexpr std::string_view expected = "a value";
+		static auto accepts(const CommandValue&) -> bool {
+			return true;
+		}
+		static auto from(const CommandValue& value) -> const CommandValue& {
+			return value;
+		}
+	};
+
+	/// <summary>
+	/// The value a bound function's C++ result becomes: numbers, integral ones as integers, strings and lists as themselves, `bool` as `()` or `(-)`, `void` as `()`,
+	/// and a `std::vector<float>` as a packed list.
+	/// </summary>
+	template<typename T>
+	auto to_command_value(T&& value) -> CommandValue {
+		using Type = std::remove_cvref_t<T>;
+		if constexpr (std::is_same_v<Type, bool>) {
+			return CommandValue{ CommandValue::Type::Empty, value };
+		}
+		else if constexpr (std::is_integral_v<Type>) {
+			return CommandValue::from_integer(static_cast<int64_t>(value));
+		}
+		else if constexpr (std::is_arithmetic_v<Type>) {
+			return CommandValue{ CommandValue::Type::Number, static_cast<double>(value) };
+		}
+		else if constexpr (std::is_same_v<Type, CommandValue>) {
+			return std::forward<T>(value);
+		}
+		else if constexpr (std::is_same_v<Type, std::vector<float>>) {
+			return CommandValue::packed(std::forward<T>(value));
+		}
+		else if constexpr (std::is_same_v<Type, CommandValue::List>) {
+			return CommandValue{ CommandValue::Type::List, CommandValue::List{ std::forward<T>(value) } };
+		}
+		else {
+			return CommandValue{ CommandValue::Type::String, std::string{ std::forward<T>(value) } };
+		}
+	}
+
+	/// <summary>
+	/// The result and parameter types of a lambda, a function object or a function pointer.
+	/// </summary>
+	template<typename F>
+	struct CommandSignature : CommandSignature<decltype(&F::operator())> { };
+
+	template<typename R, typename... P>
+	struct CommandSignature<R(*)(P...)>
+	{
+		using Result = R;
+		using Parameters = std::tuple<std::remove_cvref_t<P>...>;
+		static constexpr size_t arity = sizeof...(P);
+	};
+
+	template<typename C, typename R, typename... P>
+	struct CommandSignature<R(C::*)(P...)> : CommandSignature<R(*)(P...)> { };
+
+	template<typename C, typename R, typename... P>
+	struct CommandSignature<R(C::*)(P...) const> : CommandSignature<R(*)(P...)> { };
+
+	/// <summary>
+	/// A builtin made of typed C++ overloads, picked by the number of arguments, then by their types if several take as many,
+	/// `f()` calling the overload without parameters if there's one.
+	/// The checks and conversions of every overload are generated from its signature, and `call` is the thunk
+	/// the kernel and the machine jump to directly, instead of going through `CommandValue::Function`.
+	/// It must not call back into the runtime, since it's called without a scope of its own.
+	/// A single overload taking only `CommandNumbers` is variadic, it takes all the arguments, which must be numbers, or none with `()`,
+	/// and a packed list passed as the arguments is viewed rather than unpacked.
+	/// </summary>
+	template<typename... F>
+	struct CommandNativeFunction
+	{
+		std::string name;
+		std::tuple<F...> overloads;
+
+		auto operator()(CommandValue::Arguments arguments, CommandValue* result) const -> uint32_t {
+			if constexpr (variadic) {
+				if (arguments.size() == 1 && arguments[0].type == CommandValue::Type::Empty && arguments[0].as_boolean()) { // `f()`.
+					return apply_numbers(CommandNumbers{ CommandValue::Arguments{ } }, result);
+				}
+				if (!std::all_of(arguments.begin(), arguments.end(), [](const CommandValue& value) { return value.type == CommandValue::Type::Number; })) {
+					throw CommandException("`{}` takes numbers as arguments", name);
+				}
+				return apply_numbers(CommandNumbers{ arguments }, result);
+			}
+			else {
+				if constexpr (nullary) {
+					if (arguments.size() == 1 && arguments[0].type == CommandValue::Type::Empty && arguments[0].as_boolean()) { // `f()`.
+						return dispatch<0>(CommandValue::Arguments{ }, result);
+					}
+				}
+				return dispatch<0>(arguments, result);
+			}
+		}
+
+		static auto call(const void* target, const CommandValue& argument, CommandValue* result) -> uint32_t {
+			auto& self = *static_cast<const CommandNativeFunction*>(target);
+			if constexpr (variadic) {
+				if (argument.type == CommandValue::Type::List) {
+					if (!CommandBindingParameter<CommandNumbers>::accepts(argument)) {
+						throw CommandException("`{}` takes numbers as arguments", self.name);
+					}
+					return self.apply_numbers(CommandNumbers{ argument }, result);
+				}
+				return self(argument.as_arguments(), result);
+			}
+			else {
+				return self(argument.as_arguments(), result);
+			}
+		}
+
+	private:
+		static constexpr bool variadic = (sizeof...(F) == 1) && (std::is_same_v<typename CommandSignature<F>::Parameters, std::tuple<CommandNumbers>> && ...);
+		static constexpr bool nullary = ((CommandSignature<F>::arity == 0) || ...); // `f()` is then the call without arguments, rather than with `()`.
+
+		auto apply_numbers(CommandNumbers&& numbers, CommandValue* result) const -> uint32_t {
+			auto value = std::get<0>(overloads)(std::move(numbers));
+			if (result != nullptr) {
+				*result = to_command_value(std::move(value));
+			}
+			return 0;
+		}
+
+		template<size_t I>
+		auto dispatch(CommandValue::Arguments arguments, CommandValue* result) const -> uint32_t {
+			if constexpr (I == sizeof...(F)) {
+				throw CommandException("`{}` takes {}", name, arity_text());
+			}
+			else {
+				using Signature = CommandSignature<std::tuple_element_t<I, std::tuple<F...>>>;
+				if (arguments.size() != Signature::arity) {
+					return dispatch<I + 1>(arguments, result);
+				}
+				if constexpr (taken_later<I + 1>(Signature::arity)) {
+					if (!accepts<Signature>(arguments, std::make_index_sequence<Signature::arity>{ })) {
+						return dispatch<I + 1>(arguments, result);
+					}
+				}
+				return apply<I, Signature>(arguments, result, std::make_index_sequence<Signature::arity>{ });
+			}
+		}
+
+		// Whether an overload from the `I`th on takes `arity` arguments.
+		template<size_t I>
+		static constexpr auto taken_later(size_t arity) -> bool {
+			if constexpr (I == sizeof...(F)) {
+				return false;
+			}
+			else {
+				return CommandSignature<std::tuple_element_t<I, std::tuple<F...>>>::arity == arity || taken_later<I + 1>(arity);
+			}
+		}
+
+		template<typename Signature, size_t... J>
+		static auto accepts(CommandValue::Arguments arguments, std::index_sequence<J...>) -> bool {
+			return (CommandBindingParameter<std::tuple_element_t<J, typename Signature::Parameters>>::accepts(arguments[J]) && ...);
+		}
+
+		template<size_t I, typename Signature, size_t... J>
+		auto apply(CommandValue::Arguments arguments, CommandValue* result, std::index_sequence<J...>) const -> uint32_t {
+			(check<std::tuple_element_t<J, typename Signature::Parameters>>(arguments[J], J, Signature::arity), ...);
+			auto& overload = std::get<I>(overloads);
+			if constexpr (std::is_void_v<typename Signature::Result>) {
+				overload(CommandBindingParameter<std::tuple_element_t<J, typename Signature::Parameters>>::from(arguments[J])...);
+				if (result != nullptr) {
+					*result = CommandValue{ CommandValue::Type::Empty, true };
+				}
+			}
+			else {
+				auto value = overload(CommandBindingParameter<std::tuple_element_t<J, typename Signature::Parameters>>::from(arguments[J])...);
+				if (result != nullptr) {
+					*result = to_command_value(std::move(value));
+				}
+			}
+			return 0;
+		}
+
+		template<typename P>
+		auto check(const CommandValue& argument, size_t index, size_t arity) const -> void {
+			if (!CommandBindingParameter<P>::accepts(argument)) {
+				if (arity == 1) {
+					throw CommandException("`{}` takes {} as argument", name, CommandBindingParameter<P>::expected);
+				}
+				throw CommandException("`{}` takes {} as {} argument", name, CommandBindingParameter<P>::expected, ordinal_text(index));
+			}
+		}
+
+		static auto ordinal_text(size_t index) -> std::string {
+			constexpr std::string_view ordinals[] = { "first", "second", "third", "fourth", "fifth", "sixth", "seventh", "eighth" };
+			return index < std::size(ordinals) ? std::string{ ordinals[index] } : std::format("{}th", index + 1);
+		}
+
+		// e.g. "exactly one argument", "one or two arguments".
+		auto arity_text() const -> std::string {
+			constexpr std::string_view numbers[] = { "no", "one", "two", "three", "four", "five", "six", "seven", "eight" };
+			std::vector<size_t> arities{ CommandSignature<F>::arity... };
+			std::sort(arities.begin(), arities.end());
+			arities.erase(std::unique(arities.begin(), arities.end()), arities.end());
+
+			std::string text = (arities.size() == 1 && arities[0] != 0) ? "exactly " : "";
+			for (size_t i = 0; i < arities.size(); ++i) {
+				if (i != 0) {
+					text += i + 1 == arities.size() ? " or " : ", ";
+				}
+				text += arities[i] < std::size(numbers) ? std::string{ numbers[arities[i]] } : std::to_string(arities[i]);
+			}
+			return text + (arities.back() == 1 ? " argument" : " arguments");
+		}
+	};
+}
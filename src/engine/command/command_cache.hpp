@@ -0,0 +1,145 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// A piece of code parsed once: its top level statements and the errors met parsing them, in source order,
+	/// so running it again reports the same errors without lexing or parsing.
+	/// </summary>
+	struct CommandScript
+	{
+		struct Step
+		{
+			std::optional<CommandASTStatementNode> statement;
+			std::shared_ptr<const CommandChunk> chunk; // compiled from `statement` the first time it's excuted by the machine.
+			std::string error;
+		};
+		std::vector<Step> steps;
+	};
+
+	/// <summary>
+	/// Interpreter of a parser which collects the statements into a `CommandScript` instead of excuting them.
+	/// </summary>
+	struct CommandScriptBuilder
+	{
+		CommandScript* script = nullptr;
+
+		auto operator<<(CommandASTStatementNode&& statement) -> CommandScriptBuilder& {
+			script->steps.push_back({ std::move(statement), nullptr, { } });
+			return *this;
+		}
+
+		auto error(const CommandException& exception) -> void {
+			script->steps.push_back({ std::nullopt, nullptr, exception.what() });
+		}
+	};
+
+	/// <summary>
+	/// Parses whole pieces of code into scripts, recovering from errors at statement boundaries.
+	/// </summary>
+	struct CommandScriptParser
+	{
+		CommandScriptBuilder builder;
+		CommandParser<CommandScriptBuilder> parser{ builder };
+		CommandLexer<CommandScriptBuilder> lexer{ parser };
+
+		CommandScriptParser() = default;
+		CommandScriptParser(const CommandScriptParser&) = delete; // `parser` and `lexer` refer to the members before them.
+
+		auto parse(std::string_view code) -> std::shared_ptr<CommandScript> {
+			auto script = std::make_shared<CommandScript>();
+			builder.script = script.get();
+			lexer.reader.restart();
+			lexer.reader.feed(code);
+			while (true) {
+				try {
+					lexer.read(true);
+					break;
+				}
+				catch (const CommandException& exception) {
+					builder.error(exception);
+					parser.recover();
+				}
+			}
+			if (!parser.complete()) {
+				builder.error(CommandException{ "The last statement is not complete." });
+			}
+			parser.reset();
+			lexer.reader.clear();
+			builder.script = nullptr;
+			return script;
+		}
+	};
+
+	/// <summary>
+	/// Least recently used scripts, looked up by the hash of their source.
+	/// </summary>
+	struct CommandScriptCache
+	{
+		CommandScriptCache(size_t capacity) : capacity{ capacity } {
+		}
+
+		/// <summary>
+		/// The cached script of `source`, or `nullptr` after which the caller builds it and `insert`s it.
+		/// </summary>
+		auto find(std::string_view source) -> std::shared_ptr<CommandScript> {
+			auto found = index.find(std::hash<std::string_view>{ }(source));
+			if (found == index.end() || found->second->source != source) {
+				++miss_count;
+				return nullptr;
+			}
+			++hit_count;
+			entries.splice(entries.begin(), entries, found->second);
+			return found->second->script;
+		}
+
+		auto insert(std::string_view source, std::shared_ptr<CommandScript> script) -> void {
+			if (capacity == 0) {
+				return;
+			}
+			auto hash = std::hash<std::string_view>{ }(source);
+			auto found = index.find(hash);
+			if (found != index.end()) { // a colliding source, which is replaced.
+				entries.erase(found->second);
+				index.erase(found);
+			}
+			else if (entries.size() == capacity) {
+				index.erase(entries.back().hash);
+				entries.pop_back();
+			}
+			entries.push_front({ hash, std::string{ source }, std::move(script) });
+			index.emplace(hash, entries.begin());
+		}
+
+		auto clear() -> void {
+			entries.clear();
+			index.clear();
+		}
+
+		auto hits() const -> uint64_t {
+			return hit_count;
+		}
+
+		auto misses() const -> uint64_t {
+			return miss_count;
+		}
+
+		auto size() const -> size_t {
+			return entries.size();
+		}
+
+		size_t capacity;
+
+	private:
+		struct Entry
+		{
+			size_t hash;
+			std::string source;
+			std::shared_ptr<CommandScript> script; // shared, so a script excuting while it's evicted stays alive.
+		};
+		std::list<Entry> entries; // the most recently used first.
+		std::unordered_map<size_t, std::list<Entry>::iterator> index;
+		uint64_t hit_count = 0;
+		uint64_t miss_count = 0;
+	};
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Frees the lists which only keep each other alive, like a list assigned into itself, which reference counting alone never frees.
+	/// A list can only come to refer to itself, directly or not, by being modified in place, so only the lists the kernel modifies are `track`ed.
+	/// The collector holds every tracked list, so freeing a list costs nothing more than without it;
+	/// the tracked lists nothing else holds anymore are freed by the next `sweep`, which `track` runs as they double.
+	/// `collect` subtracts the references which the lists reachable from the tracked ones hold on each other from their counts:
+	/// a list whose count stays above zero is referred to from outside, and so is every list it reaches, the others are garbage.
+	/// It must only be called where nothing refers into a list without holding a reference to it, that is between statements.
+	/// Lists are tracked and collected by the thread excuting scripts only.
+	/// </summary>
+	struct CommandCollector
+	{
+		using ListObject = CommandValue::ListObject;
+
+		static constexpr size_t minimum_threshold = 1024;
+
+		CommandCollector() = default;
+		CommandCollector(const CommandCollector&) = delete;
+
+		~CommandCollector() {
+			for (auto& list : tracked) {
+				list.list_object->tracked = false;
+			}
+		}
+
+		/// <summary>
+		/// Tracks a list which is being modified in place.
+		/// </summary>
+		auto track(const CommandValue& list) -> void {
+			if (list.list_object->tracked) {
+				return;
+			}
+			if (tracked.size() >= threshold) {
+				sweep();
+			}
+			list.list_object->tracked = true;
+			tracked.push_back(list);
+		}
+
+		auto size() const -> size_t {
+			return tracked.size();
+		}
+
+		/// <summary>
+		/// Frees the tracked lists nothing else holds anymore. Unlike `collect`, it's safe anywhere.
+		/// </summary>
+		auto sweep() -> void {
+			std::erase_if(tracked, [](CommandValue& list) {
+				if (list.list_object->references.load(std::memory_order_acquire) != 1) {
+					return false;
+				}
+				list.list_object->tracked = false;
+				return true;
+			});
+			threshold = std::max(minimum_threshold, tracked.size() * 2);
+		}
+
+		/// <summary>
+		/// Collects once the tracked lists have doubled since the last collection, so tracking many lists which are alive costs amortized constant time.
+		/// </summary>
+		auto maybe_collect() -> size_t {
+			return tracked.size() < threshold ? 0 : collect();
+		}
+
+		/// <summary>
+		/// Frees the garbage cycles among the tracked lists, along with the tracked lists nothing else holds, and returns how many lists were freed.
+		/// </summary>
+		auto collect() -> size_t {
+			// The references left to every list once those of the lists of the graph and of the collector are subtracted.
+			std::unordered_map<ListObject*, int64_t> counts;
+			std::vector<ListObject*> graph;
+			for (auto& list : tracked) {
+				counts.try_emplace(list.list_object, -1);
+				graph.push_back(list.list_object);
+			}
+			for (size_t i = 0; i < graph.size(); ++i) {
+				auto object = graph[i];
+				if (object->packed) {
+					continue;
+				}
+				for (auto& element : object->elements) {
+					if (element.type == CommandValue::Type::List && counts.try_emplace(element.list_object, 0).second) {
+						graph.push_back(element.list_object);
+					}
+				}
+			}
+			for (auto object : graph) {
+				counts[object] += object->references.load(std::memory_order_acquire);
+			}
+			for (auto object : graph) {
+				if (object->packed) {
+					continue;
+				}
+				for (auto& element : object->elements) {
+					if (element.type == CommandValue::Type::List) {
+						--counts[element.list_object];
+					}
+				}
+			}
+
+			// Whatever a list referred to from outside reaches is alive too, marked by a count of -1.
+			std::vector<ListObject*> alive;
+			for (auto object : graph) {
+				if (counts[object] > 0) {
+					alive.push_back(object);
+				}
+			}
+			while (!alive.empty()) {
+				auto object = alive.back();
+				alive.pop_back();
+				counts[object] = -1;
+				if (object->packed) {
+					continue;
+				}
+				for (auto& element : object->elements) {
+					if (element.type == CommandValue::Type::List && counts[element.list_object] == 0) {
+						counts[element.list_object] = -1;
+						alive.push_back(element.list_object);
+					}
+				}
+			}
+
+			// The elements of the garbage are moved out before anything is released, so a list is freed once its last reference,
+			// held by the elements moved out or by the collector, is released, and it's empty by then.
+			std::vector<CommandValue::List> dropped;
+			for (auto object : graph) {
+				if (counts[object] == 0) {
+					dropped.push_back(std::move(object->elements));
+					object->elements.clear();
+				}
+			}
+			auto freed = dropped.size();
+			std::erase_if(tracked, [&](CommandValue& list) {
+				if (counts[list.list_object] != 0) {
+					return false;
+				}
+				list.list_object->tracked = false;
+				return true;
+			});
+			dropped.clear();
+			threshold = std::max(minimum_threshold, tracked.size() * 2);
+			return freed;
+		}
+
+	private:
+		std::vector<CommandValue> tracked; // held, which `as_list_mut` doesn't count as sharing them.
+		size_t threshold = minimum_threshold;
+	};
+}
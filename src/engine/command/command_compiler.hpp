@@ -0,0 +1,761 @@
+#pragma once
+
+namespace arx
+{
+	struct CommandInstruction
+	{
+		enum class Code : uint8_t
+		{
+			Empty,			// a = dst, b = positive.
+			Number,			// a = dst, b = number constant.
+			Integer,		// a = dst, b = integer constant.
+			String,			// a = dst, b = string constant.
+			Identifier,		// a = dst, b = symbol.
+
+			Positive,		// a = dst, b = operand.
+			Negative,
+			Not,
+			Add,			// a = dst, b = left operand, c = right operand.
+			Subtract,
+			Multiply,
+			Divide,
+			Modulo,
+			Exponent,
+			Equal,
+			NotEqual,
+			LessThan,
+			LessThanOrEqual,
+			GreaterThan,
+			GreaterThanOrEqual,
+
+			List,			// a = dst, b = first element register, c = element count.
+			Call,			// a = dst, b = callable, c = argument.
+			TailCall,		// as `Call`, followed by the `Return` of its result. Replaces the running body with the callee when possible.
+			Function,		// a = dst, b = chunk constant.
+			Jump,			// a = target.
+			JumpIfNegative,	// a = condition, b = target.
+
+			Argument,		// a = dst, b = length.
+			Return,			// a = value, b = length.
+			Self,			// a = dst, b = length.
+			Loop,			// a = argument, b = length, c = has argument.
+			Access,			// a = dst, b = accessed value.
+			Protect,		// a = dst, b = name, c = whether the name is a register holding a string rather than a symbol.
+			Delete,			// a = dst, b = name, c = as above.
+
+			ReferIdentifier,	// a = reference, b = symbol.
+			ReferLocal,			// a = reference, b = name, c = as above.
+			ReferProtection,	// a = reference, b = name, c = as above.
+			ReferIndex,			// a = reference, b = list reference, c = index register.
+			ReferAccess,		// a = reference, b = accessed value.
+			Guard,				// a = reference. Throws if the reference is protected.
+			Load,				// a = dst, b = reference.
+			Store,				// a = dst, b = reference, c = value.
+
+			Throw,			// a = string constant of the message.
+		};
+
+		/// <summary>
+		/// Set on instructions which may return from bodies but are compiled inside an assignable or identifier,
+		/// where returning is an error rather than a control flow.
+		/// </summary>
+		static constexpr uint8_t guarded = 1;
+		/// <summary>
+		/// Set on stores whose result is the value of a statement, which nobody reads.
+		/// </summary>
+		static constexpr uint8_t discarded = 2;
+
+		Code code;
+		uint8_t flags = 0;
+		uint32_t a = 0;
+		uint32_t b = 0;
+		uint32_t c = 0;
+
+		/// <summary>
+		/// The operand holding a symbol of the kernel it's compiled for, if any, which must be mapped to move the instruction to another kernel.
+		/// </summary>
+		auto symbol_operand() -> uint32_t* {
+			switch (code) {
+			case Code::Identifier:
+			case Code::ReferIdentifier:
+				return &b;
+			case Code::Protect:
+			case Code::Delete:
+			case Code::ReferLocal:
+			case Code::ReferProtection:
+				return c == 0 ? &b : nullptr;
+			default:
+				return nullptr;
+			}
+		}
+	};
+
+	struct CommandChunk
+	{
+		std::vector<CommandInstruction> instructions;
+		std::vector<CommandSourcePosition> positions; // of the node each instruction is compiled from, to locate errors.
+		std::vector<double> numbers;
+		std::vector<int64_t> integers;
+		std::vector<std::string> strings;
+		std::vector<std::shared_ptr<const CommandChunk>> chunks;
+		CommandSourcePosition position; // of the function body it's compiled from.
+		std::shared_ptr<const std::vector<CommandASTStatementNode>> body; // the statements it's compiled from, kept as functions of the tree walker keep theirs, which the profiler names it after.
+		uint32_t register_count = 0;
+		uint32_t reference_count = 0;
+		bool reaches_outer = false; // refers to bodies other than its own (`>>`, `<<`, `$$`, `%%`), so it can't replace its caller.
+	};
+
+	/// <summary>
+	/// Lowers statements into chunks of register based bytecode, see `CommandMachine` for how they are excuted.
+	/// Every function body is compiled into its own chunk once, together with the statement it appears in.
+	/// </summary>
+	struct CommandCompiler
+	{
+		/// <summary>
+		/// Raised whenever the instructions or the layout of chunks change, so chunks saved by an earlier version are compiled again.
+		/// </summary>
+		static constexpr uint32_t version = 4;
+
+		CommandSymbols& symbols;
+
+		CommandCompiler(CommandSymbols& symbols) : symbols{ symbols } {
+		}
+
+		auto compile(const CommandASTStatementNode& statement) -> std::shared_ptr<const CommandChunk> {
+			auto state = begin_chunk();
+			compile_statement(statement);
+			return end_chunk(state);
+		}
+
+		auto compile(const CommandASTFunctionBodyNode& body, CommandSourcePosition position = { }) -> std::shared_ptr<const CommandChunk> {
+			auto state = begin_chunk();
+			this->state.body = true;
+			this->state.chunk->position = position;
+			this->state.chunk->body = body.commands;
+			for (auto& statement : *body.commands) {
+				compile_statement(statement);
+			}
+			return end_chunk(state);
+		}
+
+	private: // chunk states.
+		struct State
+		{
+			std::shared_ptr<CommandChunk> chunk;
+			std::unordered_map<std::string, uint32_t> strings{ };
+			uint32_t top = 0;
+			uint32_t reference_top = 0;
+			uint32_t discard = std::numeric_limits<uint32_t>::max();
+			bool guarded = false;
+			bool body = false;
+			CommandSourcePosition position{ };
+		};
+		State state;
+
+		auto begin_chunk() -> State {
+			auto outer = std::move(state);
+			state = State{ std::make_shared<CommandChunk>() };
+			return outer;
+		}
+
+		auto end_chunk(State& outer) -> std::shared_ptr<const CommandChunk> {
+			auto chunk = std::move(state.chunk);
+			state = std::move(outer);
+			return chunk;
+		}
+
+		auto allocate() -> uint32_t {
+			auto index = state.top++;
+			state.chunk->register_count = std::max(state.chunk->register_count, state.top);
+			return index;
+		}
+
+		auto allocate_reference() -> uint32_t {
+			auto index = state.reference_top++;
+			state.chunk->reference_count = std::max(state.chunk->reference_count, state.reference_top);
+			return index;
+		}
+
+		auto emit(CommandInstruction::Code code, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) -> size_t {
+			uint8_t flags = state.guarded ? CommandInstruction::guarded : 0;
+			if (code == CommandInstruction::Code::Store && a == state.discard) {
+				flags |= CommandInstruction::discarded;
+			}
+			switch (code) {
+			case CommandInstruction::Code::Argument:
+			case CommandInstruction::Code::Return:
+			case CommandInstruction::Code::Self:
+			case CommandInstruction::Code::Loop: {
+				state.chunk->reaches_outer |= (b > 1);
+				break;
+			}
+			default:
+				break;
+			}
+			state.chunk->instructions.push_back({ code, flags, a, b, c });
+			state.chunk->positions.push_back(state.position);
+			return state.chunk->instructions.size() - 1;
+		}
+
+		auto here() const -> uint32_t {
+			return static_cast<uint32_t>(state.chunk->instructions.size());
+		}
+
+		auto add_number(double value) -> uint32_t {
+			state.chunk->numbers.push_back(value);
+			return static_cast<uint32_t>(state.chunk->numbers.size() - 1);
+		}
+
+		auto add_integer(int64_t value) -> uint32_t {
+			state.chunk->integers.push_back(value);
+			return static_cast<uint32_t>(state.chunk->integers.size() - 1);
+		}
+
+		auto add_string(const std::string& value) -> uint32_t {
+			auto [it, inserted] = state.strings.try_emplace(value, static_cast<uint32_t>(state.chunk->strings.size()));
+			if (inserted) {
+				state.chunk->strings.push_back(value);
+			}
+			return it->second;
+		}
+
+		auto emit_throw(const std::string& message) -> void {
+			emit(CommandInstruction::Code::Throw, add_string(message));
+		}
+
+		// Registers and references are allocated like a stack, everything allocated while compiling a node is released after it.
+		struct Scoped
+		{
+			State& state;
+			uint32_t top;
+			uint32_t reference_top;
+			bool guarded;
+			CommandSourcePosition position;
+			Scoped(State& state) : state{ state }, top{ state.top }, reference_top{ state.reference_top }, guarded{ state.guarded }, position{ state.position } { }
+			~Scoped() {
+				state.top = top;
+				state.reference_top = reference_top;
+				state.guarded = guarded;
+				state.position = position;
+			}
+		};
+
+	private: // compile statements.
+		auto compile_statement(const CommandASTStatementNode& statement) -> void {
+			switch (statement.type) {
+			case CommandASTStatementNode::Type::Empty: {
+				break;
+			}
+			case CommandASTStatementNode::Type::Expression: {
+				Scoped scoped{ state };
+				state.discard = allocate();
+				compile_expression(std::get<CommandASTExpressionNode>(statement.value), state.discard);
+				break;
+			}
+			default: {
+				throw CommandException("Unknown statement type.");
+			}
+			}
+		}
+
+	private: // compile expressions.
+		auto compile_expression(const std::unique_ptr<CommandASTExpressionNode>& expression, uint32_t dst) -> void {
+			if (expression == nullptr) {
+				emit(CommandInstruction::Code::Empty, dst, 1);
+			}
+			else {
+				compile_expression(*expression, dst);
+			}
+		}
+
+		auto compile_expression(const CommandASTExpressionNode& expression, uint32_t dst) -> void {
+			Scoped scoped{ state };
+			if (expression.position.known()) {
+				state.position = expression.position;
+			}
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Empty: {
+				emit(CommandInstruction::Code::Empty, dst, 1);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Number: {
+				auto& number = std::get<CommandASTNumberNode>(expression.value);
+				if (number.integral) {
+					emit(CommandInstruction::Code::Integer, dst, add_integer(number.integer));
+				}
+				else {
+					emit(CommandInstruction::Code::Number, dst, add_number(number.value));
+				}
+				break;
+			}
+			case CommandASTExpressionNode::Type::String: {
+				emit(CommandInstruction::Code::String, dst, add_string(std::get<CommandASTStringNode>(expression.value).value));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Identifier: {
+				emit(CommandInstruction::Code::Identifier, dst, symbols.intern(std::get<CommandASTIdentifierNode>(expression.value).name));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Operation: {
+				compile_operation(std::get<CommandASTOperationNode>(expression.value), dst);
+				break;
+			}
+			case CommandASTExpressionNode::Type::List: {
+				auto& list = std::get<CommandASTListNode>(expression.value);
+				auto first = state.top;
+				for (size_t i = 0; i < list.expressions.size(); ++i) {
+					allocate();
+				}
+				for (size_t i = 0; i < list.expressions.size(); ++i) {
+					compile_expression(list.expressions[i], first + static_cast<uint32_t>(i));
+				}
+				emit(CommandInstruction::Code::List, dst, first, static_cast<uint32_t>(list.expressions.size()));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				compile_expression(std::get<CommandASTParenthesesNode>(expression.value).expression, dst);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Calling: {
+				auto& calling = std::get<CommandASTCallingNode>(expression.value);
+				auto callable = allocate();
+				auto argument = allocate();
+				compile_expression(calling.callable, callable);
+				compile_expression(calling.argument, argument);
+				emit(CommandInstruction::Code::Call, dst, callable, argument);
+				break;
+			}
+			case CommandASTExpressionNode::Type::FunctionBody: {
+				auto body = compile(std::get<CommandASTFunctionBodyNode>(expression.value), expression.position);
+				state.chunk->chunks.push_back(std::move(body));
+				emit(CommandInstruction::Code::Function, dst, static_cast<uint32_t>(state.chunk->chunks.size() - 1));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression.value);
+				auto condition_register = allocate();
+				compile_expression(condition.condition, condition_register);
+				auto to_false = emit(CommandInstruction::Code::JumpIfNegative, condition_register);
+				if (condition.true_branch != nullptr) {
+					compile_expression(*(condition.true_branch), dst);
+				}
+				auto to_end = emit(CommandInstruction::Code::Jump);
+				state.chunk->instructions[to_false].b = here();
+				if (condition.false_branch != nullptr) {
+					compile_expression(*(condition.false_branch), dst);
+				}
+				state.chunk->instructions[to_end].a = here();
+				break;
+			}
+			case CommandASTExpressionNode::Type::Assignment: {
+				auto& assignment = std::get<CommandASTAssignmentNode>(expression.value);
+				auto reference = allocate_reference();
+				if (assignment.local) {
+					emit_named(CommandInstruction::Code::ReferLocal, reference, *(assignment.target));
+				}
+				else {
+					compile_assignable(*(assignment.target), reference);
+					emit(CommandInstruction::Code::Guard, reference);
+				}
+				if (may_write_partly(assignment.expression.get())) {
+					compile_into(*(assignment.expression), reference);
+					emit(CommandInstruction::Code::Load, dst, reference);
+					break;
+				}
+				auto value = allocate();
+				if (may_keep_value(assignment.expression.get())) {
+					// the tree walker excutes expressions right into the target, which stays untouched when nothing is written.
+					emit(CommandInstruction::Code::Load, value, reference);
+				}
+				compile_expression(assignment.expression, value);
+				emit(CommandInstruction::Code::Store, dst, reference, value);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Protection: {
+				emit_named(CommandInstruction::Code::Protect, dst, *(std::get<CommandASTProtectionNode>(expression.value).target));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Delete: {
+				emit_named(CommandInstruction::Code::Delete, dst, *(std::get<CommandASTDeleteNode>(expression.value).target));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Argument: {
+				emit(CommandInstruction::Code::Argument, dst, std::get<CommandASTArgumentNode>(expression.value).length);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Return: {
+				auto& returning = std::get<CommandASTReturnNode>(expression.value);
+				auto value = allocate();
+				if (state.body && !state.guarded && returning.length == 1 && returning.expression->type == CommandASTExpressionNode::Type::Calling) {
+					auto& calling = std::get<CommandASTCallingNode>(returning.expression->value);
+					auto callable = allocate();
+					auto argument = allocate();
+					compile_expression(calling.callable, callable);
+					compile_expression(calling.argument, argument);
+					emit(CommandInstruction::Code::TailCall, value, callable, argument);
+				}
+				else {
+					compile_expression(returning.expression, value);
+				}
+				emit(CommandInstruction::Code::Return, value, returning.length);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Self: {
+				emit(CommandInstruction::Code::Self, dst, std::get<CommandASTSelfNode>(expression.value).length);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Loop: {
+				auto& loop = std::get<CommandASTLoopNode>(expression.value);
+				if (loop.argument != nullptr) {
+					auto argument = allocate();
+					compile_expression(*(loop.argument), argument);
+					emit(CommandInstruction::Code::Loop, argument, loop.length, 1);
+				}
+				else {
+					emit(CommandInstruction::Code::Loop, 0, loop.length, 0);
+				}
+				break;
+			}
+			case CommandASTExpressionNode::Type::Accessing: {
+				auto value = allocate();
+				compile_expression(std::get<CommandASTAccessingNode>(expression.value).expression, value);
+				emit(CommandInstruction::Code::Access, dst, value);
+				break;
+			}
+			default: {
+				throw CommandException("Uncompilable expression type.");
+			}
+			}
+		}
+
+		auto compile_operation(const CommandASTOperationNode& operation, uint32_t dst) -> void {
+			auto first = state.top;
+			for (uint32_t i = 0; i < operation.operand_count; ++i) {
+				allocate();
+			}
+			for (uint32_t i = 0; i < operation.operand_count; ++i) {
+				if (i < operation.operands.size()) {
+					compile_expression(operation.operands[i], first + i);
+				}
+				else {
+					emit(CommandInstruction::Code::Empty, first + i, 1);
+				}
+			}
+			emit(to_instruction_code(operation.type), dst, first, first + 1);
+		}
+
+	private: // compile into assignables.
+		// As the tree walker excutes an assigned list: the list of `()` is stored first, then every element right into its place,
+		// so a return or a loop partway through leaves the target with the elements written before it.
+		auto compile_into(const CommandASTExpressionNode& expression, uint32_t reference) -> void {
+			Scoped scoped{ state };
+			if (expression.position.known()) {
+				state.position = expression.position;
+			}
+			if (!may_write_partly(&expression)) {
+				auto value = allocate();
+				if (may_keep_value(&expression)) {
+					emit(CommandInstruction::Code::Load, value, reference);
+				}
+				compile_expression(expression, value);
+				emit(CommandInstruction::Code::Store, value, reference, value);
+				return;
+			}
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Parentheses: {
+				compile_into(*(std::get<CommandASTParenthesesNode>(expression.value).expression), reference);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression.value);
+				auto condition_register = allocate();
+				compile_expression(condition.condition, condition_register);
+				auto to_false = emit(CommandInstruction::Code::JumpIfNegative, condition_register);
+				if (condition.true_branch != nullptr) {
+					compile_into(*(condition.true_branch), reference);
+				}
+				auto to_end = emit(CommandInstruction::Code::Jump);
+				state.chunk->instructions[to_false].b = here();
+				if (condition.false_branch != nullptr) {
+					compile_into(*(condition.false_branch), reference);
+				}
+				state.chunk->instructions[to_end].a = here();
+				break;
+			}
+			case CommandASTExpressionNode::Type::List: {
+				auto& list = std::get<CommandASTListNode>(expression.value);
+				auto value = allocate();
+				auto first = state.top;
+				for (size_t i = 0; i < list.expressions.size(); ++i) {
+					emit(CommandInstruction::Code::Empty, allocate(), 1);
+				}
+				emit(CommandInstruction::Code::List, value, first, static_cast<uint32_t>(list.expressions.size()));
+				emit(CommandInstruction::Code::Store, value, reference, value);
+				emit(CommandInstruction::Code::Empty, value, 1); // so the target's list isn't shared, and isn't copied by its first element.
+				auto index = allocate();
+				for (size_t i = 0; i < list.expressions.size(); ++i) {
+					Scoped element_scoped{ state };
+					auto element = allocate_reference();
+					emit(CommandInstruction::Code::Integer, index, add_integer(static_cast<int64_t>(i)));
+					emit(CommandInstruction::Code::ReferIndex, element, reference, index);
+					compile_into(list.expressions[i], element);
+				}
+				break;
+			}
+			default: {
+				throw CommandException("Unexpected expression written partly.");
+			}
+			}
+		}
+
+	private: // compile assignables.
+		auto compile_assignable(const CommandASTExpressionNode& expression, uint32_t reference) -> void {
+			Scoped scoped{ state };
+			state.guarded = true;
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Identifier: {
+				emit(CommandInstruction::Code::ReferIdentifier, reference, symbols.intern(std::get<CommandASTIdentifierNode>(expression.value).name));
+				break;
+			}
+			case CommandASTExpressionNode::Type::List: {
+				emit_throw("List expression is not assignable.\nFuture feature: unpacking.");
+				break;
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				compile_assignable(*(std::get<CommandASTParenthesesNode>(expression.value).expression), reference);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Calling: {
+				auto& calling = std::get<CommandASTCallingNode>(expression.value);
+				auto list = allocate_reference();
+				compile_assignable(*(calling.callable), list);
+				auto index = allocate();
+				compile_expression(calling.argument, index);
+				emit(CommandInstruction::Code::ReferIndex, reference, list, index);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression.value);
+				auto condition_register = allocate();
+				compile_expression(condition.condition, condition_register);
+				auto to_false = emit(CommandInstruction::Code::JumpIfNegative, condition_register);
+				if (condition.true_branch != nullptr) {
+					compile_assignable(*(condition.true_branch), reference);
+				}
+				else {
+					emit_throw("Empty expression is not assignable.");
+				}
+				auto to_end = emit(CommandInstruction::Code::Jump);
+				state.chunk->instructions[to_false].b = here();
+				if (condition.false_branch != nullptr) {
+					compile_assignable(*(condition.false_branch), reference);
+				}
+				else {
+					emit_throw("Empty expression is not assignable.");
+				}
+				state.chunk->instructions[to_end].a = here();
+				break;
+			}
+			case CommandASTExpressionNode::Type::Protection: {
+				emit_named(CommandInstruction::Code::ReferProtection, reference, *(std::get<CommandASTProtectionNode>(expression.value).target));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Accessing: {
+				auto value = allocate();
+				compile_expression(std::get<CommandASTAccessingNode>(expression.value).expression, value);
+				emit(CommandInstruction::Code::ReferAccess, reference, value);
+				break;
+			}
+			default: {
+				emit_throw(std::format("{} expression is not assignable", to_string(expression.type)));
+				break;
+			}
+			}
+		}
+
+	private: // compile identifiers.
+		// Emits an instruction taking a name, which is resolved to a symbol at compile time whenever it's a plain identifier.
+		auto emit_named(CommandInstruction::Code code, uint32_t a, const CommandASTExpressionNode& target) -> void {
+			auto symbol = static_symbol(target);
+			if (symbol != std::nullopt) {
+				emit(code, a, *symbol, 0);
+				return;
+			}
+			Scoped scoped{ state };
+			auto name = allocate();
+			compile_identifier(target, name);
+			emit(code, a, name, 1);
+		}
+
+		auto static_symbol(const CommandASTExpressionNode& expression) -> std::optional<uint32_t> {
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Identifier: {
+				return symbols.intern(std::get<CommandASTIdentifierNode>(expression.value).name);
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				return static_symbol(*(std::get<CommandASTParenthesesNode>(expression.value).expression));
+			}
+			default: {
+				return std::nullopt;
+			}
+			}
+		}
+
+		// An identifier is compiled into a string register holding its name.
+		auto compile_identifier(const CommandASTExpressionNode& expression, uint32_t dst) -> void {
+			Scoped scoped{ state };
+			state.guarded = true;
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Identifier: {
+				emit(CommandInstruction::Code::String, dst, add_string(std::get<CommandASTIdentifierNode>(expression.value).name));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				compile_identifier(*(std::get<CommandASTParenthesesNode>(expression.value).expression), dst);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression.value);
+				auto condition_register = allocate();
+				compile_expression(condition.condition, condition_register);
+				auto to_false = emit(CommandInstruction::Code::JumpIfNegative, condition_register);
+				if (condition.true_branch != nullptr) {
+					compile_identifier(*(condition.true_branch), dst);
+				}
+				else {
+					emit_throw("Empty expression cannot be evaluated to an identifier.");
+				}
+				auto to_end = emit(CommandInstruction::Code::Jump);
+				state.chunk->instructions[to_false].b = here();
+				if (condition.false_branch != nullptr) {
+					compile_identifier(*(condition.false_branch), dst);
+				}
+				else {
+					emit_throw("Empty expression cannot be evaluated to an identifier.");
+				}
+				state.chunk->instructions[to_end].a = here();
+				break;
+			}
+			case CommandASTExpressionNode::Type::Accessing: {
+				emit_throw("Unimplemented yet.");
+				break;
+			}
+			default: {
+				emit_throw(std::format("{} expression cannot be evaluated to an identifier.", to_string(expression.type)));
+				break;
+			}
+			}
+		}
+
+	private:
+		// Whether evaluating the expression may leave its result unwritten, which only a condition missing a branch does.
+		static auto may_keep_value(const CommandASTExpressionNode* expression) -> bool {
+			if (expression == nullptr) {
+				return false;
+			}
+			switch (expression->type) {
+			case CommandASTExpressionNode::Type::Parentheses: {
+				return may_keep_value(std::get<CommandASTParenthesesNode>(expression->value).expression.get());
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression->value);
+				return condition.true_branch == nullptr || condition.false_branch == nullptr
+					|| may_keep_value(condition.true_branch.get()) || may_keep_value(condition.false_branch.get());
+			}
+			default: {
+				return false;
+			}
+			}
+		}
+
+		// Whether a return, a loop or an argument running out partway through the expression leaves some of it written into the target,
+		// which only a list reached through parentheses and conditions does, as it's excuted right into the target.
+		static auto may_write_partly(const CommandASTExpressionNode* expression) -> bool {
+			if (expression == nullptr) {
+				return false;
+			}
+			switch (expression->type) {
+			case CommandASTExpressionNode::Type::Parentheses: {
+				return may_write_partly(std::get<CommandASTParenthesesNode>(expression->value).expression.get());
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression->value);
+				return may_write_partly(condition.true_branch.get()) || may_write_partly(condition.false_branch.get());
+			}
+			case CommandASTExpressionNode::Type::List: {
+				auto& list = std::get<CommandASTListNode>(expression->value);
+				return std::any_of(list.expressions.begin(), list.expressions.end(), [](const CommandASTExpressionNode& element) { return may_exit(&element); });
+			}
+			default: {
+				return false;
+			}
+			}
+		}
+
+		// Whether excuting the expression may stop partway through, by `<`, `%` or `<>`. Calls don't, whatever their bodies do.
+		static auto may_exit(const CommandASTExpressionNode* expression) -> bool {
+			if (expression == nullptr) {
+				return false;
+			}
+			switch (expression->type) {
+			case CommandASTExpressionNode::Type::Operation: {
+				auto& operands = std::get<CommandASTOperationNode>(expression->value).operands;
+				return std::any_of(operands.begin(), operands.end(), [](const CommandASTExpressionNode& operand) { return may_exit(&operand); });
+			}
+			case CommandASTExpressionNode::Type::List: {
+				auto& elements = std::get<CommandASTListNode>(expression->value).expressions;
+				return std::any_of(elements.begin(), elements.end(), [](const CommandASTExpressionNode& element) { return may_exit(&element); });
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				return may_exit(std::get<CommandASTParenthesesNode>(expression->value).expression.get());
+			}
+			case CommandASTExpressionNode::Type::Calling: {
+				auto& calling = std::get<CommandASTCallingNode>(expression->value);
+				return may_exit(calling.callable.get()) || may_exit(calling.argument.get());
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression->value);
+				return may_exit(condition.condition.get()) || may_exit(condition.true_branch.get()) || may_exit(condition.false_branch.get());
+			}
+			case CommandASTExpressionNode::Type::Assignment: {
+				auto& assignment = std::get<CommandASTAssignmentNode>(expression->value);
+				return may_exit(assignment.target.get()) || may_exit(assignment.expression.get());
+			}
+			case CommandASTExpressionNode::Type::Accessing: {
+				return may_exit(std::get<CommandASTAccessingNode>(expression->value).expression.get());
+			}
+			case CommandASTExpressionNode::Type::Argument:
+			case CommandASTExpressionNode::Type::Return:
+			case CommandASTExpressionNode::Type::Loop: {
+				return true;
+			}
+			default: {
+				return false;
+			}
+			}
+		}
+
+		static auto to_instruction_code(CommandASTOperationNode::Type operation) -> CommandInstruction::Code {
+			switch (operation) {
+			case CommandASTOperationNode::Type::Add: return CommandInstruction::Code::Add;
+			case CommandASTOperationNode::Type::Subtract: return CommandInstruction::Code::Subtract;
+			case CommandASTOperationNode::Type::Multiply: return CommandInstruction::Code::Multiply;
+			case CommandASTOperationNode::Type::Divide: return CommandInstruction::Code::Divide;
+			case CommandASTOperationNode::Type::Positive: return CommandInstruction::Code::Positive;
+			case CommandASTOperationNode::Type::Negative: return CommandInstruction::Code::Negative;
+			case CommandASTOperationNode::Type::Modulo: return CommandInstruction::Code::Modulo;
+			case CommandASTOperationNode::Type::Exponent: return CommandInstruction::Code::Exponent;
+			case CommandASTOperationNode::Type::LessThan: return CommandInstruction::Code::LessThan;
+			case CommandASTOperationNode::Type::LessThanOrEqual: return CommandInstruction::Code::LessThanOrEqual;
+			case CommandASTOperationNode::Type::GreaterThan: return CommandInstruction::Code::GreaterThan;
+			case CommandASTOperationNode::Type::GreaterThanOrEqual: return CommandInstruction::Code::GreaterThanOrEqual;
+			case CommandASTOperationNode::Type::Equal: return CommandInstruction::Code::Equal;
+			case CommandASTOperationNode::Type::NotEqual: return CommandInstruction::Code::NotEqual;
+			case CommandASTOperationNode::Type::Not: return CommandInstruction::Code::Not;
+			default: {
+				throw CommandException("Unknow operation.");
+			}
+			}
+		}
+	};
+}
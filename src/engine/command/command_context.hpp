@@ -0,0 +1,66 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// What runtimes share instead of building it each: the interned symbols, so code compiled by one runtime runs on the others,
+	/// the libraries bound into every runtime created from the context, and the scripts parsed and compiled from the code they run.
+	/// Libraries are added before runtimes are created from the context, everything else may be used from any thread.
+	/// </summary>
+	struct CommandContext
+	{
+		std::shared_ptr<CommandSymbolTable> symbols = std::make_shared<CommandSymbolTable>();
+
+		// Where `import` finds modules, for the runtimes created from the context.
+		CommandModuleRegistry* modules = &CommandModuleRegistry::standard();
+
+		// Whether the shared scripts have their constants folded, runtimes optimizing otherwise parse their own.
+		bool optimizing = true;
+
+		auto add_library(CommandLibrary&& library) -> void {
+			for (auto& [name, value] : library.variables) {
+				values.emplace_back(symbols->intern(name), std::move(value));
+			}
+		}
+
+		/// <summary>
+		/// Binds the libraries into the top scope of a kernel sharing the symbols, and returns the identifiers which couldn't be bound.
+		/// Functions are bound through `CommandValue::forwarding`, the functions themselves are never copied.
+		/// </summary>
+		auto load_to(CommandKernel& kernel) const -> std::vector<CommandValue> {
+			std::vector<CommandValue> failed_identifiers;
+			for (auto& [symbol, value] : values) {
+				if (!kernel.add_identifier(symbol, CommandValue::forwarding(value), true)) {
+					failed_identifiers.push_back(CommandValue{ CommandValue::Type::String, kernel.symbols.name(symbol) });
+				}
+			}
+			return failed_identifiers;
+		}
+
+		/// <summary>
+		/// The script a runtime shared for `source`, or `nullptr`.
+		/// </summary>
+		auto find(std::string_view source) -> std::shared_ptr<CommandScript> {
+			std::lock_guard lock{ mutex };
+			return scripts.find(source);
+		}
+
+		/// <summary>
+		/// Shares a script whose every statement is compiled already, so nothing writes it anymore, and returns the one shared for `source`,
+		/// which is another runtime's if it shared one first.
+		/// </summary>
+		auto share(std::string_view source, std::shared_ptr<CommandScript> script) -> std::shared_ptr<CommandScript> {
+			std::lock_guard lock{ mutex };
+			if (auto found = scripts.find(source)) {
+				return found;
+			}
+			scripts.insert(source, script);
+			return script;
+		}
+
+	private:
+		std::vector<std::pair<uint32_t, CommandValue>> values;
+		std::mutex mutex;
+		CommandScriptCache scripts{ 1024 };
+	};
+}
@@ -2,298 +2,290 @@
 
 namespace arx
 {
-	struct CommandValue
+	/// <summary>
+	/// Names interned into dense integer symbols, which kernels running the same compiled code share, from any thread.
+	/// </summary>
+	struct CommandSymbolTable
 	{
-		enum class Type
-		{
-			Empty,
-			Number,
-			String,
-			List,
-			Function,
-			Macro,
-		};
-		Type type;
-		std::variant<
-			bool, 
-			float, 
-			std::string, 
-			std::vector<CommandValue>, 
-			std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>
-		> value;
-
-		CommandValue(
-			Type type = Type::Empty, 
-			std::variant<
-				bool,
-				float,
-				std::string,
-				std::vector<CommandValue>,
-				std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>
-			> value = true
-		) : type{ type }, value{ value } {
-		}
-
-		auto to_string() const -> std::string {
-			switch (type) {
-			case Type::Empty: {
-				return std::get<bool>(value) ? "()" : "(-)";
-			}
-			case Type::Number: {
-				return std::to_string(std::get<float>(value));
-			}
-			case Type::String: {
-				return std::get<std::string>(value);
-			}
-			case Type::List: {
-				std::string result = "[";
-				for (const auto& item : std::get<std::vector<CommandValue>>(value)) {
-					result += item.to_string() + ", ";
-				}
-				if (result.size() > 1) {
-					result.pop_back();
-					result.pop_back();
-				}
-				result += "]";
-				return result;
-			}
-			case Type::Function: {
-				return "function";
-			}
-			case Type::Macro: {
-				return "marco";
-			}
-			default: {
-				return "unknown";
-			}
+		auto intern(const std::string& name) -> uint32_t {
+			std::lock_guard lock{ mutex };
+			auto [it, inserted] = indices.try_emplace(name, static_cast<uint32_t>(names.size()));
+			if (inserted) {
+				names.push_back(name);
 			}
+			return it->second;
 		}
 
-		auto operator+() const -> CommandValue {
-			return *this;
+		auto name(uint32_t symbol) -> const std::string& {
+			std::lock_guard lock{ mutex };
+			return names[symbol]; // a deque, so the name stays where it is as others are interned.
 		}
 
-		auto operator-() const -> CommandValue {
-			if (type == Type::Empty) {
-				return CommandValue{ Type::Empty, !std::get<bool>(value) };
-			}
-			else if (type == Type::Number) {
-				return CommandValue{ Type::Number, -std::get<float>(value) };
+	private:
+		std::mutex mutex;
+		std::unordered_map<std::string, uint32_t> indices;
+		std::deque<std::string> names;
+	};
+
+	/// <summary>
+	/// Interns identifier names into dense integer symbols, shared by the kernel and the compiler.
+	/// The symbols come from a `table` which other kernels may share; the names seen once are remembered here, so they're interned again without locking it.
+	/// </summary>
+	struct CommandSymbols
+	{
+		std::shared_ptr<CommandSymbolTable> table = std::make_shared<CommandSymbolTable>();
+		std::unordered_map<std::string, uint32_t> indices;
+
+		auto intern(const std::string& name) -> uint32_t {
+			if (auto found = indices.find(name); found != indices.end()) {
+				return found->second;
 			}
-			return CommandValue{ Type::Empty, false };
+			auto symbol = table->intern(name);
+			indices.emplace(name, symbol);
+			return symbol;
 		}
 
-		auto operator+(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty) {
-				return other;
-			}
-			if (other.type == Type::Empty) {
-				return *this;
-			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Number, std::get<float>(value) + std::get<float>(other.value) };
-			}
-			if (type == Type::List) {
-				auto result = std::get<std::vector<CommandValue>>(value);
-				if (other.type == Type::List) {
-					result.insert(result.end(), std::get<std::vector<CommandValue>>(other.value).begin(), std::get<std::vector<CommandValue>>(other.value).end());
-				}
-				else {
-					result.push_back(other);
-				}
-				return CommandValue{ Type::List, std::move(result) };
-			}
-			if (type == Type::String || other.type == Type::String) {
-				return CommandValue{ Type::String, to_string() + other.to_string() };
-			}
-			return CommandValue{ Type::Empty, false };
+		auto name(uint32_t symbol) const -> const std::string& {
+			return table->name(symbol);
 		}
+	};
+
+	struct CommandKernel
+	{
+		static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
 
-		auto operator-(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty || other.type == Type::Empty) {
-				return -other;
+		// Identifiers are shallow bound: every scope owns a contiguous range of `bindings`,
+		// and `binding_heads[symbol]` is the visible binding of a symbol, so reads don't depend on the depth of `scope_stack`.
+		struct Binding {
+			CommandValue value;
+			uint32_t symbol;
+			uint32_t previous;
+			uint32_t depth;
+			bool alive = true;
+		};
+		struct Protection {
+			uint32_t symbol;
+			uint32_t previous;
+			uint32_t depth;
+		};
+		struct StackFrame {
+			size_t binding_base = 0;
+			size_t protection_base = 0;
+			uint32_t depth = 0;
+		};
+		struct BodyFrame {
+			CommandValue::Arguments borrowed_arguments;
+			CommandValue owned_arguments; // arguments passed to a loop or a tail call, which outlive the caller's.
+			bool owned = false;
+			bool scoped = false; // whether the body has a scope of its own, which a tail call may reuse.
+			size_t index = 0;
+			CommandValue return_value;
+			const CommandValue* self;
+			CommandValue owned_self; // the callee of a tail call, which replaced `self`.
+			uint32_t replaced = 0; // bodies replaced by calls in tail position, each still a level between this body and the one below.
+			BodyFrame(
+				CommandValue::Arguments arguments, 
+				const CommandValue* self
+			) : 
+				borrowed_arguments{ arguments },
+				return_value{ },
+				self{ self } {
 			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Number, std::get<float>(value) - std::get<float>(other.value) };
+			auto arguments() const -> CommandValue::Arguments {
+				return owned ? owned_arguments.as_arguments() : borrowed_arguments;
 			}
-			return CommandValue{ Type::Empty, false };
+			auto callee() const -> const CommandValue& {
+				return owned_self.type == CommandValue::Type::Empty ? *self : owned_self;
+			}
+		};
+		// A scope is only pushed to `scope_stack` once something is bound or protected in it,
+		// calls into bodies which never assign a local just move `scope_depth`.
+		std::vector<StackFrame> scope_stack{ 1 };
+		uint32_t scope_depth = 0;
+		std::vector<BodyFrame> body_stack;
+		bool requiring_loop = false;
+		bool requiring_tail_call = false; // `tail_callee` is to replace the top body, see `excute_tail_calling`.
+		CommandValue tail_callee;
+		CommandValue tail_argument;
+		bool optimizing = true; // Whether the statements handed to the kernel had their constants folded by the parser, which archives are told apart by.
+		// Imports a module into the top scope and returns the identifiers which couldn't be bound, set by the runtime owning the kernel.
+		std::function<std::vector<CommandValue>(const std::string&)> importer;
+		CommandProfiler profiler;
+		CommandCollector collector; // of the lists modified in place, outliving the bindings which may hold them.
+
+		CommandSymbols symbols;
+		std::deque<Binding> bindings;
+		std::vector<Protection> protections;
+		std::vector<uint32_t> binding_heads;
+		std::vector<uint32_t> protection_heads;
+
+		auto push_scope() -> void {
+			++scope_depth;
 		}
 
-		auto operator*(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty && other.type == Type::Empty) {
-				return CommandValue(Type::Empty, std::get<bool>(value) == std::get<bool>(other.value));
-			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Number, std::get<float>(value) * std::get<float>(other.value) };
+		auto pop_scope() -> void {
+			auto& frame = scope_stack.back();
+			if (frame.depth != scope_depth) {
+				--scope_depth;
+				return;
 			}
-			if (type == Type::Empty && other.type == Type::Number) {
-				return CommandValue{ Type::Number, std::get<bool>(value) ? std::get<float>(other.value) : -std::get<float>(other.value) };
+			while (bindings.size() > frame.binding_base) {
+				auto& binding = bindings.back();
+				if (binding.alive) {
+					binding_heads[binding.symbol] = binding.previous;
+				}
+				bindings.pop_back();
 			}
-			if (type == Type::Number && other.type == Type::Empty) {
-				return CommandValue{ Type::Number, std::get<bool>(other.value) ? std::get<float>(value) : -std::get<float>(value) };
+			while (protections.size() > frame.protection_base) {
+				protection_heads[protections.back().symbol] = protections.back().previous;
+				protections.pop_back();
 			}
-			return CommandValue{ Type::Empty, false };
+			scope_stack.pop_back();
+			--scope_depth;
 		}
 
-		auto operator/(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Number, std::get<float>(value) / std::get<float>(other.value) };
-			}
-			return CommandValue{ Type::Empty, false };
+		// Whether something is protected in the top scope, a tail call reusing the scope would see these protections.
+		auto protects_locals() const -> bool {
+			return scope_stack.back().depth == scope_depth && protections.size() > scope_stack.back().protection_base;
 		}
 
-		auto operator%(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Number, std::fmod(std::get<float>(value), std::get<float>(other.value)) };
+		auto materialize_scope() -> void {
+			if (scope_stack.back().depth != scope_depth) {
+				scope_stack.push_back({ bindings.size(), protections.size(), scope_depth });
 			}
-			return CommandValue{ Type::Empty, true };
 		}
 
-		auto operator==(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty && other.type == Type::Empty) {
-				return CommandValue{ Type::Empty, std::get<bool>(value) == std::get<bool>(other.value) };
-			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Empty, std::get<float>(value) == std::get<float>(other.value) };
-			}
-			if (type == Type::String && other.type == Type::String) {
-				return CommandValue{ Type::Empty, std::get<std::string>(value) == std::get<std::string>(other.value) };
-			}
-			return CommandValue{ Type::Empty, false };
+		auto top_depth() const -> uint32_t {
+			return scope_depth;
 		}
 
-		auto operator!=(const CommandValue& other) const -> CommandValue {
-			auto result = *this == other;
-			std::get<bool>(result.value) = !std::get<bool>(result.value);
-			return result;
-		}
+		/// <summary>
+		/// Heights of the stacks, see `restore`.
+		/// </summary>
+		struct Mark {
+			size_t scopes;
+			uint32_t depth;
+			size_t bodies;
+			size_t bindings;
+			size_t protections;
+			size_t samples; // of the profiler.
+		};
 
-		auto operator<(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty && other.type == Type::Empty) {
-				return CommandValue{ Type::Empty, std::get<bool>(value) < std::get<bool>(other.value) };
-			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Empty, std::get<float>(value) < std::get<float>(other.value) };
-			}
-			if (type == Type::String && other.type == Type::String) {
-				return CommandValue{ Type::Empty, std::get<std::string>(value) < std::get<std::string>(other.value) };
-			}
-			return CommandValue{ Type::Empty, false };
+		auto mark() const -> Mark {
+			return Mark{ scope_stack.size(), scope_depth, body_stack.size(), bindings.size(), protections.size(), profiler.depth() };
 		}
 
-		auto operator<=(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty && other.type == Type::Empty) {
-				return CommandValue{ Type::Empty, std::get<bool>(value) <= std::get<bool>(other.value) };
+		/// <summary>
+		/// The mark of the global scope, outside of any call.
+		/// </summary>
+		auto global_mark() const -> Mark {
+			if (scope_stack.size() > 1) {
+				return Mark{ 1, 0, 0, scope_stack[1].binding_base, scope_stack[1].protection_base, 0 };
 			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Empty, std::get<float>(value) <= std::get<float>(other.value) };
-			}
-			if (type == Type::String && other.type == Type::String) {
-				return CommandValue{ Type::Empty, std::get<std::string>(value) <= std::get<std::string>(other.value) };
-			}
-			return CommandValue{ Type::Empty, false };
+			return Mark{ 1, 0, 0, bindings.size(), protections.size(), 0 };
 		}
 
-		auto operator>(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty && other.type == Type::Empty) {
-				return CommandValue{ Type::Empty, std::get<bool>(value) > std::get<bool>(other.value) };
-			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Empty, std::get<float>(value) > std::get<float>(other.value) };
-			}
-			if (type == Type::String && other.type == Type::String) {
-				return CommandValue{ Type::Empty, std::get<std::string>(value) > std::get<std::string>(other.value) };
-			}
-			return CommandValue{ Type::Empty, false };
+		/// <summary>
+		/// Drops the scopes and bodies above a mark at once, after an error interrupted the calls which were to pop them.
+		/// Only the heads of the dropped bindings and protections are visited, to make their shadowed ones visible again.
+		/// </summary>
+		auto restore(const Mark& mark) -> void {
+			for (auto i = bindings.size(); i > mark.bindings; --i) {
+				auto& binding = bindings[i - 1];
+				if (binding.alive) {
+					binding_heads[binding.symbol] = binding.previous;
+				}
+			}
+			for (auto i = protections.size(); i > mark.protections; --i) {
+				protection_heads[protections[i - 1].symbol] = protections[i - 1].previous;
+			}
+			bindings.erase(bindings.begin() + mark.bindings, bindings.end());
+			protections.resize(mark.protections);
+			scope_stack.resize(mark.scopes);
+			scope_depth = mark.depth;
+			body_stack.erase(body_stack.begin() + mark.bodies, body_stack.end());
+			requiring_loop = false;
+			requiring_tail_call = false;
+			tail_callee = CommandValue{ };
+			tail_argument = CommandValue{ };
+			profiler.unwind(mark.samples);
 		}
 
-		auto operator>=(const CommandValue& other) const -> CommandValue {
-			if (type == Type::Empty && other.type == Type::Empty) {
-				return CommandValue{ Type::Empty, std::get<bool>(value) >= std::get<bool>(other.value) };
-			}
-			if (type == Type::Number && other.type == Type::Number) {
-				return CommandValue{ Type::Empty, std::get<float>(value) >= std::get<float>(other.value) };
-			}
-			if (type == Type::String && other.type == Type::String) {
-				return CommandValue{ Type::Empty, std::get<std::string>(value) >= std::get<std::string>(other.value) };
-			}
-			return CommandValue{ Type::Empty, false };
+		auto find_binding(uint32_t symbol) -> Binding* {
+			auto head = symbol < binding_heads.size() ? binding_heads[symbol] : none;
+			return head == none ? nullptr : &bindings[head];
 		}
 
-		auto operator!() const -> CommandValue {
-			if (type == Type::Empty) {
-				return CommandValue{ Type::Empty, !std::get<bool>(value) };
-			}
-			return CommandValue{ Type::Empty, false };
+		auto find_protection(uint32_t symbol) -> Protection* {
+			auto head = symbol < protection_heads.size() ? protection_heads[symbol] : none;
+			return head == none ? nullptr : &protections[head];
 		}
-	};
 
-	inline auto to_string(const CommandValue::Type& type) -> std::string {
-		switch (type) {
-		case CommandValue::Type::Empty: {
-			return "Empty";
-		}
-		case CommandValue::Type::Number: {
-			return "Number";
-		}
-		case CommandValue::Type::String: {
-			return "String";
-		}
-		case CommandValue::Type::List: {
-			return "List";
-		}
-		case CommandValue::Type::Function: {
-			return "Function";
-		}
-		case CommandValue::Type::Macro: {
-			return "Marco";
-		}
-		default: {
-			return "Unknown";
+		// Whether a binding at `depth` is protected by its own scope or any scope above it.
+		auto is_protected(uint32_t symbol, uint32_t depth) -> bool {
+			auto protection = find_protection(symbol);
+			return protection != nullptr && protection->depth >= depth;
 		}
+
+		auto bind(uint32_t symbol, CommandValue&& value) -> CommandValue& {
+			if (symbol >= binding_heads.size()) {
+				binding_heads.resize(symbol + 1, none);
+			}
+			materialize_scope();
+			bindings.push_back({ std::move(value), symbol, binding_heads[symbol], top_depth() });
+			binding_heads[symbol] = static_cast<uint32_t>(bindings.size() - 1);
+			return bindings.back().value;
 		}
-	}
 
-	struct CommandKernel
-	{
-		struct StackFrame {
-			std::unordered_map<std::string, CommandValue> identifiers;
-			std::unordered_set<std::string> protections;
-		};
-		struct BodyFrame {
-			std::shared_ptr<std::vector<CommandValue>> owned_arguments;
-			const std::vector<CommandValue>* arguments;
-			size_t index = 0;
-			CommandValue return_value;
-			const std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>* self;
-			BodyFrame(
-				const std::vector<CommandValue>* arguments, 
-				const std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>* self
-			) : 
-				arguments{ arguments },
-				return_value{ },
-				self{ self } {
+		auto protect(uint32_t symbol) -> void {
+			auto protection = find_protection(symbol);
+			if (protection != nullptr && protection->depth == top_depth()) {
+				return;
 			}
-		};
-		std::vector<StackFrame> scope_stack{ 1 };
-		std::vector<BodyFrame> body_stack;
-		bool requiring_loop = false;
+			if (symbol >= protection_heads.size()) {
+				protection_heads.resize(symbol + 1, none);
+			}
+			materialize_scope();
+			protections.push_back({ symbol, protection_heads[symbol], top_depth() });
+			protection_heads[symbol] = static_cast<uint32_t>(protections.size() - 1);
+		}
 
 		auto add_identifier(const std::string& name, CommandValue&& value, bool protect = false) -> bool {
-			if (scope_stack.back().protections.contains(name)) {
+			return add_identifier(symbols.intern(name), std::move(value), protect);
+		}
+
+		auto add_identifier(uint32_t symbol, CommandValue&& value, bool protect = false) -> bool {
+			auto protection = find_protection(symbol);
+			if (protection != nullptr && protection->depth == top_depth()) {
 				return false;
 			}
-			scope_stack.back().identifiers[name] = std::move(value);
+			if (profiler.enabled) {
+				profiler.name(symbols.name(symbol), value);
+			}
+			auto binding = find_binding(symbol);
+			if (binding != nullptr && binding->depth == top_depth()) {
+				binding->value = std::move(value);
+			}
+			else {
+				bind(symbol, std::move(value));
+			}
 			if (protect) {
-				scope_stack.back().protections.insert(name);
+				this->protect(symbol);
 			}
 			return true;
 		}
 
-		auto add_function(const std::string& name, const std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>& function, bool protect = false) -> CommandKernel& {
-			scope_stack.rbegin()->identifiers.insert({ name, CommandValue{ CommandValue::Type::Function, function } });
+		auto add_function(const std::string& name, const CommandValue::Function& function, bool protect = false) -> CommandKernel& {
+			auto symbol = symbols.intern(name);
+			auto binding = find_binding(symbol);
+			if (binding == nullptr || binding->depth != top_depth()) {
+				bind(symbol, CommandValue{ CommandValue::Type::Function, function });
+				if (profiler.enabled) {
+					profiler.name(name, find_binding(symbol)->value);
+				}
+			}
 			if (protect) {
-				scope_stack.rbegin()->protections.insert(name);
+				this->protect(symbol);
 			}
 			return *this;
 		}
@@ -314,33 +306,28 @@ namespace arx
 			return *this;
 		}*/
 
-		auto find_identifier_or_insert(const std::string& name) -> std::pair<CommandValue&, bool> {
-			auto is_protected = false;
-			for (auto it = scope_stack.rbegin(); it != scope_stack.rend(); ++it) {
-				if (it->protections.find(name) != it->protections.end()) {
-					is_protected = true;
-				}
-				auto find = it->identifiers.find(name);
-				if (find != it->identifiers.end()) {
-					return { find->second, is_protected };
-				}
+		auto find_identifier_or_insert(uint32_t symbol) -> std::pair<CommandValue&, bool> {
+			auto binding = find_binding(symbol);
+			if (binding != nullptr) {
+				return { binding->value, is_protected(symbol, binding->depth) };
 			}
-			scope_stack.rbegin()->identifiers.insert({ name, CommandValue{ CommandValue::Type::Empty, true } });
-			return { scope_stack.rbegin()->identifiers.at(name), false }; // false, not `is_protected`. 
+			return { bind(symbol, CommandValue{ CommandValue::Type::Empty, true }), false }; // false, not `is_protected`. 
+		}
+
+		auto find_identifier_or_insert(const std::string& name) -> std::pair<CommandValue&, bool> {
+			return find_identifier_or_insert(symbols.intern(name));
 		}
 		
-		auto find_identifier_or_throw(const std::string& name) -> std::pair<CommandValue&, bool> {
-			auto is_protected = false;
-			for (auto it = scope_stack.rbegin(); it != scope_stack.rend(); ++it) {
-				if (it->protections.find(name) != it->protections.end()) {
-					is_protected = true;
-				}
-				auto find = it->identifiers.find(name);
-				if (find != it->identifiers.end()) {
-					return { find->second, is_protected };
-				}
+		auto find_identifier_or_throw(uint32_t symbol) -> std::pair<CommandValue&, bool> {
+			auto binding = find_binding(symbol);
+			if (binding != nullptr) {
+				return { binding->value, is_protected(symbol, binding->depth) };
 			}
-			throw CommandException("Non-exist identifier {}.", name);
+			throw CommandException("Non-exist identifier {}.", symbols.name(symbol));
+		}
+
+		auto find_identifier_or_throw(const std::string& name) -> std::pair<CommandValue&, bool> {
+			return find_identifier_or_throw(symbols.intern(name));
 		}
 
 		auto operator<<(const CommandASTStatementNode& statement) -> CommandKernel& {
@@ -364,6 +351,16 @@ namespace arx
 
 	public: // excute expressions.
 		auto excute_expression(const CommandASTExpressionNode& expression, CommandValue* result) -> uint32_t {
+			try {
+				return excute_node(expression, result);
+			}
+			catch (CommandException& exception) {
+				exception.locate(expression.position);
+				throw;
+			}
+		}
+
+		auto excute_node(const CommandASTExpressionNode& expression, CommandValue* result) -> uint32_t {
 			switch (expression.type) {
 			case CommandASTExpressionNode::Type::Empty: {
 				if (result != nullptr) {
@@ -373,7 +370,8 @@ namespace arx
 			}
 			case CommandASTExpressionNode::Type::Number: {
 				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::get<CommandASTNumberNode>(expression.value).value };
+					auto& number = std::get<CommandASTNumberNode>(expression.value);
+					*result = number.integral ? CommandValue::from_integer(number.integer) : CommandValue{ CommandValue::Type::Number, number.value };
 				}
 				return 0;
 			}
@@ -399,7 +397,7 @@ namespace arx
 				return excute_calling(std::get<CommandASTCallingNode>(expression.value), result);
 			}
 			case CommandASTExpressionNode::Type::FunctionBody: {
-				return excute_function_body(std::get<CommandASTFunctionBodyNode>(expression.value), result);
+				return excute_function_body(std::get<CommandASTFunctionBodyNode>(expression.value), expression.position, result);
 			}
 			case CommandASTExpressionNode::Type::Condition: {
 				return excute_condition(std::get<CommandASTConditionNode>(expression.value), result);
@@ -435,26 +433,15 @@ namespace arx
 		}
 
 		auto excute_identifier(const CommandASTIdentifierNode& identifier, CommandValue* result) -> uint32_t {
-			for (auto scope = scope_stack.rbegin(); scope != scope_stack.rend(); ++scope) {
-				if (scope->identifiers.find(identifier.name) != scope->identifiers.end()) {
-					if (result != nullptr) {
-						*result = scope->identifiers.at(identifier.name);
-					}
-					return 0;
-				}
-			}
-			scope_stack.rbegin()->identifiers.insert({
-				identifier.name,
-				CommandValue{ CommandValue::Type::Empty, true }
-			});
-			if (result != nullptr) {
-				*result = scope_stack.rbegin()->identifiers.at(identifier.name);
-			}
+			read_identifier(symbols.intern(identifier.name), result);
 			return 0;
 		}
 
 		auto excute_operation(const CommandASTOperationNode& operation, CommandValue* result) -> uint32_t {
-			std::vector<CommandValue> operand_results(operation.operands.size());
+			if (operation.operands.empty() || operation.operands.size() > 2) {
+				throw CommandException("Unknow operation.");
+			}
+			CommandValue operand_results[2];
 			for (size_t i = 0; i < operation.operands.size(); ++i) {
 				auto return_level = excute_expression(operation.operands[i], &operand_results[i]);
 				if (return_level != 0) {
@@ -463,79 +450,7 @@ namespace arx
 			}
 
 			if (result != nullptr) {
-				switch (operation.type)
-				{
-				case CommandASTOperationNode::Type::Add: {
-					*result = operand_results[0] + operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::Subtract: {
-					*result = operand_results[0] - operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::Multiply: {
-					*result = operand_results[0] * operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::Divide: {
-					*result = operand_results[0] / operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::Positive: {
-					*result = +operand_results[0];
-					break;
-				}
-				case CommandASTOperationNode::Type::Negative: {
-					*result = -operand_results[0];
-					break;
-				}
-				case CommandASTOperationNode::Type::Not: {
-					*result = !operand_results[0];
-					break;
-				}
-				case CommandASTOperationNode::Type::Modulo: {
-					*result = operand_results[0] % operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::Exponent: {
-					if (operand_results[0].type == CommandValue::Type::Number && operand_results[1].type == CommandValue::Type::Number) {
-						*result = CommandValue{ 
-							CommandValue::Type::Number, 
-							std::pow(std::get<float>(operand_results[0].value), std::get<float>(operand_results[1].value)) 
-						};
-					}
-					else {
-						*result = CommandValue{ CommandValue::Type::Empty, true };
-					}
-					break;
-				}
-				case CommandASTOperationNode::Type::Equal: {
-					*result = operand_results[0] == operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::NotEqual: {
-					*result = operand_results[0] != operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::LessThan: {
-					*result = operand_results[0] < operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::LessThanOrEqual: {
-					*result = operand_results[0] <= operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::GreaterThan: {
-					*result = operand_results[0] > operand_results[1];
-					break;
-				}
-				case CommandASTOperationNode::Type::GreaterThanOrEqual: {
-					*result = operand_results[0] >= operand_results[1];
-					break;
-				}
-				default:
-					throw CommandException("Unknow operation.");
-				}
+				*result = arx::operate(operation.type, operand_results[0], operation.operands.size() > 1 ? operand_results[1] : operand_results[0]);
 			}
 			return 0;
 		}
@@ -544,7 +459,7 @@ namespace arx
 			//std::vector<CommandValue> element_results(list.expressions.size());
 			if (result != nullptr) {
 				*result = CommandValue{ CommandValue::Type::List, std::vector<CommandValue>(list.expressions.size()) };
-				auto& element_results = std::get<std::vector<CommandValue>>(result->value);
+				auto& element_results = result->as_list_mut();
 				for (size_t i = 0; i < list.expressions.size(); ++i) {
 					auto return_level = excute_expression(list.expressions[i], &element_results[i]);
 					if (return_level != 0) {
@@ -576,53 +491,95 @@ namespace arx
 				return return_level;
 			}
 
-			switch (callable.type)
-			{
-			case CommandValue::Type::Function: {
-				if (scope_stack.size() >= 1000) {
-					throw CommandException("Stack overflow.");
-				}
-				scope_stack.push_back({ });
-
-				auto& function = std::get<std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>>(callable.value);
-				function(argument.type == CommandValue::Type::List ? std::get<std::vector<CommandValue>>(argument.value) : std::vector{ argument }, result);
-
-				scope_stack.pop_back();
+			call(callable, argument, result);
+			return 0;
+		}
 
-				break;
-			}
-			case CommandValue::Type::Macro: {
-				auto& function = std::get<std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>>(callable.value);
-				function(argument.type == CommandValue::Type::List ? std::get<std::vector<CommandValue>>(argument.value) : std::vector{ argument }, result);
-				break;
-			}
-			case CommandValue::Type::List: {
-				auto& list = std::get<std::vector<CommandValue>>(callable.value);
-				if (argument.type == CommandValue::Type::Number) {
-					auto index = std::llround(std::get<float>(argument.value));
-					if ((index < -static_cast<int64_t>(list.size())) || (index >= static_cast<int64_t>(list.size()))) {
-						throw CommandException("Index({}) out of range(-{}..{}).", index, list.size(), list.size());
+		/// <summary>
+		/// Functions created by `excute_function_body`, which share the statements of the body they were created from rather than copying them.
+		/// `CommandKernel::invoke` excutes them with the called value as `self`, only direct calls copy themselves into one.
+		/// A call in tail position replaces the running body in the same loop as `%` restarts it, so neither grows the native stack.
+		/// </summary>
+		struct body_callable {
+			std::shared_ptr<const std::vector<CommandASTStatementNode>> body;
+			CommandKernel& kernel;
+			CommandSourcePosition position; // of the body, which the profiler reports.
+			auto reaches_outer() const -> bool {
+				if (!outer.has_value()) {
+					outer = CommandKernel::reaches_outer(*body);
+				}
+				return *outer;
+			}
+			auto operator()(CommandValue::Arguments arguments, CommandValue* result) const -> uint32_t {
+				CommandValue self{ CommandValue::Type::Function, CommandValue::Function{ *this } };
+				return excute(arguments, &self, false, result);
+			}
+			auto excute(CommandValue::Arguments arguments, const CommandValue* self, bool scoped, CommandValue* result) const -> uint32_t {
+				kernel.body_stack.emplace_back(
+					arguments,
+					self
+				);
+				kernel.body_stack.back().scoped = scoped;
+				auto current = this;
+				auto pushed = false; // a function called in tail position of a macro gets a scope of its own.
+				auto sample = kernel.profiler.enabled ? kernel.profiler.enter(kernel.profiler.body(body, body.get(), position)) : CommandProfiler::none;
+				uint32_t return_level = 0;
+				while (true) {
+					for (auto& statement : *current->body) {
+						return_level = kernel.excute_statement(statement);
+						if (return_level != 0) {
+							break;
+						}
 					}
-					if (index < 0) {
-						index += list.size();
+					if ((return_level <= 1) && kernel.requiring_loop) {
+						kernel.requiring_loop = false;
+						return_level = 0;
+						continue;
 					}
-					if (result != nullptr) {
-						*result = list[index];
+					if ((return_level == 1) && kernel.requiring_tail_call) {
+						kernel.requiring_tail_call = false;
+						auto& frame = kernel.body_stack.back();
+						if ((kernel.tail_callee.type == CommandValue::Type::Function) && !frame.scoped) {
+							if (kernel.scope_depth + 1 >= 1000) {
+								throw CommandException("Stack overflow.");
+							}
+							kernel.push_scope();
+							frame.scoped = pushed = true;
+						}
+						frame.owned_self = std::move(kernel.tail_callee);
+						frame.owned_arguments = std::move(kernel.tail_argument);
+						frame.owned = true;
+						frame.index = 0;
+						frame.return_value = CommandValue{ };
+						++frame.replaced;
+						current = frame.owned_self.as_function().target<body_callable>();
+						if (sample != CommandProfiler::none) {
+							kernel.profiler.unwind(sample);
+							kernel.profiler.enter(kernel.profiler.body(current->body, current->body.get(), current->position));
+						}
+						return_level = 0;
+						continue;
 					}
+					break;
 				}
-				else {
-					throw CommandException("Index must be a number.");
+				if ((return_level <= 1) && (result != nullptr)) {
+					*result = kernel.body_stack.back().return_value;
 				}
-				break;
-			}
-			default: {
-				throw CommandException("{} is not callable.", to_string(callable.type));
-			}
+				kernel.body_stack.pop_back();
+				if (pushed) {
+					kernel.pop_scope();
+				}
+				kernel.profiler.unwind(sample);
+				return return_level == 0 ? 0 : return_level - 1;
 			}
-			return 0;
-		}
+			body_callable(std::shared_ptr<const std::vector<CommandASTStatementNode>> body, CommandKernel& kernel, CommandSourcePosition position) : body(std::move(body)), kernel(kernel), position(position) { }
+			body_callable(const body_callable& other) : body(other.body), kernel(other.kernel), position(other.position), outer(other.outer) { }
+			body_callable(body_callable&& other) noexcept : body(std::move(other.body)), kernel(other.kernel), position(other.position), outer(other.outer) { }
+		private:
+			mutable std::optional<bool> outer; // `reaches_outer`, only analysed once a call in tail position asks for it.
+		};
 
-		auto excute_function_body(const CommandASTFunctionBodyNode& body, CommandValue* result) -> uint32_t {
+		auto excute_function_body(const CommandASTFunctionBodyNode& body, CommandSourcePosition position, CommandValue* result) -> uint32_t {
 			// shard_ptr is the best of the bests!!!!!!!!!!!!!!!!!
 			// I love it!!!!!!!!!!!!!!!!!!!!!
 			// It solved a problem on which I spent hours!!!!!!!!!!!!!!!!!
@@ -630,61 +587,8 @@ namespace arx
 				return 0;
 			}
 
-			struct body_callable {
-				std::shared_ptr<CommandASTFunctionBodyNode> body;
-				CommandKernel& kernel;
-				auto operator()(const std::vector<CommandValue>& arguments, CommandValue* result) const -> uint32_t {
-					std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)> self = *this;
-					kernel.body_stack.emplace_back(
-						&arguments,
-						&self
-					);
-					while (true) {
-						for (auto& statement : body->commands) {
-							auto return_level = kernel.excute_statement(statement);
-							if (return_level == 0) {
-								continue;
-							}
-							else if (return_level == 1) {
-								if (kernel.requiring_loop) {
-									break;
-								}
-								else if (result != nullptr) {
-									*result = kernel.body_stack.back().return_value;
-								}
-							}
-							kernel.body_stack.pop_back();
-							return return_level - 1;
-						}
-						if (kernel.requiring_loop) {
-							kernel.requiring_loop = false;
-							continue;
-						}
-						break;
-					}
-					if (result != nullptr) {
-						*result = kernel.body_stack.back().return_value;
-					}
-					kernel.body_stack.pop_back();
-					return 0;
-				}
-				body_callable(std::shared_ptr<CommandASTFunctionBodyNode> body, CommandKernel& kernel) : body(body), kernel(kernel) { }
-				body_callable(const body_callable& other) : body(other.body), kernel(other.kernel) { }
-				body_callable(body_callable&& other) noexcept : body(std::move(other.body)), kernel(other.kernel) { }
-				auto operator=(const body_callable& other) -> body_callable& {
-					body = other.body;
-					kernel = other.kernel;
-					return *this;
-				}
-				auto operator=(body_callable&& other) noexcept  -> body_callable& {
-					body = std::move(other.body);
-					kernel = other.kernel;
-					return *this;
-				}
-			};
-
-			std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)> function = 
-				body_callable(std::make_shared<CommandASTFunctionBodyNode>(body.clone()), *this);
+			// The parser already folded the constants of the body along with its statement.
+			CommandValue::Function function = body_callable(body.commands, *this, position);
 			*result = CommandValue{ CommandValue::Type::Function, std::move(function) };
 			return 0;
 		}
@@ -697,7 +601,7 @@ namespace arx
 					return return_level;
 				}
 			}
-			if ((condition_result.type == CommandValue::Type::Empty) && (!std::get<bool>(condition_result.value))) {
+			if ((condition_result.type == CommandValue::Type::Empty) && (!condition_result.as_boolean())) {
 				if (condition.false_branch != nullptr) {
 					return excute_expression(*(condition.false_branch), result);
 				}
@@ -717,16 +621,7 @@ namespace arx
 
 		auto excute_assignment(const CommandASTAssignmentNode& assignment, CommandValue* result) -> uint32_t {
 			if (assignment.local) {
-				auto name = get_identifier(*(assignment.target));
-				if (scope_stack.back().identifiers.find(name) == scope_stack.back().identifiers.end()) {
-					scope_stack.back().identifiers.insert({ name, CommandValue{ CommandValue::Type::Empty, true } });
-				}
-				else {
-					if (scope_stack.back().protections.contains(name)) {
-						throw CommandException("cannot assign to protected identifier `{}`.", name);
-					}
-				}
-				auto& identifier = scope_stack.back().identifiers.at(name);
+				auto& identifier = find_local_or_insert(symbols.intern(get_identifier(*(assignment.target))));
 
 				auto return_level = excute_expression(*(assignment.expression), &identifier);
 				if (return_level != 0) {
@@ -753,66 +648,68 @@ namespace arx
 		}
 
 		auto excute_protection(const CommandASTProtectionNode& protection, CommandValue* result) -> uint32_t {
-			auto name = get_identifier(*(protection.target));
-			auto [identifier, _] = find_identifier_or_throw(name);
-			scope_stack.back().protections.insert(name);
-			if (result != nullptr) {
-				*result = identifier;
-			}
+			protect_identifier(symbols.intern(get_identifier(*(protection.target))), result);
 			return 0;
 		}
 
 		auto excute_delete(const CommandASTDeleteNode& deletion, CommandValue* result) -> uint32_t {
-			auto name = get_identifier(*(deletion.target));
-			for (auto it = scope_stack.rbegin(); it != scope_stack.rend(); ++it) {
-				if (it->protections.find(name) != it->protections.end()) {
-					throw CommandException("`{}` is protected, cannot delete it.", name);
-				}
-				auto find = it->identifiers.find(name);
-				if (find != it->identifiers.end()) {
-					if (result != nullptr) {
-						*result = find->second;
-					}
-					it->identifiers.erase(find);
-					return 0;
-				}
-			}
-			throw CommandException("Cannot delete a non-existing identifier {}.", name);
+			delete_identifier(symbols.intern(get_identifier(*(deletion.target))), result);
+			return 0;
 		}
 
 		auto excute_argument(const CommandASTArgumentNode& argument, CommandValue* result) -> uint32_t {
-			if (argument.length > body_stack.size()) {
-				throw CommandException("Body doesn't exist");
-			}
-			auto skip = argument.length - 1;
-			auto& target_stack = body_stack.rbegin()[skip];
-			if (target_stack.index >= target_stack.arguments->size()) {
-				return excute_return(CommandASTReturnNode::make(
-					argument.length, 
-					std::make_unique<CommandASTExpressionNode>(CommandASTExpressionNode::make_empty())
-				), result);
-			}
-
-			if (result != nullptr) {
-				*result = (*target_stack.arguments)[target_stack.index];
-			}
-			++target_stack.index;
-			return 0;
+			return pull_argument(argument.length, result);
 		}
 
 		auto excute_return(const CommandASTReturnNode& returning, CommandValue* result) -> uint32_t {
-			if (returning.length > body_stack.size()) {
-				throw CommandException("Body doesn't exist.");
+			body_at(returning.length); // throws before the expression is excuted.
+			if ((returning.length == 1) && (returning.expression->type == CommandASTExpressionNode::Type::Calling)) {
+				return excute_tail_calling(std::get<CommandASTCallingNode>(returning.expression->value));
 			}
-			auto skip = returning.length - 1;
 
 			CommandValue return_value;
 			auto return_level = excute_expression(*(returning.expression), &return_value);
 			if (return_level != 0) {
 				return return_level;
 			}
-			body_stack.rbegin()[skip].return_value = std::move(return_value);
-			return returning.length;
+			return return_from(returning.length, std::move(return_value));
+		}
+
+		// `< f(x)`: unless `f` can't replace the running body, it's left to `body_callable` to call it once this body has unwound.
+		auto excute_tail_calling(const CommandASTCallingNode& calling) -> uint32_t {
+			CommandValue callable;
+			auto return_level = excute_expression(*(calling.callable), &callable);
+			if (return_level != 0) {
+				return return_level;
+			}
+
+			CommandValue argument;
+			return_level = excute_expression(*(calling.argument), &argument);
+			if (return_level != 0) {
+				return return_level;
+			}
+
+			if (!can_tail_call(callable)) {
+				CommandValue return_value;
+				call(callable, argument, &return_value);
+				return return_from(1, std::move(return_value));
+			}
+			tail_callee = std::move(callable);
+			tail_argument = std::move(argument);
+			requiring_tail_call = true;
+			return 1;
+		}
+
+		auto can_tail_call(const CommandValue& callable) -> bool {
+			if ((callable.type != CommandValue::Type::Function) && (callable.type != CommandValue::Type::Macro)) {
+				return false;
+			}
+			auto body = callable.as_function().target<body_callable>();
+			if ((body == nullptr) || body->reaches_outer()) {
+				return false;
+			}
+			// A function reusing the scope of its caller must not run into the caller's protections.
+			return (callable.type == CommandValue::Type::Macro) || !body_stack.back().scoped || !protects_locals();
 		}
 
 		auto excute_accessing(const CommandASTAccessingNode& accessing, CommandValue* result) -> uint32_t {
@@ -821,16 +718,90 @@ namespace arx
 			if (return_level != 0) {
 				return return_level;
 			}
+			access(value, result);
+			return 0;
+		}
+
+		auto excute_self(const CommandASTSelfNode& self, CommandValue* result) -> uint32_t {
+			if (result != nullptr) {
+				get_self(self.length, result);
+			}
+			return 0;
+		}
+
+		auto excute_loop(const CommandASTLoopNode& loop, CommandValue* result) -> uint32_t {
+			body_at(loop.length);
+			if (loop.argument != nullptr) {
+				CommandValue argument;
+				auto return_level = excute_expression(*(loop.argument), &argument);
+				if (return_level != 0) {
+					return return_level;
+				}
+				return require_loop(loop.length, &argument);
+			}
+			return require_loop(loop.length, nullptr);
+		}
+
+	public: // operations shared by the tree walker and `CommandMachine`.
+		auto read_identifier(uint32_t symbol, CommandValue* result) -> void {
+			auto binding = find_binding(symbol);
+			auto& value = binding != nullptr ? binding->value : bind(symbol, CommandValue{ CommandValue::Type::Empty, true });
+			if (result != nullptr) {
+				*result = value;
+			}
+		}
+
+		auto find_local_or_insert(uint32_t symbol) -> CommandValue& {
+			auto binding = find_binding(symbol);
+			if (binding == nullptr || binding->depth != top_depth()) {
+				return bind(symbol, CommandValue{ CommandValue::Type::Empty, true });
+			}
+			auto protection = find_protection(symbol);
+			if (protection != nullptr && protection->depth == top_depth()) {
+				throw CommandException("cannot assign to protected identifier `{}`.", symbols.name(symbol));
+			}
+			return binding->value;
+		}
+
+		auto protect_identifier(uint32_t symbol, CommandValue* result) -> void {
+			auto [identifier, _] = find_identifier_or_throw(symbol);
+			protect(symbol);
+			if (result != nullptr) {
+				*result = identifier;
+			}
+		}
+
+		auto delete_identifier(uint32_t symbol, CommandValue* result) -> void {
+			auto binding = find_binding(symbol);
+			if (binding == nullptr ? find_protection(symbol) != nullptr : is_protected(symbol, binding->depth)) {
+				throw CommandException("`{}` is protected, cannot delete it.", symbols.name(symbol));
+			}
+			if (binding == nullptr) {
+				throw CommandException("Cannot delete a non-existing identifier {}.", symbols.name(symbol));
+			}
+			auto value = std::move(binding->value); // released now, a dead binding may stay below live ones until its scope is popped.
+			if (result != nullptr) {
+				*result = std::move(value);
+			}
+			binding_heads[symbol] = binding->previous;
+			binding->alive = false;
+			while (bindings.size() > scope_stack.back().binding_base && !bindings.back().alive) {
+				bindings.pop_back();
+			}
+		}
+
+		auto access(const CommandValue& value, CommandValue* result) -> void {
 			switch (value.type)
 			{
 			case CommandValue::Type::String: {
-				return excute_identifier(CommandASTIdentifierNode::make(std::get<std::string>(value.value)), result);
+				read_identifier(symbols.intern(value.as_string()), result);
+				break;
 			}
 			case CommandValue::Type::Function: {
 				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Macro, value.value };
+					*result = value.retyped(CommandValue::Type::Macro);
 				}
-				return 0;
+				break;
 			}
 			default:
 				throw CommandException("{} value type is not accessible.", to_string(value.type));
@@ -838,35 +809,155 @@ namespace arx
 			}
 		}
 
-		auto excute_self(const CommandASTSelfNode& self, CommandValue* result) -> uint32_t {
-			if (result != nullptr) {
-				if (self.length > body_stack.size()) {
-					throw CommandException("Body doesn't exist.");
+		/// <summary>
+		/// The body `length` levels up, or nullptr if a call in tail position replaced it.
+		/// Replaced bodies still count as levels, so that tail calls don't change which body a level reaches.
+		/// </summary>
+		auto body_at(uint32_t length) -> BodyFrame* {
+			for (auto frame = body_stack.rbegin(); frame != body_stack.rend(); ++frame) {
+				if (length == 1) {
+					return &*frame;
+				}
+				if (length <= 1 + frame->replaced) {
+					return nullptr;
 				}
-				auto skip = self.length - 1;
-				*result = CommandValue{ CommandValue::Type::Function, *(body_stack.rbegin()[skip].self)};
+				length -= 1 + frame->replaced;
 			}
+			throw CommandException("Body doesn't exist.");
+		}
+
+		// The body `length` levels up, whose arguments, callee and restart are lost if a call in tail position replaced it.
+		auto existing_body(uint32_t length) -> BodyFrame& {
+			auto target_stack = body_at(length);
+			if (target_stack == nullptr) {
+				throw CommandException("Body was replaced by a call in tail position.");
+			}
+			return *target_stack;
+		}
+
+		auto pull_argument(uint32_t length, CommandValue* result) -> uint32_t {
+			auto& target_stack = existing_body(length);
+			auto arguments = target_stack.arguments();
+			if (target_stack.index >= arguments.size()) {
+				return return_from(length, CommandValue{ CommandValue::Type::Empty, true });
+			}
+
+			if (result != nullptr) {
+				*result = arguments[target_stack.index];
+			}
+			++target_stack.index;
 			return 0;
 		}
 
-		auto excute_loop(const CommandASTLoopNode& loop, CommandValue* result) -> uint32_t {
-			if (loop.length > body_stack.size()) {
-				throw CommandException("Body doesn't exist.");
+		/// <summary>
+		/// Sets the return value of the body `length` levels up, which is dropped if a call in tail position replaced that body, as the result of the call would have overwritten it.
+		/// </summary>
+		auto return_from(uint32_t length, CommandValue&& value) -> uint32_t {
+			if (auto target_stack = body_at(length); target_stack != nullptr) {
+				target_stack->return_value = std::move(value);
 			}
-			if (loop.argument != nullptr) {
-				CommandValue argument;
-				auto return_level = excute_expression(*(loop.argument), &argument);
-				if (return_level != 0) {
-					return return_level;
-				}
-				auto skip = loop.length - 1;
-				auto& target_stack = body_stack.rbegin()[skip];
+			return length;
+		}
+
+		auto get_self(uint32_t length, CommandValue* result) -> void {
+			*result = existing_body(length).callee().retyped(CommandValue::Type::Function);
+		}
+
+		/// <summary>
+		/// Marks the body `length` levels up to be restarted, optionally with `argument` as its new arguments.
+		/// </summary>
+		auto require_loop(uint32_t length, CommandValue* argument) -> uint32_t {
+			auto& target_stack = existing_body(length);
+			if (argument != nullptr) {
 				target_stack.index = 0;
-				target_stack.owned_arguments = std::make_shared<std::vector<CommandValue>>(argument.type == CommandValue::Type::List ? std::move(std::get<std::vector<CommandValue>>(argument.value)) : std::vector{ argument });
-				target_stack.arguments = target_stack.owned_arguments.get();
+				target_stack.owned_arguments = std::move(*argument);
+				target_stack.owned = true;
 			}
 			requiring_loop = true;
-			return loop.length;
+			return length;
+		}
+
+		// The argument spread into `arguments`, for natives which take it as passed.
+		static auto gathered(CommandValue::Arguments arguments) -> CommandValue {
+			if (arguments.size() == 1 && arguments[0].type != CommandValue::Type::List) {
+				return arguments[0];
+			}
+			return CommandValue{ CommandValue::Type::List, CommandValue::List{ arguments.begin(), arguments.end() } };
+		}
+
+		// Bodies of the tree walker are excuted with `callable` as their `self` rather than a copy of their closure.
+		// `call` has pushed a scope for them if `callable` is a function.
+		auto invoke(const CommandValue& callable, CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+			auto& function = callable.as_function();
+			if (auto body = function.target<body_callable>(); body != nullptr) {
+				return body->excute(arguments, &callable, callable.type == CommandValue::Type::Function, result);
+			}
+			auto sample = profiler.enabled ? profiler.enter(profiler.builtin(callable)) : CommandProfiler::none;
+			auto return_level = callable.is_native() ? callable.call_native(gathered(arguments), result) : function(arguments, result);
+			profiler.unwind(sample);
+			return return_level;
+		}
+
+		/// <summary>
+		/// Calls a function or a macro, or indexes a list. Return levels from the callee never propagate to the caller.
+		/// </summary>
+		auto call(const CommandValue& callable, const CommandValue& argument, CommandValue* result) -> void {
+			if ((callable.type == CommandValue::Type::Function || callable.type == CommandValue::Type::Macro) && callable.is_native()) {
+				auto sample = profiler.enabled ? profiler.enter(profiler.builtin(callable)) : CommandProfiler::none;
+				callable.call_native(argument, result); // bound builtins can't see a scope.
+				profiler.unwind(sample);
+				return;
+			}
+			if (callable.type != CommandValue::Type::List) {
+				call(callable, argument.as_arguments(), result);
+				return;
+			}
+			if (argument.type != CommandValue::Type::Number) {
+				throw CommandException("Index must be a number.");
+			}
+			auto size = callable.list_size();
+			auto index = argument.as_integer();
+			if ((index < -static_cast<int64_t>(size)) || (index >= static_cast<int64_t>(size))) {
+				throw CommandException("Index({}) out of range(-{}..{}).", index, size, size);
+			}
+			if (index < 0) {
+				index += size;
+			}
+			if (result != nullptr) {
+				*result = callable.is_packed() ? CommandValue{ CommandValue::Type::Number, callable.as_numbers()[index] } : callable.as_list()[index];
+			}
+		}
+
+		/// <summary>
+		/// Calls a function or a macro with arguments already spread, as builtins calling back into scripts do.
+		/// </summary>
+		auto call(const CommandValue& callable, CommandValue::Arguments arguments, CommandValue* result) -> void {
+			switch (callable.type)
+			{
+			case CommandValue::Type::Function: {
+				if (callable.is_native()) {
+					invoke(callable, arguments, result);
+					break;
+				}
+				if (scope_depth + 1 >= 1000) {
+					throw CommandException("Stack overflow.");
+				}
+				push_scope();
+
+				invoke(callable, arguments, result);
+
+				pop_scope();
+
+				break;
+			}
+			case CommandValue::Type::Macro: {
+				invoke(callable, arguments, result);
+				break;
+			}
+			default: {
+				throw CommandException("{} is not callable.", to_string(callable.type));
+			}
+			}
 		}
 
 	public: // get assignables.
@@ -914,10 +1005,15 @@ namespace arx
 			if (return_level != 0) {
 				throw CommandException("Cannot return from assignable");
 			}
+			return refer_index(callable, is_protected, argument);
+		}
+
+		auto refer_index(CommandValue& callable, bool is_protected, const CommandValue& argument) -> std::pair<CommandValue&, bool> {
 			if (callable.type == CommandValue::Type::List) {
-				auto& list = std::get<std::vector<CommandValue>>(callable.value);
+				auto& list = callable.as_list_mut();
+				collector.track(callable);
 				if (argument.type == CommandValue::Type::Number) {
-					auto index = std::llround(std::get<float>(argument.value));
+					auto index = argument.as_integer();
 					if ((index < -static_cast<int64_t>(list.size())) || (index >= static_cast<int64_t>(list.size()))) {
 						throw CommandException("Index({}) out of range(-{}..{}).", index, list.size(), list.size());
 					}
@@ -943,7 +1039,7 @@ namespace arx
 					throw CommandException("Cannot return from assignable");
 				}
 			}
-			if ((condition_result.type == CommandValue::Type::Empty) && (!std::get<bool>(condition_result.value))) {
+			if ((condition_result.type == CommandValue::Type::Empty) && (!condition_result.as_boolean())) {
 				if (condition.false_branch != nullptr) {
 					return get_assignable(*(condition.false_branch));
 				}
@@ -962,9 +1058,12 @@ namespace arx
 		}
 
 		auto get_assignable_from_protection(const CommandASTProtectionNode& protection) -> std::pair<CommandValue&, bool> {
-			auto name = get_identifier(*(protection.target));
-			auto [assignable, is_protected] = find_identifier_or_insert(name);
-			scope_stack.back().protections.insert(name);
+			return refer_protection(symbols.intern(get_identifier(*(protection.target))));
+		}
+
+		auto refer_protection(uint32_t symbol) -> std::pair<CommandValue&, bool> {
+			auto [assignable, is_protected] = find_identifier_or_insert(symbol);
+			protect(symbol);
 			return { assignable, is_protected };
 		}
 
@@ -974,10 +1073,14 @@ namespace arx
 			if (return_level != 0) {
 				throw CommandException("Cannot return from assignable");
 			}
+			return refer_access(value);
+		}
+
+		auto refer_access(const CommandValue& value) -> std::pair<CommandValue&, bool> {
 			switch (value.type)
 			{
 			case CommandValue::Type::String: {
-				return get_assignable_from_identifier(CommandASTIdentifierNode::make(std::get<std::string>(value.value)));
+				return find_identifier_or_insert(value.as_string());
 			}
 			default:
 				throw CommandException("{} value type is not accessible.", to_string(value.type));
@@ -1022,7 +1125,7 @@ namespace arx
 					throw CommandException("Cannot return from assignable");
 				}
 			}
-			if ((condition_result.type == CommandValue::Type::Empty) && (!std::get<bool>(condition_result.value))) {
+			if ((condition_result.type == CommandValue::Type::Empty) && (!condition_result.as_boolean())) {
 				if (condition.false_branch != nullptr) {
 					return get_identifier(*(condition.false_branch));
 				}
@@ -1049,7 +1152,7 @@ namespace arx
 			switch (value.type)
 			{
 			case CommandValue::Type::String: {
-				return std::get<std::string>(value.value);
+				return value.as_string();
 			}
 			default:
 				throw CommandException("{} value type is not accessible.", to_string(value.type));
@@ -1057,9 +1160,98 @@ namespace arx
 			}
 		}
 
+	public: // analyses.
+		// Whether a body refers to bodies other than its own (`>>`, `<<`, `$$`, `%%`), nested function bodies are their own bodies.
+		static auto reaches_outer(const std::vector<CommandASTStatementNode>& body) -> bool {
+			for (auto& statement : body) {
+				if ((statement.type == CommandASTStatementNode::Type::Expression) && reaches_outer(std::get<CommandASTExpressionNode>(statement.value))) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static auto reaches_outer(const std::unique_ptr<CommandASTExpressionNode>& expression) -> bool {
+			return (expression != nullptr) && reaches_outer(*expression);
+		}
+
+		static auto reaches_outer(const CommandASTExpressionNode& expression) -> bool {
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Operation: {
+				for (auto& operand : std::get<CommandASTOperationNode>(expression.value).operands) {
+					if (reaches_outer(operand)) {
+						return true;
+					}
+				}
+				return false;
+			}
+			case CommandASTExpressionNode::Type::List: {
+				for (auto& element : std::get<CommandASTListNode>(expression.value).expressions) {
+					if (reaches_outer(element)) {
+						return true;
+					}
+				}
+				return false;
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				return reaches_outer(std::get<CommandASTParenthesesNode>(expression.value).expression);
+			}
+			case CommandASTExpressionNode::Type::Calling: {
+				auto& calling = std::get<CommandASTCallingNode>(expression.value);
+				return reaches_outer(calling.callable) || reaches_outer(calling.argument);
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression.value);
+				return reaches_outer(condition.condition) || reaches_outer(condition.true_branch) || reaches_outer(condition.false_branch);
+			}
+			case CommandASTExpressionNode::Type::Assignment: {
+				auto& assignment = std::get<CommandASTAssignmentNode>(expression.value);
+				return reaches_outer(assignment.target) || reaches_outer(assignment.expression);
+			}
+			case CommandASTExpressionNode::Type::Protection: {
+				return reaches_outer(std::get<CommandASTProtectionNode>(expression.value).target);
+			}
+			case CommandASTExpressionNode::Type::Delete: {
+				return reaches_outer(std::get<CommandASTDeleteNode>(expression.value).target);
+			}
+			case CommandASTExpressionNode::Type::Argument: {
+				return std::get<CommandASTArgumentNode>(expression.value).length > 1;
+			}
+			case CommandASTExpressionNode::Type::Return: {
+				auto& returning = std::get<CommandASTReturnNode>(expression.value);
+				return (returning.length > 1) || reaches_outer(returning.expression);
+			}
+			case CommandASTExpressionNode::Type::Self: {
+				return std::get<CommandASTSelfNode>(expression.value).length > 1;
+			}
+			case CommandASTExpressionNode::Type::Loop: {
+				auto& loop = std::get<CommandASTLoopNode>(expression.value);
+				return (loop.length > 1) || reaches_outer(loop.argument);
+			}
+			case CommandASTExpressionNode::Type::Accessing: {
+				return reaches_outer(std::get<CommandASTAccessingNode>(expression.value).expression);
+			}
+			default:
+				return false;
+			}
+		}
+
 		CommandKernel() {
 			scope_stack.reserve(1000);
 			//body_stack.reserve(1000);
 		}
+
+		// Shares the symbols of other kernels, so they can run the same compiled code.
+		CommandKernel(std::shared_ptr<CommandSymbolTable> symbols) : CommandKernel{ } {
+			this->symbols.table = std::move(symbols);
+		}
+
+		~CommandKernel() {
+			bindings.clear();
+			body_stack.clear();
+			tail_callee = CommandValue{ };
+			tail_argument = CommandValue{ };
+			collector.collect();
+		}
 	};
 }
\ No newline at end of file
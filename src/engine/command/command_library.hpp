@@ -6,13 +6,26 @@ namespace arx
 	{
 		std::unordered_map<std::string, CommandValue> variables;
 
-		auto add_function(const std::string& name, const std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>& function) -> void {
+		auto add_function(const std::string& name, const CommandValue::Function& function) -> void {
 			variables[name] = CommandValue(CommandValue::Type::Function, function);
 		}
-		auto add_macro(const std::string& name, const std::function<uint32_t(const std::vector<CommandValue>&, CommandValue*)>& function) -> void {
+		auto add_macro(const std::string& name, const CommandValue::Function& function) -> void {
 			variables[name] = CommandValue(CommandValue::Type::Macro , function);
 		}
 
+		/// <summary>
+		/// Adds a function made of typed C++ overloads, e.g. `bind("sin", [](double x) { return std::sin(x); })`,
+		/// whose argument checks and conversions are derived from their signatures. See `CommandNativeFunction`.
+		/// </summary>
+		template<typename... F>
+		auto bind(const std::string& name, F&&... overloads) -> void {
+			using Bound = CommandNativeFunction<std::decay_t<F>...>;
+			CommandValue value{ CommandValue::Type::Function, CommandValue::Function{ Bound{ name, { std::forward<F>(overloads)... } } } };
+			value.function_object->native = &Bound::call;
+			value.function_object->native_target = value.function_object->function.template target<Bound>();
+			variables[name] = std::move(value);
+		}
+
 		auto load_to(CommandKernel& kernel) -> std::vector<CommandValue> {
 			std::vector<CommandValue> failed_identifiers;
 			for (auto& [name, value] : variables) {
@@ -24,18 +37,17 @@ namespace arx
 			return failed_identifiers;
 		}
 
-		static auto basic_library(std::istream& input, std::ostream& output, CommandKernel& kernel, bool& exit) -> CommandLibrary {
+		static auto basic_library(std::istream& input, CommandSink& sink, CommandKernel& kernel, bool& exit) -> CommandLibrary {
 			CommandLibrary library;
-			library.add_function("print", [&output](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				for (const auto& argument : arguments) {
-					output << argument.to_string() << std::endl;
-				}
+			library.add_function("print", [&sink](CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+				sink.write(arguments);
 				if (result != nullptr) {
 					*result = CommandValue{ CommandValue::Type::Empty, true };
 				}
 				return 0;
 			});
-			library.add_function("read", [&input](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
+			library.add_function("read", [&input, &sink](CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+				sink.flush(); // what was printed before, like a prompt, is seen before waiting.
 				std::string line;
 				std::getline(input, line);
 				if (result != nullptr) {
@@ -43,24 +55,28 @@ namespace arx
 				}
 				return 0;
 			});
-			library.add_function("exit", [&exit](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
+			library.add_function("exit", [&exit](CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
 				exit = true;
 				if (result != nullptr) {
 					*result = CommandValue{ CommandValue::Type::Empty, true };
 				}
 				return 0;
 			});
-			library.add_macro("math", [&kernel](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				auto math = math_library();
-				auto failed_identifiers = math.load_to(kernel);
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::List, std::move(failed_identifiers) };
+			library.add_macro("math", importing(kernel, "math", [] { return math_library(); }));
+			library.add_macro("string", importing(kernel, "string", [] { return string_library(); }));
+			library.add_macro("list", importing(kernel, "list", [&kernel] { return list_library(kernel); }));
+			library.add_macro("import", [&kernel](CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+				if (!kernel.importer) {
+					throw CommandException("`import` needs a runtime to find modules");
+				}
+				CommandValue::List failed_identifiers;
+				for (auto& argument : arguments) {
+					if (argument.type != CommandValue::Type::String) {
+						throw CommandException("`import` takes names of modules as arguments");
+					}
+					auto failed = kernel.importer(argument.as_string());
+					failed_identifiers.insert(failed_identifiers.end(), std::make_move_iterator(failed.begin()), std::make_move_iterator(failed.end()));
 				}
-				return 0;
-			});
-			library.add_macro("string", [&kernel](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				auto string = string_library();
-				auto failed_identifiers = string.load_to(kernel);
 				if (result != nullptr) {
 					*result = CommandValue{ CommandValue::Type::List, std::move(failed_identifiers) };
 				}
@@ -71,282 +87,319 @@ namespace arx
 
 		static auto math_library() -> CommandLibrary {
 			CommandLibrary library;
-			library.add_function("abs", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`abs` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`abs` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::abs(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
-			});
-			library.add_function("round", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`round` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`round` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::round(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
-			});
-			library.add_function("floor", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`floor` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`floor` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::floor(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
-			});
-			library.add_function("ceil", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`ceil` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`ceil` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::ceil(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
+			auto itself = [](int64_t x) { return x; };
+			library.bind_integral("abs", [](int64_t x) {
+				return x != std::numeric_limits<int64_t>::min() ? CommandValue::from_integer(std::abs(x)) : CommandValue{ CommandValue::Type::Number, -static_cast<double>(x) };
+			}, [](double x) { return std::abs(x); });
+			library.bind_integral("round", itself, [](double x) { return std::round(x); });
+			library.bind_integral("floor", itself, [](double x) { return std::floor(x); });
+			library.bind_integral("ceil", itself, [](double x) { return std::ceil(x); });
+			library.bind_integral("sign", [](int64_t x) { return x >= 0; }, [](double x) { return !std::signbit(x); });
+			library.bind("sin", [](double x) { return std::sin(x); });
+			library.bind("cos", [](double x) { return std::cos(x); });
+			library.bind("tan", [](double x) { return std::tan(x); });
+			library.bind("asin", [](double x) { return std::asin(x); });
+			library.bind("acos", [](double x) { return std::acos(x); });
+			library.bind("atan", [](double x) { return std::atan(x); }, [](double y, double x) { return std::atan2(y, x); });
+			library.bind("log", [](double x) { return std::log(x); }, [](double x, double base) { return std::log(x) / std::log(base); });
+			library.bind("log2", [](double x) { return std::log2(x); });
+			library.bind("log10", [](double x) { return std::log10(x); });
+			library.bind("ln", [](double x) { return std::log(x); });
+			return library;
+		}
+
+		static auto string_library() -> CommandLibrary {
+			CommandLibrary library;
+			library.bind("split", [](const std::string& string, const std::string& delimiter) {
+				CommandValue::List parts;
+				size_t start = 0;
+				size_t end = 0;
+				while (!delimiter.empty() && (end = string.find(delimiter, start)) != std::string::npos) {
+					parts.emplace_back(CommandValue::Type::String, string.substr(start, end - start));
+					start = end + delimiter.length();
+				}
+				parts.emplace_back(CommandValue::Type::String, string.substr(start));
+				return parts;
 			});
-			library.add_function("sign", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`sign` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`sign` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Empty, !std::signbit(std::get<float>(arguments[0].value)) };
+			library.bind("join", [](const CommandValue::List& list, const std::string& delimiter) {
+				std::string joined;
+				for (size_t i = 0; i < list.size(); ++i) {
+					if (i != 0) {
+						joined += delimiter;
+					}
+					joined += list[i].to_string();
 				}
-				return 0;
+				return joined;
 			});
-			library.add_function("sin", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`sin` takes exactly one argument");
+			library.bind("parse", [](const std::string& string) {
+				int64_t integer = 0;
+				if (auto [end, error] = std::from_chars(string.data(), string.data() + string.size(), integer); error == std::errc{ } && end == string.data() + string.size()) {
+					return CommandValue::from_integer(integer);
 				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`sin` takes a number as argument");
+				try {
+					return CommandValue{ CommandValue::Type::Number, std::stod(string) };
 				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::sin(std::get<float>(arguments[0].value)) };
+				catch (std::invalid_argument&) {
+					throw CommandException("`parse` could not parse string \"{}\" to a number.", string);
 				}
-				return 0;
 			});
-			library.add_function("cos", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`cos` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`cos` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::cos(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
+			return library;
+		}
+
+		/// <summary>
+		/// Operations on whole lists. `pack` and the element-wise functions make packed lists, `map` and `filter` keep a packed list packed,
+		/// and packed lists are worked on as float arrays. `sum` and `dot` add in double, and give integers for lists of integers.
+		/// </summary>
+		static auto list_library(CommandKernel& kernel) -> CommandLibrary {
+			CommandLibrary library;
+			library.bind("pack", [](const CommandNumbers& list) { // `pack a`, `pack(1, 2, 3)`.
+				auto numbers = list.floats();
+				return std::vector<float>(numbers.begin(), numbers.end());
 			});
-			library.add_function("tan", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`tan` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`tan` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::tan(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
+			library.bind("sum", [](const CommandNumbers& list) {
+				return list.is_packed() ? CommandValue{ CommandValue::Type::Number, sum_of(list.packed) } : sum_of(list.values);
 			});
-			library.add_function("asin", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`asin` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`asin` takes a number as argument");
+			library.bind("dot", [](const CommandNumbers& left, const CommandNumbers& right) {
+				if (left.size() != right.size()) {
+					throw CommandException("`dot` takes lists of the same length, got {} and {}", left.size(), right.size());
 				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::asin(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
+				return dot_of(left, right);
 			});
-			library.add_function("acos", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`acos` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`acos` takes a number as argument");
-				}
+			library.bind_elementwise("add", [](float a, float b) { return a + b; });
+			library.bind_elementwise("subtract", [](float a, float b) { return a - b; });
+			library.bind_elementwise("multiply", [](float a, float b) { return a * b; });
+			library.bind_elementwise("divide", [](float a, float b) { return a / b; });
+			library.add_function("map", [&kernel](CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+				if (arguments.size() != 2) {
+					throw CommandException("`map` takes exactly two arguments");
+				}
+				auto [list, callable] = list_and_callable("map", arguments);
+				CommandValue::List mapped;
+				mapped.reserve(list.list_size());
+				for_each_element(list, [&](const CommandValue& element) {
+					kernel.call(callable, element, &mapped.emplace_back());
+				});
 				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::acos(std::get<float>(arguments[0].value)) };
+					*result = list.is_packed() ? packed_if_numbers(std::move(mapped)) : CommandValue{ CommandValue::Type::List, std::move(mapped) };
 				}
 				return 0;
 			});
-			library.add_function("atan", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() == 1) {
-					if (arguments[0].type != CommandValue::Type::Number) {
-						throw CommandException("`atan` takes a number as argument");
-					}
-					if (result != nullptr) {
-						*result = CommandValue{ CommandValue::Type::Number, std::atan(std::get<float>(arguments[0].value)) };
-					}
-				}
-				else if (arguments.size() == 2) {
-					if (arguments[0].type != CommandValue::Type::Number) {
-						throw CommandException("`atan` takes a number as argument");
-					}
-					if (arguments[1].type != CommandValue::Type::Number) {
-						throw CommandException("`atan` takes a number as argument");
-					}
-					if (result != nullptr) {
-						*result = CommandValue{ CommandValue::Type::Number, std::atan2(std::get<float>(arguments[0].value), std::get<float>(arguments[1].value)) };
-					}
-				}
-				else {
-					throw CommandException("`atan` takes one or two arguments");
-				}
-				return 0;
-			});
-			library.add_function("log", [](const std::vector<CommandValue>& arguments, CommandValue* result)->uint32_t {
-				if (arguments.size() == 1) {
-					if (arguments[0].type != CommandValue::Type::Number) {
-						throw CommandException("`log` takes a number as argument");
-					}
-					if (result != nullptr) {
-						*result = CommandValue{ CommandValue::Type::Number, std::log(std::get<float>(arguments[0].value)) };
-					}
-				}
-				else if (arguments.size() == 2) {
-					if (arguments[0].type != CommandValue::Type::Number) {
-						throw CommandException("`log` takes a number as argument");
-					}
-					if (arguments[1].type != CommandValue::Type::Number) {
-						throw CommandException("`log` takes a number as argument");
-					}
-					if (result != nullptr) {
-						*result = CommandValue{ CommandValue::Type::Number, std::log(std::get<float>(arguments[0].value)) / std::log(std::get<float>(arguments[1].value)) };
+			library.add_function("filter", [&kernel](CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+				if (arguments.size() != 2) {
+					throw CommandException("`filter` takes exactly two arguments");
+				}
+				auto [list, callable] = list_and_callable("filter", arguments);
+				CommandValue::List kept;
+				for_each_element(list, [&](const CommandValue& element) {
+					CommandValue keeping;
+					kernel.call(callable, element, &keeping);
+					if (keeping.type != CommandValue::Type::Empty || keeping.as_boolean()) {
+						kept.push_back(element);
 					}
-				}
-				else {
-					throw CommandException("`log` takes one or two arguments");
-				}
-				return 0;
-			});
-			library.add_function("log2", [](const std::vector<CommandValue>& arguments, CommandValue* result)->uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`log2` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`log2` takes a number as argument");
-				}
-				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::log2(std::get<float>(arguments[0].value)) };
-				}
-				return 0;
-			});
-			library.add_function("log10", [](const std::vector<CommandValue>& arguments, CommandValue* result)->uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`log10` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`log10` takes a number as argument");
-				}
+				});
 				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::log10(std::get<float>(arguments[0].value)) };
+					*result = list.is_packed() ? packed_if_numbers(std::move(kept)) : CommandValue{ CommandValue::Type::List, std::move(kept) };
 				}
 				return 0;
 			});
-			library.add_function("ln", [](const std::vector<CommandValue>& arguments, CommandValue* result)->uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`ln` takes exactly one argument");
-				}
-				if (arguments[0].type != CommandValue::Type::Number) {
-					throw CommandException("`ln` takes a number as argument");
-				}
+			library.add_function("reduce", [&kernel](CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+				if (arguments.size() != 2 && arguments.size() != 3) {
+					throw CommandException("`reduce` takes two or three arguments");
+				}
+				auto [list, callable] = list_and_callable("reduce", arguments);
+				if (arguments.size() == 2 && list.list_size() == 0) {
+					throw CommandException("`reduce` of an empty list takes an initial value as third argument");
+				}
+				std::optional<CommandValue> accumulated;
+				if (arguments.size() == 3) {
+					accumulated = arguments[2];
+				}
+				for_each_element(list, [&](const CommandValue& element) {
+					if (!accumulated) {
+						accumulated = element;
+						return;
+					}
+					CommandValue pair[2] = { std::move(*accumulated), element };
+					kernel.call(callable, CommandValue::Arguments{ pair }, &*accumulated);
+				});
 				if (result != nullptr) {
-					*result = CommandValue{ CommandValue::Type::Number, std::log(std::get<float>(arguments[0].value)) };
+					*result = std::move(*accumulated);
 				}
 				return 0;
 			});
 			return library;
 		}
 
-		static auto string_library() -> CommandLibrary {
-			CommandLibrary library;
-			library.add_function("split", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 2) {
-					throw CommandException("`split` takes exactly two arguments");
-				}
-				if (arguments[0].type != CommandValue::Type::String) {
-					throw CommandException("`split` takes a string as first argument");
-				}
-				if (arguments[1].type != CommandValue::Type::String) {
-					throw CommandException("`split` takes a string as second argument");
-				}
+	private:
+		// A macro importing a built-in module through the kernel's importer, or building the library on each call for a kernel without one.
+		template<typename F>
+		static auto importing(CommandKernel& kernel, std::string name, F build) -> CommandValue::Function {
+			return [&kernel, name = std::move(name), build](CommandValue::Arguments, CommandValue* result) -> uint32_t {
+				auto failed_identifiers = kernel.importer ? kernel.importer(name) : build().load_to(kernel);
 				if (result != nullptr) {
-					std::string string = std::get<std::string>(arguments[0].value);
-					std::string delimiter = std::get<std::string>(arguments[1].value);
-					std::vector<CommandValue> result_vector;
-					size_t pos = 0;
-					std::string token;
-					while ((pos = string.find(delimiter)) != std::string::npos) {
-						token = string.substr(0, pos);
-						result_vector.push_back(CommandValue{ CommandValue::Type::String, token });
-						string.erase(0, pos + delimiter.length());
-					}
-					result_vector.push_back(CommandValue{ CommandValue::Type::String, string });
-					*result = CommandValue{ CommandValue::Type::List, std::move(result_vector) };
+					*result = CommandValue{ CommandValue::Type::List, std::move(failed_identifiers) };
 				}
 				return 0;
+			};
+		}
+
+		// `f(x)` of a number, integers going through `on_integer` rather than a double, as `abs(-123456789)` is exactly `123456789`.
+		template<typename I, typename D>
+		auto bind_integral(const std::string& name, I on_integer, D on_number) -> void {
+			bind(name, [name, on_integer, on_number](const CommandValue& x) {
+				if (x.type != CommandValue::Type::Number) {
+					throw CommandException("`{}` takes a number as argument", name);
+				}
+				return x.is_integer() ? to_command_value(on_integer(x.integer)) : to_command_value(on_number(x.number));
 			});
-			library.add_function("join", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 2) {
-					throw CommandException("`join` takes exactly two arguments");
-				}
-				if (arguments[0].type != CommandValue::Type::List) {
-					throw CommandException("`join` takes a list as first argument");
-				}
-				if (arguments[1].type != CommandValue::Type::String) {
-					throw CommandException("`join` takes a string as second argument");
-				}
-				if (result != nullptr) {
-					std::string delimiter = std::get<std::string>(arguments[1].value);
-					std::string result_string;
-					for (const auto& value : std::get<std::vector<CommandValue>>(arguments[0].value)) {
-						result_string += value.to_string() + delimiter;
-					}
-					result_string.erase(result_string.length() - delimiter.length());
-					*result = CommandValue{ CommandValue::Type::String, std::move(result_string) };
-				}
-				return 0;
+		}
+
+		// `f(a, b)` between the elements of two lists of numbers of the same length, or between a list and a number.
+		template<typename F>
+		auto bind_elementwise(const std::string& name, F operation) -> void {
+			bind(name, [name, operation](const CommandNumbers& left, const CommandNumbers& right) {
+				if (left.size() != right.size()) {
+					throw CommandException("`{}` takes lists of the same length, got {} and {}", name, left.size(), right.size());
+				}
+				auto left_numbers = left.floats();
+				auto right_numbers = right.floats();
+				std::vector<float> result(left.size());
+				for (size_t i = 0; i < result.size(); ++i) {
+					result[i] = operation(left_numbers[i], right_numbers[i]);
+				}
+				return result;
+			}, [operation](const CommandNumbers& left, float right) {
+				auto left_numbers = left.floats();
+				std::vector<float> result(left.size());
+				for (size_t i = 0; i < result.size(); ++i) {
+					result[i] = operation(left_numbers[i], right);
+				}
+				return result;
+			}, [operation](float left, const CommandNumbers& right) {
+				auto right_numbers = right.floats();
+				std::vector<float> result(right.size());
+				for (size_t i = 0; i < result.size(); ++i) {
+					result[i] = operation(left, right_numbers[i]);
+				}
+				return result;
 			});
-			library.add_function("parse", [](const std::vector<CommandValue>& arguments, CommandValue* result) -> uint32_t {
-				if (arguments.size() != 1) {
-					throw CommandException("`parse` takes exactly one argument");
+		}
+
+		// Summed in independent lanes, so the loop isn't bound by the latency of a single accumulator and can be vectorized,
+		// in double so that long arrays don't lose the small elements.
+		static auto sum_of(std::span<const float> numbers) -> double {
+			constexpr size_t lanes = 8;
+			double partial[lanes] = { };
+			size_t i = 0;
+			for (; i + lanes <= numbers.size(); i += lanes) {
+				for (size_t lane = 0; lane < lanes; ++lane) {
+					partial[lane] += numbers[i + lane];
 				}
-				if (arguments[0].type != CommandValue::Type::String) {
-					throw CommandException("`parse` takes a string as argument");
+			}
+			double sum = 0;
+			for (auto lane : partial) {
+				sum += lane;
+			}
+			for (; i < numbers.size(); ++i) {
+				sum += numbers[i];
+			}
+			return sum;
+		}
+
+		// Added as with `+`, integers staying exact until one of the values isn't an integer or the sum overflows, the rest in double.
+		static auto sum_of(std::span<const CommandValue> values) -> CommandValue {
+			auto sum = CommandValue::from_integer(0);
+			size_t i = 0;
+			for (; i < values.size() && sum.is_integer(); ++i) {
+				sum = sum + values[i];
+			}
+			if (sum.is_integer()) {
+				return sum;
+			}
+			auto rest = sum.as_number();
+			for (; i < values.size(); ++i) {
+				rest += values[i].as_number();
+			}
+			return CommandValue{ CommandValue::Type::Number, rest };
+		}
+
+		static auto dot_of(std::span<const float> left, std::span<const float> right) -> double {
+			constexpr size_t lanes = 8;
+			double partial[lanes] = { };
+			size_t i = 0;
+			for (; i + lanes <= left.size(); i += lanes) {
+				for (size_t lane = 0; lane < lanes; ++lane) {
+					partial[lane] += static_cast<double>(left[i + lane]) * right[i + lane];
 				}
-				if (result != nullptr) {
-					try {
-						*result = CommandValue{ CommandValue::Type::Number, std::stof(std::get<std::string>(arguments[0].value)) };
-					}
-					catch (std::invalid_argument&) {
-						throw CommandException("`parse` could not parse string \"{}\" to a number.", std::get<std::string>(arguments[0].value));
-					}
+			}
+			double dot = 0;
+			for (auto lane : partial) {
+				dot += lane;
+			}
+			for (; i < left.size(); ++i) {
+				dot += static_cast<double>(left[i]) * right[i];
+			}
+			return dot;
+		}
+
+		// Two lists of integers give an exact integer unless it overflows, as with `+` and `*`.
+		static auto dot_of(const CommandNumbers& left, const CommandNumbers& right) -> CommandValue {
+			if (left.is_packed() && right.is_packed()) {
+				return CommandValue{ CommandValue::Type::Number, dot_of(left.packed, right.packed) };
+			}
+			size_t i = 0;
+			double rest = 0;
+			if (!left.is_packed() && !right.is_packed()) {
+				auto dot = CommandValue::from_integer(0);
+				for (; i < left.size() && dot.is_integer(); ++i) {
+					dot = dot + left.values[i] * right.values[i];
 				}
-				return 0;
-			});
-			return library;
+				if (dot.is_integer()) {
+					return dot;
+				}
+				rest = dot.as_number();
+			}
+			for (; i < left.size(); ++i) {
+				rest += left.number(i) * right.number(i);
+			}
+			return CommandValue{ CommandValue::Type::Number, rest };
+		}
+
+		// Copies of the list and the callable, which stay alive whatever the callable does to the values they came from.
+		static auto list_and_callable(std::string_view name, CommandValue::Arguments arguments) -> std::pair<CommandValue, CommandValue> {
+			if (arguments[0].type != CommandValue::Type::List) {
+				throw CommandException("`{}` takes a list as first argument", name);
+			}
+			if (arguments[1].type != CommandValue::Type::Function && arguments[1].type != CommandValue::Type::Macro) {
+				throw CommandException("`{}` takes a function as second argument", name);
+			}
+			return { arguments[0], arguments[1] };
+		}
+
+		// Elements of a packed list are passed as numbers without unpacking it.
+		template<typename F>
+		static auto for_each_element(const CommandValue& list, F&& action) -> void {
+			if (list.is_packed()) {
+				for (auto number : list.as_numbers()) {
+					action(CommandValue{ CommandValue::Type::Number, number });
+				}
+				return;
+			}
+			for (auto& element : list.as_list()) {
+				action(element);
+			}
+		}
+
+		static auto packed_if_numbers(CommandValue::List&& list) -> CommandValue {
+			if (!std::all_of(list.begin(), list.end(), [](const CommandValue& element) { return element.type == CommandValue::Type::Number; })) {
+				return CommandValue{ CommandValue::Type::List, std::move(list) };
+			}
+			std::vector<float> numbers;
+			numbers.reserve(list.size());
+			for (auto& element : list) {
+				numbers.push_back(element.as_number());
+			}
+			return CommandValue::packed(std::move(numbers));
 		}
 	};
 }
\ No newline at end of file
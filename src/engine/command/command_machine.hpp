@@ -0,0 +1,601 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Excutes chunks compiled by `CommandCompiler` against the identifiers and bodies of a `CommandKernel`.
+	/// Calls between compiled functions are excuted inside one dispatch loop instead of recursing natively,
+	/// other callables (libraries, tree walker functions) are called through `CommandKernel::call`.
+	/// A compiled callee called in tail position replaces the frame of its caller, so tail recursion runs in constant memory.
+	/// A chunk may also be excuted in slices (`excute_sliced`, `resume`): it's suspended once the budget of the slice is exhausted,
+	/// between two bodies or two rounds of a loop, and resumed where it stopped on the next slice.
+	/// Callees of libraries run to completion, since they are called on the native stack.
+	/// In `Mode::Reference`, statements are excuted by the tree walking `CommandKernel` instead, which is kept for cross-checking.
+	/// </summary>
+	struct CommandMachine
+	{
+		enum class Mode
+		{
+			Compiled,
+			Reference,
+		};
+
+		struct Frame {
+			std::shared_ptr<const CommandChunk> chunk;
+			size_t pc = 0;
+			size_t base;
+			size_t reference_base;
+			size_t pinned_base;
+			size_t result_register;
+			CommandValue* result;
+			bool body;
+			bool scoped;
+			size_t sample = CommandProfiler::none; // depth of the profiler to unwind to when the frame is popped.
+		};
+
+		struct compiled_callable {
+			std::shared_ptr<const CommandChunk> chunk;
+			CommandMachine* machine;
+			auto operator()(CommandValue::Arguments arguments, CommandValue* result) const -> uint32_t {
+				return machine->invoke(*this, arguments, result);
+			}
+		};
+
+		/// <summary>
+		/// Limits of a slice of excution, 0 meaning no limit.
+		/// </summary>
+		struct Budget {
+			uint64_t instructions = 0;
+			std::chrono::microseconds time{ 0 };
+		};
+
+		static constexpr size_t no_register = std::numeric_limits<size_t>::max();
+		static constexpr size_t max_frames = 1 << 16;
+
+		CommandKernel& kernel;
+		CommandCompiler compiler;
+		Mode mode = Mode::Compiled;
+
+		std::vector<CommandValue> registers;
+		std::vector<std::pair<CommandValue*, bool>> references;
+		std::vector<Frame> frames;
+		// Callees and arguments of running calls, `BodyFrame` points into them.
+		// Slots above `pinned_top` are kept and reused instead of being popped, so calls don't allocate once it has grown.
+		std::deque<CommandValue> pinned;
+		size_t pinned_top = 0;
+
+		uint64_t excuted_count = 0; // instructions excuted since the machine was created.
+
+		CommandMachine(CommandKernel& kernel) : kernel{ kernel }, compiler{ kernel.symbols } {
+			registers.reserve(1024);
+			frames.reserve(64);
+		}
+
+		auto operator<<(const CommandASTStatementNode& statement) -> CommandMachine& {
+			excute_statement(statement);
+			return *this;
+		}
+
+		auto excute_statement(const CommandASTStatementNode& statement) -> uint32_t {
+			if (kernel.profiler.enabled) {
+				kernel.profiler.scan(statement);
+			}
+			if (mode == Mode::Reference) {
+				return kernel.excute_statement(statement);
+			}
+			return excute(compiler.compile(statement));
+		}
+
+		auto excute(std::shared_ptr<const CommandChunk> chunk) -> uint32_t {
+			push_frame(std::move(chunk), no_register, nullptr, false, false, pinned_top);
+			return run(frames.size() - 1);
+		}
+
+		/// <summary>
+		/// Starts the budget of a slice, it's shared by every `excute_sliced` and `resume` until the next slice.
+		/// </summary>
+		auto begin_slice(const Budget& budget) -> void {
+			slice_end = budget.instructions == 0 ? std::numeric_limits<uint64_t>::max() : excuted_count + budget.instructions;
+			timed = budget.time.count() != 0;
+			deadline = std::chrono::steady_clock::now() + budget.time;
+			next_clock_check = excuted_count + clock_interval;
+		}
+
+		auto exhausted() -> bool {
+			if (excuted_count >= slice_end) {
+				return true;
+			}
+			if (timed && excuted_count >= next_clock_check) {
+				next_clock_check = excuted_count + clock_interval;
+				return std::chrono::steady_clock::now() >= deadline;
+			}
+			return false;
+		}
+
+		/// <summary>
+		/// As `excute`, but returns `std::nullopt` if the chunk is suspended, after which it must be resumed before excuting anything else.
+		/// </summary>
+		auto excute_sliced(std::shared_ptr<const CommandChunk> chunk) -> std::optional<uint32_t> {
+			push_frame(std::move(chunk), no_register, nullptr, false, false, pinned_top);
+			sliced_floor = frames.size() - 1;
+			return resume();
+		}
+
+		auto resume() -> std::optional<uint32_t> {
+			try {
+				auto level = run(sliced_floor);
+				if (level == suspension) {
+					return std::nullopt;
+				}
+				sliced_floor = no_register;
+				return level;
+			}
+			catch (...) {
+				sliced_floor = no_register;
+				throw;
+			}
+		}
+
+		auto suspended() const -> bool {
+			return sliced_floor != no_register;
+		}
+
+		/// <summary>
+		/// Entry of compiled functions called from outside the dispatch loop, mirrors `body_callable` of the kernel.
+		/// </summary>
+		auto invoke(const compiled_callable& callable, CommandValue::Arguments arguments, CommandValue* result) -> uint32_t {
+			auto pinned_base = pinned_top;
+			auto& self = pin(CommandValue{ CommandValue::Type::Function, CommandValue::Function{ callable } });
+			push_frame(callable.chunk, no_register, result, true, false, pinned_base);
+			kernel.body_stack.emplace_back(arguments, &self);
+			sample_body();
+			return run(frames.size() - 1);
+		}
+
+	private:
+		static constexpr uint32_t suspension = std::numeric_limits<uint32_t>::max(); // returned by `run` instead of a level.
+		static constexpr uint64_t clock_interval = 1024; // instructions between two readings of the clock.
+
+		// The frame excuted in slices, only the `run` of which suspends.
+		size_t sliced_floor = no_register;
+		uint64_t slice_end = std::numeric_limits<uint64_t>::max();
+		uint64_t next_clock_check = 0;
+		std::chrono::steady_clock::time_point deadline;
+		bool timed = false;
+
+		struct Tally {
+			uint64_t& total;
+			uint64_t count = 0;
+			~Tally() {
+				total += count;
+			}
+		};
+
+		auto push_frame(std::shared_ptr<const CommandChunk> chunk, size_t result_register, CommandValue* result, bool body, bool scoped, size_t pinned_base) -> void {
+			if (frames.size() >= max_frames) {
+				throw CommandException("Stack overflow.");
+			}
+			auto base = registers.size();
+			auto reference_base = references.size();
+			registers.resize(base + chunk->register_count);
+			references.resize(reference_base + chunk->reference_count);
+			frames.push_back(Frame{ std::move(chunk), 0, base, reference_base, pinned_base, result_register, result, body, scoped });
+		}
+
+		auto pin(CommandValue&& value) -> CommandValue& {
+			if (pinned_top == pinned.size()) {
+				pinned.emplace_back();
+			}
+			auto& slot = pinned[pinned_top++];
+			slot = std::move(value);
+			return slot;
+		}
+
+		auto unpin(size_t base) -> void {
+			while (pinned_top > base) {
+				pinned[--pinned_top] = CommandValue{ };
+			}
+		}
+
+		auto sample_body() -> void {
+			if (kernel.profiler.enabled) {
+				frames.back().sample = kernel.profiler.enter(profiled_body(frames.back().chunk));
+			}
+		}
+
+		auto profiled_body(const std::shared_ptr<const CommandChunk>& chunk) -> uint32_t {
+			return kernel.profiler.body(chunk, chunk->body.get(), chunk->position);
+		}
+
+		auto pop_frame() -> void {
+			auto& frame = frames.back();
+			kernel.profiler.unwind(frame.sample);
+			if (frame.body) {
+				kernel.body_stack.pop_back();
+				if (frame.scoped) {
+					kernel.pop_scope();
+				}
+			}
+			registers.resize(frame.base);
+			references.resize(frame.reference_base);
+			unpin(frame.pinned_base);
+			frames.pop_back();
+		}
+
+		// Runs until the frame at `floor` completes, returns its return level, or `suspension` if the frame is sliced and the slice is over.
+		auto run(size_t floor) -> uint32_t {
+			try {
+				while (true) {
+					auto level = dispatch();
+					if (level == std::nullopt) { // entered a compiled callee.
+						if (floor == sliced_floor && exhausted()) {
+							return suspension;
+						}
+						continue;
+					}
+					auto& frame = frames.back();
+					if (frame.body) {
+						if ((*level <= 1) && kernel.requiring_loop) {
+							kernel.requiring_loop = false;
+							frame.pc = 0;
+							std::fill(registers.begin() + frame.base, registers.end(), CommandValue{ });
+							if (floor == sliced_floor && exhausted()) {
+								return suspension;
+							}
+							continue;
+						}
+						if (*level <= 1) {
+							auto& return_value = kernel.body_stack.back().return_value;
+							if (frame.result_register != no_register) {
+								registers[frame.result_register] = std::move(return_value);
+							}
+							else if (frame.result != nullptr) {
+								*frame.result = std::move(return_value);
+							}
+						}
+						level = *level == 0 ? 0 : *level - 1;
+					}
+					auto reached_floor = (frames.size() - 1 == floor);
+					pop_frame();
+					if (reached_floor) {
+						return *level;
+					}
+				}
+			}
+			catch (CommandException& exception) {
+				if (frames.size() > floor && frames.back().pc > 0) {
+					exception.locate(frames.back().chunk->positions[frames.back().pc - 1]);
+				}
+				while (frames.size() > floor) {
+					pop_frame();
+				}
+				throw;
+			}
+			catch (...) {
+				while (frames.size() > floor) {
+					pop_frame();
+				}
+				throw;
+			}
+		}
+
+		// Excutes the top frame until it returns or ends, or until a compiled callee is entered (`std::nullopt`).
+		auto dispatch() -> std::optional<uint32_t> {
+			auto* frame = &frames.back();
+			auto& chunk = *(frame->chunk);
+			Tally tally{ excuted_count }; // counted in a register, not in the machine.
+			while (frame->pc < chunk.instructions.size()) {
+				auto& instruction = chunk.instructions[frame->pc++];
+				++tally.count;
+				auto* r = registers.data() + frame->base;
+				auto* refs = references.data() + frame->reference_base;
+				uint32_t level = 0;
+
+				switch (instruction.code) {
+				case CommandInstruction::Code::Empty: {
+					r[instruction.a] = CommandValue{ CommandValue::Type::Empty, instruction.b != 0 };
+					break;
+				}
+				case CommandInstruction::Code::Number: {
+					r[instruction.a] = CommandValue{ CommandValue::Type::Number, chunk.numbers[instruction.b] };
+					break;
+				}
+				case CommandInstruction::Code::Integer: {
+					r[instruction.a] = CommandValue::from_integer(chunk.integers[instruction.b]);
+					break;
+				}
+				case CommandInstruction::Code::String: {
+					r[instruction.a] = CommandValue{ CommandValue::Type::String, chunk.strings[instruction.b] };
+					break;
+				}
+				case CommandInstruction::Code::Identifier: {
+					kernel.read_identifier(instruction.b, &r[instruction.a]);
+					break;
+				}
+				case CommandInstruction::Code::Positive: {
+					r[instruction.a] = +r[instruction.b];
+					break;
+				}
+				case CommandInstruction::Code::Negative: {
+					r[instruction.a] = -r[instruction.b];
+					break;
+				}
+				case CommandInstruction::Code::Not: {
+					r[instruction.a] = !r[instruction.b];
+					break;
+				}
+				case CommandInstruction::Code::Add: {
+					r[instruction.a] = r[instruction.b] + r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::Subtract: {
+					r[instruction.a] = r[instruction.b] - r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::Multiply: {
+					r[instruction.a] = r[instruction.b] * r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::Divide: {
+					r[instruction.a] = r[instruction.b] / r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::Modulo: {
+					r[instruction.a] = r[instruction.b] % r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::Exponent: {
+					r[instruction.a] = r[instruction.b].power(r[instruction.c]);
+					break;
+				}
+				case CommandInstruction::Code::Equal: {
+					r[instruction.a] = r[instruction.b] == r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::NotEqual: {
+					r[instruction.a] = r[instruction.b] != r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::LessThan: {
+					r[instruction.a] = r[instruction.b] < r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::LessThanOrEqual: {
+					r[instruction.a] = r[instruction.b] <= r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::GreaterThan: {
+					r[instruction.a] = r[instruction.b] > r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::GreaterThanOrEqual: {
+					r[instruction.a] = r[instruction.b] >= r[instruction.c];
+					break;
+				}
+				case CommandInstruction::Code::List: {
+					std::vector<CommandValue> list;
+					list.reserve(instruction.c);
+					for (uint32_t i = 0; i < instruction.c; ++i) {
+						list.push_back(std::move(r[instruction.b + i]));
+					}
+					r[instruction.a] = CommandValue{ CommandValue::Type::List, std::move(list) };
+					break;
+				}
+				case CommandInstruction::Code::Call: {
+					if (call(instruction, *frame)) {
+						return std::nullopt;
+					}
+					frame = &frames.back(); // callees may have grown `frames`.
+					break;
+				}
+				case CommandInstruction::Code::TailCall: {
+					if (tail_call(instruction, *frame) || call(instruction, *frame)) {
+						return std::nullopt;
+					}
+					frame = &frames.back();
+					break;
+				}
+				case CommandInstruction::Code::Function: {
+					r[instruction.a] = CommandValue{ CommandValue::Type::Function, CommandValue::Function{ compiled_callable{ chunk.chunks[instruction.b], this } } };
+					break;
+				}
+				case CommandInstruction::Code::Jump: {
+					frame->pc = instruction.a;
+					break;
+				}
+				case CommandInstruction::Code::JumpIfNegative: {
+					auto& condition = r[instruction.a];
+					if ((condition.type == CommandValue::Type::Empty) && (!condition.as_boolean())) {
+						frame->pc = instruction.b;
+					}
+					break;
+				}
+				case CommandInstruction::Code::Argument: {
+					level = kernel.pull_argument(instruction.b, &r[instruction.a]);
+					break;
+				}
+				case CommandInstruction::Code::Return: {
+					level = kernel.return_from(instruction.b, std::move(r[instruction.a]));
+					break;
+				}
+				case CommandInstruction::Code::Self: {
+					kernel.get_self(instruction.b, &r[instruction.a]);
+					break;
+				}
+				case CommandInstruction::Code::Loop: {
+					level = kernel.require_loop(instruction.b, instruction.c != 0 ? &r[instruction.a] : nullptr);
+					break;
+				}
+				case CommandInstruction::Code::Access: {
+					kernel.access(r[instruction.b], &r[instruction.a]);
+					break;
+				}
+				case CommandInstruction::Code::Protect: {
+					kernel.protect_identifier(symbol_of(instruction, r), &r[instruction.a]);
+					break;
+				}
+				case CommandInstruction::Code::Delete: {
+					kernel.delete_identifier(symbol_of(instruction, r), &r[instruction.a]);
+					break;
+				}
+				case CommandInstruction::Code::ReferIdentifier: {
+					auto [value, is_protected] = kernel.find_identifier_or_insert(instruction.b);
+					refs[instruction.a] = { &value, is_protected };
+					break;
+				}
+				case CommandInstruction::Code::ReferLocal: {
+					refs[instruction.a] = { &kernel.find_local_or_insert(symbol_of(instruction, r)), false };
+					break;
+				}
+				case CommandInstruction::Code::ReferProtection: {
+					auto [value, is_protected] = kernel.refer_protection(symbol_of(instruction, r));
+					refs[instruction.a] = { &value, is_protected };
+					break;
+				}
+				case CommandInstruction::Code::ReferIndex: {
+					auto [list, list_protected] = refs[instruction.b];
+					auto [value, is_protected] = kernel.refer_index(*list, list_protected, r[instruction.c]);
+					refs[instruction.a] = { &value, is_protected };
+					break;
+				}
+				case CommandInstruction::Code::ReferAccess: {
+					auto [value, is_protected] = kernel.refer_access(r[instruction.b]);
+					refs[instruction.a] = { &value, is_protected };
+					break;
+				}
+				case CommandInstruction::Code::Guard: {
+					if (refs[instruction.a].second) {
+						throw CommandException("cannot assign to protected identifier.");
+					}
+					break;
+				}
+				case CommandInstruction::Code::Load: {
+					r[instruction.a] = *(refs[instruction.b].first);
+					break;
+				}
+				case CommandInstruction::Code::Store: {
+					auto& target = *(refs[instruction.b].first);
+					target = std::move(r[instruction.c]);
+					if (!(instruction.flags & CommandInstruction::discarded)) {
+						r[instruction.a] = target;
+					}
+					break;
+				}
+				case CommandInstruction::Code::Throw: {
+					throw CommandException(chunk.strings[instruction.a]);
+				}
+				default: {
+					throw CommandException("Unknown instruction.");
+				}
+				}
+
+				if (level != 0) {
+					if (instruction.flags & CommandInstruction::guarded) {
+						throw CommandException("Cannot return from assignable");
+					}
+					return level;
+				}
+			}
+			return 0;
+		}
+
+		auto symbol_of(const CommandInstruction& instruction, const CommandValue* r) -> uint32_t {
+			if (instruction.c == 0) {
+				return instruction.b;
+			}
+			auto& name = r[instruction.b];
+			if (name.type != CommandValue::Type::String) { // only a damaged archive holds anything else.
+				throw CommandException("{} value cannot be evaluated to an identifier.", to_string(name.type));
+			}
+			return kernel.symbols.intern(name.as_string());
+		}
+
+		// Returns true if the callee replaced the body of `frame`, in which case `frame` restarts with the callee's chunk.
+		// Its scope is kept for the callee, unless it's a macro body's which isn't its own, or a function would run into its protections.
+		auto tail_call(const CommandInstruction& instruction, Frame& frame) -> bool {
+			auto& callee = registers[frame.base + instruction.b];
+			if (!frame.body || ((callee.type != CommandValue::Type::Function) && (callee.type != CommandValue::Type::Macro))) {
+				return false;
+			}
+			auto compiled = callee.as_function().target<compiled_callable>();
+			if ((compiled == nullptr) || (compiled->machine != this) || compiled->chunk->reaches_outer) {
+				return false;
+			}
+			auto function = callee.type == CommandValue::Type::Function;
+			if (function && frame.scoped && kernel.protects_locals()) {
+				return false;
+			}
+			if (function && !frame.scoped && (kernel.scope_depth + 1 >= 1000)) {
+				throw CommandException("Stack overflow.");
+			}
+
+			auto chunk = compiled->chunk;
+			CommandValue moved_callee = std::move(callee);
+			CommandValue moved_argument = std::move(registers[frame.base + instruction.c]);
+			unpin(frame.pinned_base);
+			auto& pinned_callee = pin(std::move(moved_callee));
+			auto& pinned_argument = pin(std::move(moved_argument));
+
+			registers.resize(frame.base);
+			registers.resize(frame.base + chunk->register_count);
+			references.resize(frame.reference_base);
+			references.resize(frame.reference_base + chunk->reference_count);
+			frame.chunk = std::move(chunk);
+			frame.pc = 0;
+			if (frame.sample != CommandProfiler::none) {
+				kernel.profiler.unwind(frame.sample);
+				kernel.profiler.enter(profiled_body(frame.chunk));
+			}
+			if (function && !frame.scoped) {
+				kernel.push_scope();
+				frame.scoped = true;
+			}
+			auto replaced = kernel.body_stack.back().replaced + 1;
+			kernel.body_stack.back() = CommandKernel::BodyFrame{ pinned_argument.as_arguments(), &pinned_callee };
+			kernel.body_stack.back().replaced = replaced;
+			return true;
+		}
+
+		// Returns true if a compiled callee was entered as a new frame.
+		auto call(const CommandInstruction& instruction, Frame& frame) -> bool {
+			auto destination = frame.base + instruction.a;
+			if (auto& native = registers[frame.base + instruction.b]; (native.type == CommandValue::Type::Function || native.type == CommandValue::Type::Macro) && native.is_native()) {
+				// Bound builtins don't reenter the machine, so the registers stay where they are, and nothing needs pinning.
+				CommandValue result;
+				auto sample = kernel.profiler.enabled ? kernel.profiler.enter(kernel.profiler.builtin(native)) : CommandProfiler::none;
+				native.call_native(registers[frame.base + instruction.c], &result);
+				kernel.profiler.unwind(sample);
+				registers[destination] = std::move(result);
+				return false;
+			}
+			auto pinned_base = pinned_top;
+			auto& callee = pin(std::move(registers[frame.base + instruction.b]));
+			auto& argument = pin(std::move(registers[frame.base + instruction.c]));
+			registers[destination] = CommandValue{ CommandValue::Type::Empty, true };
+
+			const compiled_callable* compiled = nullptr;
+			if (callee.type == CommandValue::Type::Function || callee.type == CommandValue::Type::Macro) {
+				compiled = callee.as_function().target<compiled_callable>();
+			}
+			if (compiled == nullptr || compiled->machine != this) {
+				CommandValue result;
+				kernel.call(callee, argument, &result);
+				registers[destination] = std::move(result);
+				unpin(pinned_base);
+				return false;
+			}
+
+			auto scoped = callee.type == CommandValue::Type::Function;
+			if (scoped && kernel.scope_depth + 1 >= 1000) {
+				throw CommandException("Stack overflow.");
+			}
+			push_frame(compiled->chunk, destination, nullptr, true, scoped, pinned_base);
+			if (scoped) {
+				kernel.push_scope();
+			}
+			kernel.body_stack.emplace_back(argument.as_arguments(), &callee); // `pinned` keeps both alive until the frame is popped.
+			sample_body();
+			return true;
+		}
+	};
+}
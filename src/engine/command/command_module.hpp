@@ -0,0 +1,100 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// A library built once and imported by name into the scope of any kernel.
+	/// It's made of values shared by every kernel, of a factory for libraries which refer to their kernel,
+	/// or of a script parsed from a `.arx` file, whose statements are excuted in the importing scope.
+	/// </summary>
+	struct CommandModule
+	{
+		std::string name;
+		std::vector<std::pair<std::string, CommandValue>> values;
+		std::function<CommandLibrary(CommandKernel&)> factory;
+		std::shared_ptr<const CommandScript> script;
+	};
+
+	/// <summary>
+	/// Modules by name. Modules added up front are immutable and shared, those found as `<name>.arx` in `search_paths`
+	/// are parsed the first time they are imported. It may be shared by runtimes on different threads.
+	/// </summary>
+	struct CommandModuleRegistry
+	{
+		std::vector<std::filesystem::path> search_paths;
+
+		auto add(const std::string& name, CommandLibrary&& library) -> void {
+			auto module = std::make_shared<CommandModule>();
+			module->name = name;
+			for (auto& [identifier, value] : library.variables) {
+				module->values.emplace_back(identifier, std::move(value));
+			}
+			insert(std::move(module));
+		}
+
+		auto add(const std::string& name, std::function<CommandLibrary(CommandKernel&)> factory) -> void {
+			auto module = std::make_shared<CommandModule>();
+			module->name = name;
+			module->factory = std::move(factory);
+			insert(std::move(module));
+		}
+
+		auto add_source(const std::string& name, std::string_view code) -> void {
+			std::lock_guard lock{ mutex };
+			modules[name] = parse(name, code);
+		}
+
+		/// <summary>
+		/// The module of `name`, loaded from the search paths if it isn't known yet, or `nullptr`.
+		/// </summary>
+		auto find(const std::string& name) -> std::shared_ptr<const CommandModule> {
+			std::lock_guard lock{ mutex };
+			if (auto found = modules.find(name); found != modules.end()) {
+				return found->second;
+			}
+			for (auto& directory : search_paths) {
+				std::ifstream file{ directory / (name + ".arx") };
+				if (file.is_open()) {
+					std::stringstream code;
+					code << file.rdbuf();
+					auto module = parse(name, code.str());
+					modules.emplace(name, module);
+					return module;
+				}
+			}
+			return nullptr;
+		}
+
+		/// <summary>
+		/// The registry of the built-in libraries, `math`, `string` and `list`, used by runtimes unless they're given another one.
+		/// </summary>
+		static auto standard() -> CommandModuleRegistry& {
+			static auto registry = [] {
+				auto registry = std::make_unique<CommandModuleRegistry>();
+				registry->add("math", CommandLibrary::math_library());
+				registry->add("string", CommandLibrary::string_library());
+				registry->add("list", &CommandLibrary::list_library);
+				return registry;
+			}();
+			return *registry;
+		}
+
+	private:
+		auto insert(std::shared_ptr<CommandModule>&& module) -> void {
+			std::lock_guard lock{ mutex };
+			auto name = module->name;
+			modules[name] = std::move(module);
+		}
+
+		auto parse(const std::string& name, std::string_view code) -> std::shared_ptr<CommandModule> {
+			auto module = std::make_shared<CommandModule>();
+			module->name = name;
+			module->script = parser.parse(code);
+			return module;
+		}
+
+		std::unordered_map<std::string, std::shared_ptr<const CommandModule>> modules;
+		CommandScriptParser parser;
+		std::mutex mutex;
+	};
+}
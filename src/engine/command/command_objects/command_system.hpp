@@ -17,15 +17,49 @@ namespace arx
 			mobilized = false;
 		}
 		auto update() -> void {
-			if (mobilized && (commands != "")) {
-				command_runtime->run_code(commands);
-				commands = "";
+			if (mobilized) {
+				// Statements changed in watched files are excuted like commands, on the runtime's thread or within the budget.
+				for (auto& code : watcher.poll()) {
+					commands.push_back(std::move(code));
+				}
+			}
+			if (mobilized && command_runtime->working()) {
+				// Scripts run on the runtime's thread, the frame only hands commands over and applies the effects they posted.
+				for (auto& command : commands) {
+					command_runtime->submit(std::move(command));
+				}
+				commands.clear();
+				command_runtime->drain();
+			}
+			else if (mobilized && (!commands.empty() || command_runtime->pending())) {
+				// Commands are queued one by one rather than joined, so a command sent again is found in the runtime's cache.
+				for (auto& command : commands) {
+					command_runtime->start(command);
+				}
+				commands.clear();
+				// What doesn't fit in the budget of this frame is resumed on the next one.
+				command_runtime->resume(budget);
+				command_runtime->sink.flush();
 			}
 		}
 
 	public:
 		auto command(const std::string& command) -> void {
-			commands += command + ' ';
+			commands.push_back(command);
+		}
+
+		/// <summary>
+		/// Excutes a script file on the next `update`, and then the statements of it which change while the system is mobilized, see `CommandWatcher`.
+		/// </summary>
+		auto watch(const std::filesystem::path& path) -> void {
+			watcher.watch(path);
+		}
+
+		/// <summary>
+		/// Whether commands are waiting for a later `update`, either not started yet or suspended once the budget was exhausted.
+		/// </summary>
+		auto pending() const -> bool {
+			return !commands.empty() || command_runtime->pending();
 		}
 
 	public:
@@ -33,7 +67,10 @@ namespace arx
 		}
 
 	public:
-		std::string commands = "";
+		std::vector<std::string> commands;
+		// Excution per `update`, unlimited by default.
+		CommandMachine::Budget budget;
+		CommandWatcher watcher;
 		bool mobilized = false;
 		CommandRuntime* command_runtime;
 	};
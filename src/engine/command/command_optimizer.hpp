@@ -0,0 +1,219 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Rewrites parsed trees in place before they're excuted:
+	/// operations whose operands are all `Number`, `String` or `Empty` literals are folded with the `CommandValue` operators,
+	/// and condition branches whose outcome is known are pruned.
+	/// Operations that would throw are left as they are, so the error is still reported when the statement is excuted.
+	/// </summary>
+	struct CommandOptimizer
+	{
+		auto optimize(CommandASTStatementNode& statement) -> void {
+			if (statement.type == CommandASTStatementNode::Type::Expression) {
+				optimize(std::get<CommandASTExpressionNode>(statement.value));
+			}
+		}
+
+		auto optimize(CommandASTFunctionBodyNode& body) -> void {
+			for (auto& statement : *body.commands) {
+				optimize(statement);
+			}
+		}
+
+		auto optimize(CommandASTExpressionNode& expression) -> void {
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Operation: {
+				auto& operation = std::get<CommandASTOperationNode>(expression.value);
+				for (auto& operand : operation.operands) {
+					optimize(operand);
+				}
+				fold(expression);
+				break;
+			}
+			case CommandASTExpressionNode::Type::List: {
+				for (auto& element : std::get<CommandASTListNode>(expression.value).expressions) {
+					optimize(element);
+				}
+				break;
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				auto& inner = std::get<CommandASTParenthesesNode>(expression.value).expression;
+				optimize(inner);
+				if (constant_of(*inner).has_value()) {
+					replace(expression, std::move(*inner));
+				}
+				break;
+			}
+			case CommandASTExpressionNode::Type::Calling: {
+				auto& calling = std::get<CommandASTCallingNode>(expression.value);
+				optimize(calling.callable);
+				optimize(calling.argument);
+				break;
+			}
+			case CommandASTExpressionNode::Type::FunctionBody: {
+				optimize(std::get<CommandASTFunctionBodyNode>(expression.value));
+				break;
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression.value);
+				optimize(condition.condition);
+				optimize(condition.true_branch);
+				optimize(condition.false_branch);
+				prune(expression);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Assignment: {
+				auto& assignment = std::get<CommandASTAssignmentNode>(expression.value);
+				optimize(assignment.target);
+				optimize(assignment.expression);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Protection: {
+				optimize(std::get<CommandASTProtectionNode>(expression.value).target);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Delete: {
+				optimize(std::get<CommandASTDeleteNode>(expression.value).target);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Return: {
+				optimize(std::get<CommandASTReturnNode>(expression.value).expression);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Loop: {
+				optimize(std::get<CommandASTLoopNode>(expression.value).argument);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Accessing: {
+				optimize(std::get<CommandASTAccessingNode>(expression.value).expression);
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		auto optimize(std::unique_ptr<CommandASTExpressionNode>& expression) -> void {
+			if (expression != nullptr) {
+				optimize(*expression);
+			}
+		}
+
+		/// <summary>
+		/// The value of a literal, or of `(-)` which is how a false `Empty` is written.
+		/// </summary>
+		static auto constant_of(const CommandASTExpressionNode& expression) -> std::optional<CommandValue> {
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Empty: {
+				return CommandValue{ CommandValue::Type::Empty, true };
+			}
+			case CommandASTExpressionNode::Type::Number: {
+				auto& number = std::get<CommandASTNumberNode>(expression.value);
+				return number.integral ? CommandValue::from_integer(number.integer) : CommandValue{ CommandValue::Type::Number, number.value };
+			}
+			case CommandASTExpressionNode::Type::String: {
+				return CommandValue{ CommandValue::Type::String, std::get<CommandASTStringNode>(expression.value).value };
+			}
+			case CommandASTExpressionNode::Type::Operation: {
+				if (is_false_empty(expression)) {
+					return CommandValue{ CommandValue::Type::Empty, false };
+				}
+				return std::nullopt;
+			}
+			default:
+				return std::nullopt;
+			}
+		}
+
+	private:
+		static auto is_false_empty(const CommandASTExpressionNode& expression) -> bool {
+			if (expression.type != CommandASTExpressionNode::Type::Operation) {
+				return false;
+			}
+			auto& operation = std::get<CommandASTOperationNode>(expression.value);
+			return operation.type == CommandASTOperationNode::Type::Negative
+				&& operation.operands.size() == 1
+				&& operation.operands[0].type == CommandASTExpressionNode::Type::Empty;
+		}
+
+		// Replaces an operation on constants with its result.
+		auto fold(CommandASTExpressionNode& expression) -> void {
+			if (is_false_empty(expression)) {
+				return;
+			}
+			auto& operation = std::get<CommandASTOperationNode>(expression.value);
+			if (operation.operands.empty() || operation.operands.size() != operation.operand_count) {
+				return;
+			}
+			std::optional<CommandValue> operands[2];
+			for (size_t i = 0; i < operation.operands.size(); ++i) {
+				operands[i] = constant_of(operation.operands[i]);
+				if (!operands[i].has_value()) {
+					return;
+				}
+			}
+
+			CommandValue value;
+			try {
+				value = operate(operation.type, *operands[0], operands[1].has_value() ? *operands[1] : *operands[0]);
+			}
+			catch (const CommandException&) {
+				return;
+			}
+			auto literal = literal_of(value);
+			if (literal.has_value()) {
+				replace(expression, std::move(*literal));
+			}
+		}
+
+		// Replaces a condition with its branch when the condition is constant and that branch exists.
+		auto prune(CommandASTExpressionNode& expression) -> void {
+			auto& condition = std::get<CommandASTConditionNode>(expression.value);
+			bool taken = true;
+			if (condition.condition != nullptr) {
+				auto value = constant_of(*condition.condition);
+				if (!value.has_value()) {
+					return;
+				}
+				taken = !(value->type == CommandValue::Type::Empty && !value->as_boolean());
+			}
+
+			auto& branch = taken ? condition.true_branch : condition.false_branch;
+			if (branch != nullptr) {
+				replace(expression, std::move(*branch));
+			}
+		}
+
+		static auto literal_of(const CommandValue& value) -> std::optional<CommandASTExpressionNode> {
+			switch (value.type) {
+			case CommandValue::Type::Empty: {
+				if (value.as_boolean()) {
+					return CommandASTExpressionNode::make_empty();
+				}
+				std::vector<CommandASTExpressionNode> operands;
+				operands.push_back(CommandASTExpressionNode::make_empty());
+				return CommandASTExpressionNode::make_operation(CommandASTOperationNode::Type::Negative, 1, std::move(operands));
+			}
+			case CommandValue::Type::Number: {
+				return value.is_integer() ? CommandASTExpressionNode::make_integer(value.integer) : CommandASTExpressionNode::make_number(value.as_number());
+			}
+			case CommandValue::Type::String: {
+				return CommandASTExpressionNode::make_string(value.as_string());
+			}
+			default:
+				return std::nullopt;
+			}
+		}
+
+		// `replacement` may be owned by `expression`, so it's moved out before `expression` is overwritten.
+		static auto replace(CommandASTExpressionNode& expression, CommandASTExpressionNode&& replacement) -> void {
+			CommandASTExpressionNode moved{ std::move(replacement) };
+			if (!moved.position.known()) {
+				moved.position = expression.position;
+			}
+			expression = std::move(moved);
+		}
+	};
+}
@@ -2,73 +2,120 @@
 
 namespace arx
 {
-	struct CommandToken
-	{
-		enum class Type
-		{
-			None,
-			Comment,
-			Name,
-			Number,
-			String,
-			Separator,
-			Operator,
-			Condition,
-			Special,
-			FunctionRelated,
-			Eof,
-		};
-		Type type;
-		std::string value;
-	};
-
-	const std::unordered_map<std::string, int32_t> operator_left_precedence = {
-		{ ";", 0 },
-		{ ":", 0 },
-		{ ",", 2 },
-		{ "?", 2 },
-		{ "==", 3 },
-		{ "!=", 3 },
-		{ "<", 4 },
-		{ ">", 4 },
-		{ "<=", 4 },
-		{ ">=", 4 },
-		{ "+", 5 },
-		{ "-", 5 },
-		{ "*", 6 },
-		{ "/", 6 },
-		{ "%", 6 },
-		{ "^", 8 },
-		{ "=", 9 },
-		{ "f", 9 },
-	};
-
-	const std::unordered_map<std::string, int32_t> operator_right_precedence = {
-		{ "=", 1 },
-		{ "'%", 1 },
-		{ "'<", 1 },
-		{ ",", 1 },
-		{ "?", 1 },
-		{ ":", 1 },
-		{ "==", 3 },
-		{ "!=", 3 },
-		{ "<", 4 },
-		{ ">", 4 },
-		{ "<=", 4 },
-		{ ">=", 4 },
-		{ "+", 5 },
-		{ "-", 5 },
-		{ "*", 6 },
-		{ "/", 6 },
-		{ "%", 6 },
-		{ "'+", 7 },
-		{ "'-", 7 },
-		{ "!", 7 },
-		{ "^", 8 },
-		{ "#", 9 },
-		{ "@", 9 },
-		{ "f", 9 },
-	};
+	inline auto operator_left_precedence(CommandToken::Symbol symbol) -> int32_t {
+		switch (symbol) {
+		case CommandToken::Symbol::Semicolon:
+		case CommandToken::Symbol::Colon:
+			return 0;
+		case CommandToken::Symbol::Comma:
+		case CommandToken::Symbol::Question:
+			return 2;
+		case CommandToken::Symbol::Equal:
+		case CommandToken::Symbol::NotEqual:
+			return 3;
+		case CommandToken::Symbol::LessThan:
+		case CommandToken::Symbol::GreaterThan:
+		case CommandToken::Symbol::LessThanOrEqual:
+		case CommandToken::Symbol::GreaterThanOrEqual:
+			return 4;
+		case CommandToken::Symbol::Add:
+		case CommandToken::Symbol::Subtract:
+			return 5;
+		case CommandToken::Symbol::Multiply:
+		case CommandToken::Symbol::Divide:
+		case CommandToken::Symbol::Modulo:
+			return 6;
+		case CommandToken::Symbol::Exponent:
+			return 8;
+		case CommandToken::Symbol::Assign:
+		case CommandToken::Symbol::Call:
+			return 9;
+		default:
+			return -1; // Doesn't accept operands on its left side.
+		}
+	}
+
+	inline auto operator_right_precedence(CommandToken::Symbol symbol) -> int32_t {
+		switch (symbol) {
+		case CommandToken::Symbol::Assign:
+		case CommandToken::Symbol::Loop:
+		case CommandToken::Symbol::Return:
+		case CommandToken::Symbol::Comma:
+		case CommandToken::Symbol::Question:
+		case CommandToken::Symbol::Colon:
+			return 1;
+		case CommandToken::Symbol::Equal:
+		case CommandToken::Symbol::NotEqual:
+			return 3;
+		case CommandToken::Symbol::LessThan:
+		case CommandToken::Symbol::GreaterThan:
+		case CommandToken::Symbol::LessThanOrEqual:
+		case CommandToken::Symbol::GreaterThanOrEqual:
+			return 4;
+		case CommandToken::Symbol::Add:
+		case CommandToken::Symbol::Subtract:
+			return 5;
+		case CommandToken::Symbol::Multiply:
+		case CommandToken::Symbol::Divide:
+		case CommandToken::Symbol::Modulo:
+			return 6;
+		case CommandToken::Symbol::Positive:
+		case CommandToken::Symbol::Negative:
+		case CommandToken::Symbol::Not:
+			return 7;
+		case CommandToken::Symbol::Exponent:
+			return 8;
+		case CommandToken::Symbol::Delete:
+		case CommandToken::Symbol::Access:
+		case CommandToken::Symbol::Call:
+			return 9;
+		default:
+			return -1; // Doesn't accept operands on its right side.
+		}
+	}
+
+	inline auto to_operation_type(CommandToken::Symbol symbol) -> CommandASTOperationNode::Type {
+		switch (symbol) {
+		case CommandToken::Symbol::Add: return CommandASTOperationNode::Type::Add;
+		case CommandToken::Symbol::Subtract: return CommandASTOperationNode::Type::Subtract;
+		case CommandToken::Symbol::Multiply: return CommandASTOperationNode::Type::Multiply;
+		case CommandToken::Symbol::Divide: return CommandASTOperationNode::Type::Divide;
+		case CommandToken::Symbol::Positive: return CommandASTOperationNode::Type::Positive;
+		case CommandToken::Symbol::Negative: return CommandASTOperationNode::Type::Negative;
+		case CommandToken::Symbol::Modulo: return CommandASTOperationNode::Type::Modulo;
+		case CommandToken::Symbol::Exponent: return CommandASTOperationNode::Type::Exponent;
+		case CommandToken::Symbol::LessThan: return CommandASTOperationNode::Type::LessThan;
+		case CommandToken::Symbol::LessThanOrEqual: return CommandASTOperationNode::Type::LessThanOrEqual;
+		case CommandToken::Symbol::GreaterThan: return CommandASTOperationNode::Type::GreaterThan;
+		case CommandToken::Symbol::GreaterThanOrEqual: return CommandASTOperationNode::Type::GreaterThanOrEqual;
+		case CommandToken::Symbol::Equal: return CommandASTOperationNode::Type::Equal;
+		case CommandToken::Symbol::NotEqual: return CommandASTOperationNode::Type::NotEqual;
+		case CommandToken::Symbol::Not: return CommandASTOperationNode::Type::Not;
+		default: throw CommandException("Unknown operation.");
+		}
+	}
+
+	inline auto to_symbol(CommandASTOperationNode::Type operation) -> CommandToken::Symbol {
+		switch (operation) {
+		case CommandASTOperationNode::Type::Add: return CommandToken::Symbol::Add;
+		case CommandASTOperationNode::Type::Subtract: return CommandToken::Symbol::Subtract;
+		case CommandASTOperationNode::Type::Multiply: return CommandToken::Symbol::Multiply;
+		case CommandASTOperationNode::Type::Divide: return CommandToken::Symbol::Divide;
+		case CommandASTOperationNode::Type::Positive: return CommandToken::Symbol::Positive;
+		case CommandASTOperationNode::Type::Negative: return CommandToken::Symbol::Negative;
+		case CommandASTOperationNode::Type::Modulo: return CommandToken::Symbol::Modulo;
+		case CommandASTOperationNode::Type::Exponent: return CommandToken::Symbol::Exponent;
+		case CommandASTOperationNode::Type::Parentheses: return CommandToken::Symbol::OpenParenthesis;
+		case CommandASTOperationNode::Type::LessThan: return CommandToken::Symbol::LessThan;
+		case CommandASTOperationNode::Type::LessThanOrEqual: return CommandToken::Symbol::LessThanOrEqual;
+		case CommandASTOperationNode::Type::GreaterThan: return CommandToken::Symbol::GreaterThan;
+		case CommandASTOperationNode::Type::GreaterThanOrEqual: return CommandToken::Symbol::GreaterThanOrEqual;
+		case CommandASTOperationNode::Type::Equal: return CommandToken::Symbol::Equal;
+		case CommandASTOperationNode::Type::NotEqual: return CommandToken::Symbol::NotEqual;
+		case CommandASTOperationNode::Type::Not: return CommandToken::Symbol::Not;
+		default: throw CommandException("Unknown operation.");
+		}
+	}
 
 	template<typename I>
 	struct CommandParser
@@ -81,9 +128,114 @@ namespace arx
 		/// <summary>
 		/// Processing node are uncompleted and waiting for their child nodes to be completed.
 		/// </summary>
-		std::stack<CommandASTExpressionNode> processing_nodes;
+		std::vector<CommandASTExpressionNode> processing_nodes;
+
+		/// <summary>
+		/// Heights of `processing_nodes` where function bodies are open, so recovering from an error doesn't search for them.
+		/// </summary>
+		std::vector<size_t> body_heights;
 
 		auto operator<<(const CommandToken& token) -> CommandParser& {
+			if (skipping && !skip(token)) {
+				return *this;
+			}
+			failing = token.symbol;
+			try {
+				parse(token);
+			}
+			catch (CommandException& exception) {
+				exception.locate(token.position);
+				throw;
+			}
+			failing = CommandToken::Symbol::None;
+			return *this;
+		}
+
+		/// <summary>
+		/// Drops the statement an error happened in, so parsing goes on with the next one after its `;`.
+		/// Function bodies the statement is in stay open and are parsed on, but the top level statement containing them
+		/// is dropped when it's complete instead of being excuted.
+		/// Tokens are skipped up to the `;`, unless the error happened on it.
+		/// </summary>
+		auto recover() -> void {
+			if (skipping) {
+				return; // The reader failed on a skipped token.
+			}
+			auto height = body_heights.empty() ? size_t{ 1 } : body_heights.back() + 1;
+			poisoned = height > 1;
+			skipped_depth = 0;
+			for (auto i = height; i < processing_nodes.size(); ++i) {
+				auto type = processing_nodes[i].type;
+				if (type == CommandASTExpressionNode::Type::Parentheses || type == CommandASTExpressionNode::Type::Protection) {
+					++skipped_depth; // their closing brackets are skipped too.
+				}
+			}
+			processing_nodes.erase(processing_nodes.begin() + height, processing_nodes.end());
+			awaiting_expression = CommandASTExpressionNode::make_empty();
+
+			if (failing == CommandToken::Symbol::CloseBrace && !body_heights.empty()) {
+				// The brace closes the innermost body as if the broken statement wasn't there.
+				body_heights.pop_back();
+				submit_top_preceding();
+				skipping = false;
+			}
+			else {
+				skipping = failing != CommandToken::Symbol::Semicolon;
+			}
+			failing = CommandToken::Symbol::None;
+		}
+
+		/// <summary>
+		/// Whether the statements parsed are all complete, with nothing pending.
+		/// </summary>
+		auto complete() const -> bool {
+			return processing_nodes.size() == 1 && awaiting_expression.type == CommandASTExpressionNode::Type::Empty;
+		}
+
+		/// <summary>
+		/// Drops everything parsed, for a new source.
+		/// </summary>
+		auto reset() -> void {
+			processing_nodes.erase(processing_nodes.begin() + 1, processing_nodes.end());
+			body_heights.clear();
+			awaiting_expression = CommandASTExpressionNode::make_empty();
+			skipping = false;
+			poisoned = false;
+			failing = CommandToken::Symbol::None;
+		}
+
+	private:
+		bool skipping = false; // the rest of a broken statement is being skipped.
+		uint32_t skipped_depth = 0;
+		bool poisoned = false; // the top level statement being parsed contains an error.
+		CommandToken::Symbol failing = CommandToken::Symbol::None; // symbol of the token being parsed, still set if parsing it threw.
+
+		// Whether the token ends the skipping and is to be parsed.
+		auto skip(const CommandToken& token) -> bool {
+			switch (token.symbol) {
+			case CommandToken::Symbol::OpenParenthesis:
+			case CommandToken::Symbol::OpenBracket:
+			case CommandToken::Symbol::OpenBrace:
+				++skipped_depth;
+				return false;
+			case CommandToken::Symbol::CloseParenthesis:
+			case CommandToken::Symbol::CloseBracket:
+			case CommandToken::Symbol::CloseBrace:
+				if (skipped_depth == 0) {
+					skipping = false;
+					return true;
+				}
+				--skipped_depth;
+				return false;
+			case CommandToken::Symbol::Semicolon:
+				skipping = skipped_depth != 0;
+				return false;
+			default:
+				return false;
+			}
+		}
+
+		auto parse(const CommandToken& token) -> void {
 			switch (token.type)
 			{
 			case CommandToken::Type::None: {
@@ -128,52 +280,68 @@ namespace arx
 			default:
 				break;
 			}
-			return *this;
 		}
 
+	public:
 		auto parse_name(const CommandToken& token) -> void {
-			submit_expression(CommandASTExpressionNode::make_identifier(token.value));
+			submit_expression(CommandASTExpressionNode::make_identifier(std::string{ token.value }).at(token.position));
 		}
 
+		// Numbers without a fraction are integers, unless they're too large for one.
 		auto parse_number(const CommandToken& token) -> void {
-			float value = std::stof(token.value);
-			submit_expression(CommandASTExpressionNode::make_number(std::stof(token.value)));
+			auto first = token.value.data();
+			auto last = token.value.data() + token.value.size();
+			int64_t integer = 0;
+			if (auto [end, error] = std::from_chars(first, last, integer); error == std::errc{ } && end == last) {
+				submit_expression(CommandASTExpressionNode::make_integer(integer).at(token.position));
+				return;
+			}
+			double value = 0.0;
+			auto [end, error] = std::from_chars(first, last, value);
+			if (error != std::errc{ }) {
+				throw CommandException("Invalid number`{}`.", token.value);
+			}
+			submit_expression(CommandASTExpressionNode::make_number(value).at(token.position));
 		}
 
 		auto parse_string(const CommandToken& token) -> void {
-			submit_expression(CommandASTExpressionNode::make_string(token.value));
+			submit_expression(CommandASTExpressionNode::make_string(CommandReader::unescape(token.value)).at(token.position));
 		}
 
 		auto parse_separator(const CommandToken& token) -> void {
-			if (token.value == "(" || token.value == ")") {
+			switch (token.symbol) {
+			case CommandToken::Symbol::OpenParenthesis:
+			case CommandToken::Symbol::CloseParenthesis:
 				parse_parentheses(token);
-			}
-			else if (token.value == "[" || token.value == "]") {
+				break;
+			case CommandToken::Symbol::OpenBracket:
+			case CommandToken::Symbol::CloseBracket:
 				parse_brackets(token);
-			}
-			else if (token.value == "{" || token.value == "}") {
+				break;
+			case CommandToken::Symbol::OpenBrace:
+			case CommandToken::Symbol::CloseBrace:
 				parse_braces(token);
-			}
-			else if (token.value == ",") {
+				break;
+			case CommandToken::Symbol::Comma:
 				parse_comma(token);
-			}
-			else if (token.value == ";") {
+				break;
+			case CommandToken::Symbol::Semicolon:
 				parse_semicolon(token);
-			}
-			else {
+				break;
+			default:
 				throw CommandException("Unsupported separator token`{}`.", token.value);
 			}
 		}
 
 		auto parse_parentheses(const CommandToken& token) -> void {
-			if (token.value == "(") {
-				open_incomplete_expression(CommandASTExpressionNode::make_parentheses({ }));
+			if (token.symbol == CommandToken::Symbol::OpenParenthesis) {
+				open_incomplete_expression(CommandASTExpressionNode::make_parentheses({ }).at(token.position));
 			}
-			else if (token.value == ")") {
-				submit_preceding_expressions(")");
+			else if (token.symbol == CommandToken::Symbol::CloseParenthesis) {
+				submit_preceding_expressions(CommandToken::Symbol::CloseParenthesis);
 
-				if (processing_nodes.top().type == CommandASTExpressionNode::Type::Parentheses) {
-					auto& parentheses = std::get<CommandASTParenthesesNode>(processing_nodes.top().value);
+				if (processing_nodes.back().type == CommandASTExpressionNode::Type::Parentheses) {
+					auto& parentheses = std::get<CommandASTParenthesesNode>(processing_nodes.back().value);
 
 					parentheses.expression = std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression));
 					awaiting_expression = CommandASTExpressionNode::make_empty();
@@ -189,14 +357,14 @@ namespace arx
 		}
 
 		auto parse_brackets(const CommandToken& token) -> void {
-			if (token.value == "[") {
-				open_incomplete_expression(CommandASTExpressionNode::make_protection(nullptr));
+			if (token.symbol == CommandToken::Symbol::OpenBracket) {
+				open_incomplete_expression(CommandASTExpressionNode::make_protection(nullptr).at(token.position));
 			}
-			else if (token.value == "]") {
-				submit_preceding_expressions("]");
+			else if (token.symbol == CommandToken::Symbol::CloseBracket) {
+				submit_preceding_expressions(CommandToken::Symbol::CloseBracket);
 
-				if (processing_nodes.top().type == CommandASTExpressionNode::Type::Protection) {
-					auto& protection = std::get<CommandASTProtectionNode>(processing_nodes.top().value);
+				if (processing_nodes.back().type == CommandASTExpressionNode::Type::Protection) {
+					auto& protection = std::get<CommandASTProtectionNode>(processing_nodes.back().value);
 
 					protection.target = std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression));
 					awaiting_expression = CommandASTExpressionNode::make_empty();
@@ -212,17 +380,19 @@ namespace arx
 		}
 
 		auto parse_braces(const CommandToken& token) -> void {
-			if (token.value == "{") {
-				open_incomplete_expression(CommandASTExpressionNode::make_function_body({ }));
+			if (token.symbol == CommandToken::Symbol::OpenBrace) {
+				open_incomplete_expression(CommandASTExpressionNode::make_function_body({ }).at(token.position));
+				body_heights.push_back(processing_nodes.size() - 1);
 			}
-			else if (token.value == "}") {
-				submit_preceding_expressions("}");
+			else if (token.symbol == CommandToken::Symbol::CloseBrace) {
+				submit_preceding_expressions(CommandToken::Symbol::CloseBrace);
 
-				if (processing_nodes.top().type == CommandASTExpressionNode::Type::FunctionBody) {
+				if (processing_nodes.back().type == CommandASTExpressionNode::Type::FunctionBody) {
 					if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty) {
 						throw CommandException("Closing function body but there's an incomplete statement.");
 					}
 					awaiting_expression = CommandASTExpressionNode::make_empty();
+					body_heights.pop_back();
 					submit_top_preceding();
 				}
 				else {
@@ -235,15 +405,15 @@ namespace arx
 		}
 
 		auto parse_comma(const CommandToken& token) -> void {
-			submit_preceding_expressions(",");
+			submit_preceding_expressions(CommandToken::Symbol::Comma);
 
-			if (processing_nodes.top().type == CommandASTExpressionNode::Type::List) {
-				auto& list = std::get<CommandASTListNode>(processing_nodes.top().value);
+			if (processing_nodes.back().type == CommandASTExpressionNode::Type::List) {
+				auto& list = std::get<CommandASTListNode>(processing_nodes.back().value);
 				list.expressions.push_back(std::move(awaiting_expression));
 				awaiting_expression = CommandASTExpressionNode::make_empty();
 			}
 			else {
-				auto expression = CommandASTExpressionNode::make_list({ });
+				auto expression = CommandASTExpressionNode::make_list({ }).at(awaiting_expression.position);
 				auto& list = std::get<CommandASTListNode>(expression.value);
 				list.expressions.push_back(std::move(awaiting_expression));
 				awaiting_expression = CommandASTExpressionNode::make_empty();
@@ -252,18 +422,25 @@ namespace arx
 		}
 
 		auto parse_semicolon(const CommandToken& token) -> void {
-			submit_preceding_expressions(";");;
+			submit_preceding_expressions(CommandToken::Symbol::Semicolon);
 
 			CommandASTStatementNode statement{ CommandASTStatementNode::Type::Expression, std::move(awaiting_expression) };
 			awaiting_expression = CommandASTExpressionNode::make_empty();
 
 			if (processing_nodes.size() == 1) {
-				interpreter << statement;
+				if (poisoned) {
+					poisoned = false;
+					return;
+				}
+				if (optimizing) {
+					optimizer.optimize(statement);
+				}
+				interpreter << std::move(statement);
 			}
 			else {
-				if (processing_nodes.top().type == CommandASTExpressionNode::Type::FunctionBody) {
-					auto& function_body = std::get<CommandASTFunctionBodyNode>(processing_nodes.top().value);
-					function_body.commands.push_back(std::move(statement));
+				if (processing_nodes.back().type == CommandASTExpressionNode::Type::FunctionBody) {
+					auto& function_body = std::get<CommandASTFunctionBodyNode>(processing_nodes.back().value);
+					function_body.commands->push_back(std::move(statement));
 				}
 				else {
 					throw CommandException("A Statemet must be at top level of the globe or a function body.");
@@ -272,47 +449,47 @@ namespace arx
 		}
 
 		auto parse_operator(const CommandToken& token) -> void {
-			auto op = token.value;
-			if (op == "=") {
-				submit_preceding_expressions("=");
-				auto assignment = CommandASTExpressionNode::make_assignment(std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)), nullptr);
+			auto op = token.symbol;
+			if (op == CommandToken::Symbol::Assign) {
+				submit_preceding_expressions(CommandToken::Symbol::Assign);
+				auto assignment = CommandASTExpressionNode::make_assignment(std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)), nullptr).at(token.position);
 				awaiting_expression = CommandASTExpressionNode::make_empty();
 				open_incomplete_expression(std::move(assignment));
 			}
-			else if (op == ":=") {
-				submit_preceding_expressions("=");
-				auto assignment = CommandASTExpressionNode::make_assignment(std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)), nullptr, true);
+			else if (op == CommandToken::Symbol::LocalAssign) {
+				submit_preceding_expressions(CommandToken::Symbol::Assign);
+				auto assignment = CommandASTExpressionNode::make_assignment(std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)), nullptr, true).at(token.position);
 				awaiting_expression = CommandASTExpressionNode::make_empty();
 				open_incomplete_expression(std::move(assignment));
 			}
-			else if (op == "!") {
-				open_incomplete_expression(CommandASTExpressionNode::make_operation(to_operation_type(op), 1, { }));
+			else if (op == CommandToken::Symbol::Not) {
+				open_incomplete_expression(CommandASTExpressionNode::make_operation(to_operation_type(op), 1, { }).at(token.position));
 			}
-			else if (op == ">" || op == ">=" || op == "<" || op == "<=" || op == "==" || op == "!= ") {
+			else if (op == CommandToken::Symbol::GreaterThan || op == CommandToken::Symbol::GreaterThanOrEqual || op == CommandToken::Symbol::LessThan || op == CommandToken::Symbol::LessThanOrEqual || op == CommandToken::Symbol::Equal || op == CommandToken::Symbol::NotEqual) {
 				submit_preceding_expressions(op);
-				auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  });
+				auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  }).at(token.position);
 				auto& operation = std::get<CommandASTOperationNode>(expression.value);
 				operation.operands.push_back(std::move(awaiting_expression));
 				awaiting_expression = CommandASTExpressionNode::make_empty();
 				open_incomplete_expression(std::move(expression));
 			}
-			else if (op == "^" || op == "%") {
+			else if (op == CommandToken::Symbol::Exponent || op == CommandToken::Symbol::Modulo) {
 				submit_preceding_expressions(op);
-				auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  });
+				auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  }).at(token.position);
 				auto& operation = std::get<CommandASTOperationNode>(expression.value);
 				operation.operands.push_back(std::move(awaiting_expression));
 				awaiting_expression = CommandASTExpressionNode::make_empty();
 				open_incomplete_expression(std::move(expression));
 			}
-			else if (op == "+" || op == "-") {
+			else if (op == CommandToken::Symbol::Add || op == CommandToken::Symbol::Subtract) {
 				if (awaiting_expression.type == CommandASTExpressionNode::Type::Empty) {
-					op = "'" + op; // '+ and '-
-					open_incomplete_expression(CommandASTExpressionNode::make_operation(to_operation_type(op), 1, { }));
+					op = op == CommandToken::Symbol::Add ? CommandToken::Symbol::Positive : CommandToken::Symbol::Negative; // '+ and '-
+					open_incomplete_expression(CommandASTExpressionNode::make_operation(to_operation_type(op), 1, { }).at(token.position));
 				}
 				else { // + -
 					submit_preceding_expressions(op);
 					if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty) {
-						auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  });
+						auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  }).at(token.position);
 						auto& operation = std::get<CommandASTOperationNode>(expression.value);
 						operation.operands.push_back(std::move(awaiting_expression));
 						awaiting_expression = CommandASTExpressionNode::make_empty();
@@ -323,9 +500,9 @@ namespace arx
 					}
 				}
 			}
-			else if (op == "*" || op == "/") { // * /
+			else if (op == CommandToken::Symbol::Multiply || op == CommandToken::Symbol::Divide) { // * /
 				submit_preceding_expressions(op);
-				auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  });
+				auto expression = CommandASTExpressionNode::make_operation(to_operation_type(op), 2, {  }).at(token.position);
 				auto& operation = std::get<CommandASTOperationNode>(expression.value);
 				operation.operands.push_back(std::move(awaiting_expression));
 				awaiting_expression = CommandASTExpressionNode::make_empty();
@@ -337,16 +514,16 @@ namespace arx
 		}
 
 		auto parse_condition(const CommandToken& token) -> void {
-			auto op = token.value;
-			if (op == "?") {
-				submit_preceding_expressions("?");
-				auto condition = CommandASTExpressionNode::make_condition(std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)), nullptr, nullptr);
+			auto op = token.symbol;
+			if (op == CommandToken::Symbol::Question) {
+				submit_preceding_expressions(CommandToken::Symbol::Question);
+				auto condition = CommandASTExpressionNode::make_condition(std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)), nullptr, nullptr).at(token.position);
 				awaiting_expression = CommandASTExpressionNode::make_empty();
 				open_incomplete_expression(std::move(condition));
 			}
-			else if (op == ":") {
-				submit_preceding_expressions(":");
-				if (processing_nodes.top().type != CommandASTExpressionNode::Type::Condition) {
+			else if (op == CommandToken::Symbol::Colon) {
+				submit_preceding_expressions(CommandToken::Symbol::Colon);
+				if (processing_nodes.back().type != CommandASTExpressionNode::Type::Condition) {
 					throw CommandException("Unexpected Parser Error. No condition awaiting after submitting preceding expressions");
 				}
 			}
@@ -356,11 +533,11 @@ namespace arx
 		}
 
 		auto parse_special(const CommandToken& token) -> void {
-			if (token.value == "#") {
-				open_incomplete_expression(CommandASTExpressionNode::make_delete(nullptr));
+			if (token.symbol == CommandToken::Symbol::Delete) {
+				open_incomplete_expression(CommandASTExpressionNode::make_delete(nullptr).at(token.position));
 			}
-			else if (token.value == "@") {
-				open_incomplete_expression(CommandASTExpressionNode::make_accessing(nullptr));
+			else if (token.symbol == CommandToken::Symbol::Access) {
+				open_incomplete_expression(CommandASTExpressionNode::make_accessing(nullptr).at(token.position));
 			}
 			else {
 				throw CommandException("Unexpected Parser Error: {} is not a special.", token.value);
@@ -368,34 +545,34 @@ namespace arx
 		}
 
 		auto parse_function_related(const CommandToken& token) -> void {
-			if (token.value[0] == '<') {
+			if (token.symbol == CommandToken::Symbol::Return) {
 				if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty && token.value.size() == 1) {
-					parse_operator({ CommandToken::Type::Operator, "<" });
+					parse_operator({ CommandToken::Type::Operator, CommandToken::Symbol::LessThan, token.value, token.position });
 				}
 				else {
 					open_incomplete_expression(CommandASTExpressionNode::make_return(
 						token.value.length(),
 						std::make_unique<CommandASTExpressionNode>(CommandASTExpressionNode::make_empty())
-					));
+					).at(token.position));
 				}
 			}
-			else if (token.value[0] == '>') {
+			else if (token.symbol == CommandToken::Symbol::Argument) {
 				if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty && token.value.size() == 1) {
-					parse_operator({ CommandToken::Type::Operator, ">" });
+					parse_operator({ CommandToken::Type::Operator, CommandToken::Symbol::GreaterThan, token.value, token.position });
 				}
 				else {
-					submit_expression(CommandASTExpressionNode::make_argument(token.value.length()));
+					submit_expression(CommandASTExpressionNode::make_argument(token.value.length()).at(token.position));
 				}
 			}
-			else if (token.value[0] == '$') {
-				submit_expression(CommandASTExpressionNode::make_self(token.value.length()));
+			else if (token.symbol == CommandToken::Symbol::Self) {
+				submit_expression(CommandASTExpressionNode::make_self(token.value.length()).at(token.position));
 			}
-			else if (token.value[0] == '%') {
+			else if (token.symbol == CommandToken::Symbol::Loop) {
 				if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty && token.value.size() == 1) {
-					parse_operator({ CommandToken::Type::Operator, "%" });
+					parse_operator({ CommandToken::Type::Operator, CommandToken::Symbol::Modulo, token.value, token.position });
 				}
 				else {
-					open_incomplete_expression(CommandASTExpressionNode::make_loop(token.value.size(), nullptr));
+					open_incomplete_expression(CommandASTExpressionNode::make_loop(token.value.size(), nullptr).at(token.position));
 				}
 			}
 			else {
@@ -403,20 +580,19 @@ namespace arx
 			}
 		}
 
-		auto submit_preceding_expressions(const std::string& operation) -> uint32_t {
+		auto submit_preceding_expressions(CommandToken::Symbol operation) -> uint32_t {
 			uint32_t count = 0;
 			while (!processing_nodes.empty()) {
-				auto& expression = processing_nodes.top();
+				auto& expression = processing_nodes.back();
 
 				if (expression.type == CommandASTExpressionNode::Type::Operation) {
 					auto& last_operation = std::get<CommandASTOperationNode>(expression.value);
-					auto str_op = to_string(last_operation.type);
-					if (prior_to(operation, str_op)) {
+					if (prior_to(operation, to_symbol(last_operation.type))) {
 						break;
 					}
 
 					if (last_operation.operands.size() >= last_operation.operand_count) {
-						throw CommandException("Unexpect Parser Error: Operator {} can only operate on {} operands.", str_op, last_operation.operand_count);
+						throw CommandException("Unexpect Parser Error: Operator {} can only operate on {} operands.", to_string(last_operation.type), last_operation.operand_count);
 					}
 
 					last_operation.operands.push_back(std::move(awaiting_expression));
@@ -432,14 +608,14 @@ namespace arx
 				else if (expression.type == CommandASTExpressionNode::Type::Condition) {
 					auto& condition = std::get<CommandASTConditionNode>(expression.value);
 					if (condition.true_branch == nullptr && condition.false_branch == nullptr) {
-						auto str_op = "?";
-						if (prior_to(operation, str_op)) {
+						auto left_op = CommandToken::Symbol::Question;
+						if (prior_to(operation, left_op)) {
 							break;
 						}
 
 						condition.true_branch = std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression));
 						awaiting_expression = CommandASTExpressionNode::make_empty();
-						if (operation != ":") {
+						if (operation != CommandToken::Symbol::Colon) {
 							submit_top_preceding();
 							++count;
 						}
@@ -448,8 +624,8 @@ namespace arx
 						}
 					}
 					else if (condition.true_branch != nullptr && condition.false_branch == nullptr) {
-						auto str_op = ":";
-						if (prior_to(operation, str_op)) {
+						auto left_op = CommandToken::Symbol::Colon;
+						if (prior_to(operation, left_op)) {
 							break;
 						}
 						condition.false_branch = std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression));
@@ -463,8 +639,8 @@ namespace arx
 				}
 				else if (expression.type == CommandASTExpressionNode::Type::Assignment) {
 					auto& assignment = std::get<CommandASTAssignmentNode>(expression.value);
-					auto str_op = "=";
-					if (prior_to(operation, str_op)) {
+					auto left_op = CommandToken::Symbol::Assign;
+					if (prior_to(operation, left_op)) {
 						break;
 					}
 
@@ -475,8 +651,8 @@ namespace arx
 				}
 				else if (expression.type == CommandASTExpressionNode::Type::Delete) {
 					auto& del = std::get<CommandASTDeleteNode>(expression.value);
-					auto str_op = "#";
-					if (prior_to(operation, str_op)) {
+					auto left_op = CommandToken::Symbol::Delete;
+					if (prior_to(operation, left_op)) {
 						break;
 					}
 
@@ -492,8 +668,8 @@ namespace arx
 				}
 				else if (expression.type == CommandASTExpressionNode::Type::Accessing) {
 					auto& accessing = std::get<CommandASTAccessingNode>(expression.value);
-					auto str_op = "@";
-					if (prior_to(operation, str_op)) {
+					auto left_op = CommandToken::Symbol::Access;
+					if (prior_to(operation, left_op)) {
 						break;
 					}
 
@@ -504,8 +680,8 @@ namespace arx
 				}
 				else if (expression.type == CommandASTExpressionNode::Type::Return) {
 					auto& ret = std::get<CommandASTReturnNode>(expression.value);
-					auto str_op = "'<";
-					if (prior_to(operation, str_op)) {
+					auto left_op = CommandToken::Symbol::Return;
+					if (prior_to(operation, left_op)) {
 						break;
 					}
 
@@ -516,8 +692,8 @@ namespace arx
 				}
 				else if (expression.type == CommandASTExpressionNode::Type::List) {
 					auto& list = std::get<CommandASTListNode>(expression.value);
-					auto str_op = ",";
-					if (prior_to(operation, str_op)) {
+					auto left_op = CommandToken::Symbol::Comma;
+					if (prior_to(operation, left_op)) {
 						break;
 					}
 
@@ -530,8 +706,8 @@ namespace arx
 				}
 				else if (expression.type == CommandASTExpressionNode::Type::Calling) {
 					auto& calling = std::get<CommandASTCallingNode>(expression.value);
-					auto str_op = "f";
-					if (prior_to(operation, str_op)) {
+					auto left_op = CommandToken::Symbol::Call;
+					if (prior_to(operation, left_op)) {
 						break;
 					}
 
@@ -542,8 +718,8 @@ namespace arx
 				}
 				else if (expression.type == CommandASTExpressionNode::Type::Loop) {
 					auto& loop = std::get<CommandASTLoopNode>(expression.value);
-					auto str_op = "'%";
-					if (prior_to(operation, str_op)) {
+					auto left_op = CommandToken::Symbol::Loop;
+					if (prior_to(operation, left_op)) {
 						break;
 					}
 					if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty) {
@@ -560,43 +736,47 @@ namespace arx
 			return count;
 		}
 
-		auto prior_to(const std::string& right_op, const std::string& left_op) -> bool {
-			if (!operator_left_precedence.contains(right_op)) {
+		auto prior_to(CommandToken::Symbol right_op, CommandToken::Symbol left_op) -> bool {
+			auto left_precedence = operator_left_precedence(right_op);
+			if (left_precedence < 0) {
 				// throw CommandException("Operator`{}` is not supported to accept operants on it's left side.", a);
 				return false;
 			}
-			if (!operator_right_precedence.contains(left_op)) {
+			auto right_precedence = operator_right_precedence(left_op);
+			if (right_precedence < 0) {
 				// throw CommandException("Operator`{}` is not supported to accept operants on it's right side.", b);
 				return true;
 			}
-			return operator_left_precedence.at(right_op) > operator_right_precedence.at(left_op);
+			return left_precedence > right_precedence;
 		}
 
 		auto open_incomplete_expression(CommandASTExpressionNode&& expression) -> void {
 			if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty) {
-				submit_preceding_expressions("f");
+				submit_preceding_expressions(CommandToken::Symbol::Call);
 				if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty) {
-					processing_nodes.push(CommandASTExpressionNode::make_calling(
+					auto position = awaiting_expression.position;
+					processing_nodes.push_back(CommandASTExpressionNode::make_calling(
 						std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)),
 						nullptr
-					));
+					).at(position));
 					awaiting_expression = CommandASTExpressionNode::make_empty();
 				}
 				else {
 					throw CommandException("Unexpected Parser Error. No expression awaiting after submitting preceding expressions");
 				}
 			}
-			processing_nodes.push(std::move(expression));
+			processing_nodes.push_back(std::move(expression));
 		}
 
 		auto submit_expression(CommandASTExpressionNode&& expression) -> void {
 			if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty) { // Turn the previous expression into a function call.
-				submit_preceding_expressions("f");
+				submit_preceding_expressions(CommandToken::Symbol::Call);
 				if (awaiting_expression.type != CommandASTExpressionNode::Type::Empty) {
-					processing_nodes.push(CommandASTExpressionNode::make_calling(
+					auto position = awaiting_expression.position;
+					processing_nodes.push_back(CommandASTExpressionNode::make_calling(
 						std::make_unique<CommandASTExpressionNode>(std::move(awaiting_expression)),
 						{ }
-					));
+					).at(position));
 				}
 				else {
 					throw CommandException("Unexpected Parser Error. No expression awaiting after submitting preceding expressions");
@@ -608,8 +788,8 @@ namespace arx
 		auto submit_top_preceding() -> void {
 			if (!processing_nodes.empty()) {
 				if (awaiting_expression.type == CommandASTExpressionNode::Type::Empty) {
-					awaiting_expression = std::move(processing_nodes.top());
-					processing_nodes.pop();
+					awaiting_expression = std::move(processing_nodes.back());
+					processing_nodes.pop_back();
 				}
 				else {
 					throw CommandException("Awaiting expression must be empty when submitting top preceding expression.");
@@ -617,288 +797,58 @@ namespace arx
 			}
 		}
 
-		CommandParser(I& interpreter) : interpreter(interpreter), awaiting_expression(CommandASTExpressionNode::make_empty()) {
-			processing_nodes.push(CommandASTExpressionNode::make_empty());
+		CommandParser(I& interpreter) : awaiting_expression(CommandASTExpressionNode::make_empty()), interpreter(interpreter) {
+			processing_nodes.push_back(CommandASTExpressionNode::make_empty());
 		}
 
 		I& interpreter;
+		CommandOptimizer optimizer;
+		bool optimizing = true; // Fold constants of top level statements before handing them to the interpreter.
 	};
 
+	/// <summary>
+	/// Feeds tokens from a `CommandReader` to the parser.
+	/// `feed` takes source text as a stream, tokens may span the fed pieces, and `finish` ends the stream.
+	/// </summary>
 	template<typename I>
 	struct CommandLexer
 	{
-		auto get_tokens(CommandParser<I>& parser, const std::string& input) {
-			for (auto iter = input.begin(); iter != input.end(); ++iter) {
-				char c = *iter;
-				if (is_empty(c) || is_eof(c)) {
-					continue;
-				}
-				if (c == '/') {
-					if (++iter != input.end()) {
-						c = *iter;
-						if (c == '/') {
-							while (c != '\n') {
-								if (++iter == input.end()) {
-									break;
-								}
-								c = *iter;
-							}
-							if (iter == input.end()) {
-								break;
-							}
-						}
-						else {
-							--iter;
-							c = '/';
-						}
-					}
-					else {
-						--iter;
-						c = '/';
-					}
-				}
+		auto feed(std::string_view text) -> void {
+			reader.feed(text);
+			read(false);
+		}
 
-				if (is_letter(c)) {
-					std::string name;
-					while (is_letter(c) || is_digit(c)) {
-						name += c;
-						if (++iter == input.end()) {
-							break;
-						}
-						c = *iter;
-					}
-					--iter;
-					parser << CommandToken{ CommandToken::Type::Name, name };
-				}
-				else if (is_digit(c)) {
-					std::string number;
-					while (is_digit(c)) {
-						number += c;
-						if (++iter == input.end()) {
-							break;
-						}
-						c = *iter;
-					}
-					--iter;
-					parser << CommandToken{ CommandToken::Type::Number, number };
-				}
-				else if (c == '"') {
-					std::string str;
-					c = *++iter;
-					while (c != '"') {
-						if (c == '\\') {
-							if (++iter == input.end()) {
-								break;
-							}
-							c = *iter;
-							switch (c)
-							{
-							case 'n':
-								str += '\n';
-								break;
-							case 'r':
-								str += '\r';
-								break;
-							case 't':
-								str += '\t';
-								break;
-							case 'b':
-								str += '\b';
-								break;
-							case 'f':
-								str += '\f';
-								break;
-							case 'v':
-								str += '\v';
-								break;
-							case 'a':
-								str += '\a';
-								break;
-							case '\\':
-								str += '\\';
-								break;
-							case '\'':
-								str += '\'';
-								break;
-							case '"':
-								str += '"';
-								break;
-							case '?':
-								str += '?';
-								break;
-							case '0':
-								str += '\0';
-								break;
-							case 'x': {
-								if (++iter == input.end()) {
-									break;
-								}
-								c = *iter;
-								if (!is_hex(c)) {
-									throw CommandException("Invalid hex character: {}", c);
-								}
-								uint8_t hex = 0;
-								if (is_digit(c)) {
-									hex = c - '0';
-								}
-								else if (is_lower(c)) {
-									hex = c - 'a' + 10;
-								}
-								else {
-									hex = c - 'A' + 10;
-								}
-
-								if (++iter == input.end()) {
-									break;
-								}
-								c = *iter;
-								if (!is_hex(c)) {
-									throw CommandException("Invalid hex character: {}", c);
-								}
-								hex <<= 4;
-								if (is_digit(c)) {
-									hex |= c - '0';
-								}
-								else if (is_lower(c)) {
-									hex |= c - 'a' + 10;
-								}
-								else {
-									hex |= c - 'A' + 10;
-								}
-								str.push_back(hex);
-								break;
-							}
-							case 'u': {
-								if (++iter == input.end()) {
-									break;
-								}
-								c = *iter;
-								if (!is_hex(c)) {
-									throw CommandException("Invalid hex character: {}", c);
-								}
-								uint16_t hex = 0;
-								if (is_digit(c)) {
-									hex = c - '0';
-								}
-								else if (is_lower(c)) {
-									hex = c - 'a' + 10;
-								}
-								else {
-									hex = c - 'A' + 10;
-								}
-								for (int i = 0; i < 3; ++i) {
-									if (++iter == input.end()) {
-										break;
-									}
-									c = *iter;
-									if (!is_hex(c)) {
-										throw CommandException("Invalid hex character: {}", c);
-									}
-									hex <<= 4;
-									if (is_digit(c)) {
-										hex |= c - '0';
-									}
-									else if (is_lower(c)) {
-										hex |= c - 'a' + 10;
-									}
-									else {
-										hex |= c - 'A' + 10;
-									}
-								}
-								str.push_back(hex);
-								break;
-							}
-							default:
-								throw CommandException("Invalid escape character: {}", c);
-								break;
-							}
-						}
-						else {
-							str += c;
-						}
-						if (++iter == input.end()) {
-							break;
-						}
-						c = *iter;
-					}
-					if (iter == input.end()) {
-						throw CommandException("String is not closed.");
-					}
-					parser << CommandToken{ CommandToken::Type::String, str };
-				}
-				else if (is_separator(c)) {
-					parser << CommandToken{ CommandToken::Type::Separator, std::string(1, c) };
-				}
-				else if (is_function_related(c)) {
-					std::string full;
-					char h = c;
-					while (h == c) {
-						full += c;
-						if (++iter == input.end()) {
-							break;
-						}
-						c = *iter;
-					}
+		auto finish() -> void {
+			read(true);
+			reader.clear();
+		}
 
-					if (c == '=' && full.size() == 1 && (h == '<' || h == '>')) {
-						full += '=';
-						parser << CommandToken{ CommandToken::Type::Operator, full };
-					}
-					else {
-						--iter;
-						parser << CommandToken{ CommandToken::Type::FunctionRelated, full };
-					}
-				}
-				else if (is_comparator(c)) {
-					++iter;
-					auto s = *iter;
-					if (s == '=') {
-						parser << CommandToken{ CommandToken::Type::Operator, std::string({ c, s }) };
-					}
-					else {
-						--iter;
-						parser << CommandToken{ CommandToken::Type::Operator, std::string(1, c) };
-					}
-				}
-				else if (is_operator(c)) {
-					parser << CommandToken{ CommandToken::Type::Operator, std::string(1, c) };
-				}
-				else if (c == ':') {
-					++iter;
-					auto s = *iter;
-					if (s == '=') {
-						parser << CommandToken{ CommandToken::Type::Operator, std::string({ c, s }) };
-					}
-					else {
-						--iter;
-						parser << CommandToken{ CommandToken::Type::Condition, std::string(1, c) };
-					}
-				}
-				else if (is_condition(c)) {
-					parser << CommandToken{ CommandToken::Type::Condition, std::string(1, c) };
-				}
-				else if (is_special(c)) {
-					parser << CommandToken{ CommandToken::Type::Special, std::string(1, c) };
-				}
-				else if (is_eof(c)) {
-					parser << CommandToken{ CommandToken::Type::Eof, std::string(1, c) };
-				}
-				else {
-					throw CommandException("Unexpected character`{}`.", c);
-				}
+		/// <summary>
+		/// Passes the complete tokens of the fed text to the parser. After an error interrupted it, calling it again goes on with the next token.
+		/// </summary>
+		auto read(bool finishing) -> void {
+			while (auto token = reader.next(finishing)) {
+				parser << *token;
 			}
 		}
 
 		friend auto operator>>(std::istream& is, CommandLexer& lexer) -> std::istream& {
-			std::string line;
-			while (std::getline(is, line)) {
-				lexer.get_tokens(lexer.parser, line);
+			lexer.reader.restart();
+			char chunk[chunk_size];
+			while (is.read(chunk, chunk_size) || is.gcount() > 0) {
+				lexer.feed({ chunk, static_cast<size_t>(is.gcount()) });
 			}
+			lexer.finish();
 			return is;
 		}
 
-		auto operator<<(const std::string& text) -> CommandLexer& {
-			get_tokens(parser, text);
+		/// <summary>
+		/// Lexes a complete piece of code.
+		/// </summary>
+		auto operator<<(std::string_view text) -> CommandLexer& {
+			reader.restart();
+			feed(text);
+			finish();
 			return *this;
 		}
 
@@ -906,46 +856,8 @@ namespace arx
 		}
 
 		CommandParser<I>& parser;
+		CommandReader reader;
 
-	private:
-		auto is_empty(char c) -> bool {
-			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
-		}
-		auto is_letter(char c) -> bool {
-			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c == '_');
-		}
-		auto is_digit(char c) -> bool {
-			return (c >= '0' && c <= '9') || (c == '.');
-		}
-		auto is_separator(char c) -> bool {
-			return c == '(' || c == ')' || c == '{' || c == '}' || c == '[' || c == ']' || c == ',' || c == ';';
-		}
-		auto is_comparator(char c) -> bool {
-			return c == '<' || c == '>' || c == '=' || c == '!';
-		}
-		auto is_function_related(char c) -> bool {
-			return c == '$' || c == '%' || c == '<' || c == '>'; // Cenvrons are not used as brackets in ACL.
-		}
-		auto is_operator(char c) -> bool {
-			return c == '+' || c == '-' || c == '*' || c == '/' || c == '%' || c == '^' || c == '=';
-		}
-		auto is_condition(char c) -> bool {
-			return c == '?' || c == ':';
-		}
-		auto is_special(char c) -> bool {
-			return c == '!' || c == '#' || c == '@' || c == '&' || c == '|' || c == '~' || c == '`';
-		}
-		auto is_eof(char c) -> bool {
-			return c == '\0';
-		}
-		auto is_hex(char c) -> bool {
-			return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
-		}
-		auto is_capitol(char c) -> bool {
-			return c >= 'A' && c <= 'Z';
-		}
-		auto is_lower(char c) -> bool {
-			return c >= 'a' && c <= 'z';
-		}
+		static constexpr size_t chunk_size = 1 << 16;
 	};
-}
\ No newline at end of file
+}
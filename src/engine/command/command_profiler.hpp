@@ -0,0 +1,271 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Counts the calls and the time spent in every function body and builtin while `enabled`, for the kernel and the machine alike.
+	/// A body is told apart by its code, which the functions created from one piece of code share, so they count together,
+	/// and it's named after the identifier it's assigned to where `scan` found one. Builtins are named as they're bound while `enabled`.
+	/// Inclusive time counts callees, exclusive time only the entry itself; recursive calls count their time once in the inclusive time.
+	/// Whoever enters a sample `unwind`s to the depth `enter` returned, which leaves the samples of callees interrupted by errors too.
+	/// </summary>
+	struct CommandProfiler
+	{
+		using Clock = std::chrono::steady_clock;
+
+		struct Entry
+		{
+			std::string name;
+			uint64_t calls = 0;
+			std::chrono::nanoseconds inclusive{ 0 };
+			std::chrono::nanoseconds exclusive{ 0 };
+		};
+
+		static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+		bool enabled = false;
+
+		/// <summary>
+		/// The entry of the body whose code is `code`: the statements shared by the functions of the tree walker, or the chunk shared by those of the machine.
+		/// `statements` are those it's written as, if they still exist, which `scan` names it after.
+		/// </summary>
+		auto body(const std::shared_ptr<const void>& code, const void* statements, CommandSourcePosition position) -> uint32_t {
+			auto [found, inserted] = bodies.try_emplace(code.get(), static_cast<uint32_t>(records.size()));
+			if (!inserted && records[found->second].code.expired()) { // freed, and another body got its address.
+				found->second = static_cast<uint32_t>(records.size());
+				inserted = true;
+			}
+			if (inserted) {
+				auto name = body_names.find(statements);
+				auto named = name != body_names.end() && !name->second.second.expired();
+				records.push_back({ Kind::Body, position, code, named ? name->second.first : std::string{ } });
+			}
+			return found->second;
+		}
+
+		/// <summary>
+		/// The entry of a builtin function or macro, named after the identifier it was added as, if any.
+		/// </summary>
+		auto builtin(const CommandValue& function) -> uint32_t {
+			auto [found, inserted] = builtins.try_emplace(function.object, static_cast<uint32_t>(records.size()));
+			if (inserted) {
+				auto name = builtin_names.find(function.object);
+				records.push_back({ Kind::Builtin, { }, { }, name != builtin_names.end() ? name->second : std::string{ } });
+			}
+			return found->second;
+		}
+
+		/// <summary>
+		/// Names a builtin, as libraries are loaded. Only its address is kept, a builtin named differently at the same address gets an entry of its own.
+		/// </summary>
+		auto name(const std::string& name, const CommandValue& function) -> void {
+			if (!enabled || (function.type != CommandValue::Type::Function && function.type != CommandValue::Type::Macro)) {
+				return;
+			}
+			builtin_names.insert_or_assign(function.object, name);
+			if (auto found = builtins.find(function.object); found != builtins.end() && records[found->second].name != name) {
+				builtins.erase(found);
+			}
+		}
+
+		/// <summary>
+		/// Names the bodies of a statement which are directly assigned to an identifier, like `f = { ... };`.
+		/// </summary>
+		auto scan(const CommandASTStatementNode& statement) -> void {
+			if (statement.type == CommandASTStatementNode::Type::Expression) {
+				scan(std::get<CommandASTExpressionNode>(statement.value));
+			}
+		}
+
+		/// <summary>
+		/// Starts a sample of an entry and returns the depth to `unwind` to once it's over.
+		/// </summary>
+		auto enter(uint32_t entry) -> size_t {
+			if (entry >= counts.size()) {
+				counts.resize(records.size());
+			}
+			++counts[entry].calls;
+			++counts[entry].active;
+			samples.push_back({ entry, Clock::now(), std::chrono::nanoseconds{ 0 } });
+			return samples.size() - 1;
+		}
+
+		auto unwind(size_t depth) -> void {
+			if (depth == none) {
+				return;
+			}
+			auto now = Clock::now();
+			while (samples.size() > depth) {
+				auto& sample = samples.back();
+				auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - sample.start);
+				auto& count = counts[sample.entry];
+				count.exclusive += elapsed - sample.children;
+				if (--count.active == 0) {
+					count.inclusive += elapsed;
+				}
+				samples.pop_back();
+				if (!samples.empty()) {
+					samples.back().children += elapsed;
+				}
+			}
+		}
+
+		auto depth() const -> size_t {
+			return samples.size();
+		}
+
+		/// <summary>
+		/// The entries called so far, the most exclusive time first.
+		/// </summary>
+		auto report() const -> std::vector<Entry> {
+			std::vector<Entry> entries;
+			for (size_t i = 0; i < counts.size(); ++i) {
+				if (counts[i].calls != 0) {
+					entries.push_back({ name_of(records[i]), counts[i].calls, counts[i].inclusive, counts[i].exclusive });
+				}
+			}
+			std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+				return a.exclusive != b.exclusive ? a.exclusive > b.exclusive : a.name < b.name;
+			});
+			return entries;
+		}
+
+		auto print(std::ostream& output) const -> void {
+			auto entries = report();
+			std::chrono::nanoseconds total{ 0 };
+			for (auto& entry : entries) {
+				total += entry.exclusive;
+			}
+			output << std::format("{:<40}{:>12}{:>16}{:>16}{:>10}\n", "function", "calls", "inclusive (ms)", "exclusive (ms)", "self %");
+			for (auto& entry : entries) {
+				output << std::format("{:<40}{:>12}{:>16.3f}{:>16.3f}{:>9.1f}%\n", entry.name, entry.calls,
+					entry.inclusive.count() / 1e6, entry.exclusive.count() / 1e6, total.count() == 0 ? 0.0 : 100.0 * entry.exclusive.count() / total.count());
+			}
+		}
+
+		/// <summary>
+		/// Forgets what was counted, the names stay.
+		/// </summary>
+		auto clear() -> void {
+			counts.clear();
+			samples.clear();
+		}
+
+	private:
+		enum class Kind
+		{
+			Body,
+			Builtin,
+		};
+
+		struct Record
+		{
+			Kind kind;
+			CommandSourcePosition position; // of a body.
+			std::weak_ptr<const void> code; // of a body.
+			std::string name; // found when the entry was made, empty if none.
+		};
+
+		struct Count
+		{
+			uint64_t calls = 0;
+			std::chrono::nanoseconds inclusive{ 0 };
+			std::chrono::nanoseconds exclusive{ 0 };
+			uint32_t active = 0; // samples of the entry currently entered.
+		};
+
+		struct Sample
+		{
+			uint32_t entry;
+			Clock::time_point start;
+			std::chrono::nanoseconds children;
+		};
+
+		std::vector<Record> records;
+		std::vector<Count> counts;
+		std::vector<Sample> samples;
+		std::unordered_map<const void*, uint32_t> bodies; // by their code.
+		std::unordered_map<const void*, uint32_t> builtins;
+		std::unordered_map<const void*, std::pair<std::string, std::weak_ptr<const void>>> body_names; // by their statements.
+		std::unordered_map<const void*, std::string> builtin_names;
+
+		auto name_of(const Record& record) const -> std::string {
+			if (record.kind == Kind::Builtin) {
+				return record.name.empty() ? "(builtin)" : record.name;
+			}
+			auto location = record.position.known() ? std::format("{}:{}", record.position.line, record.position.column) : std::string{ "?" };
+			return record.name.empty() ? std::format("{{ }} ({})", location) : std::format("{} ({})", record.name, location);
+		}
+
+		auto scan(const std::unique_ptr<CommandASTExpressionNode>& expression) -> void {
+			if (expression != nullptr) {
+				scan(*expression);
+			}
+		}
+
+		auto scan(const CommandASTExpressionNode& expression) -> void {
+			switch (expression.type) {
+			case CommandASTExpressionNode::Type::Operation: {
+				for (auto& operand : std::get<CommandASTOperationNode>(expression.value).operands) {
+					scan(operand);
+				}
+				break;
+			}
+			case CommandASTExpressionNode::Type::List: {
+				for (auto& element : std::get<CommandASTListNode>(expression.value).expressions) {
+					scan(element);
+				}
+				break;
+			}
+			case CommandASTExpressionNode::Type::Parentheses: {
+				scan(std::get<CommandASTParenthesesNode>(expression.value).expression);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Calling: {
+				auto& calling = std::get<CommandASTCallingNode>(expression.value);
+				scan(calling.callable);
+				scan(calling.argument);
+				break;
+			}
+			case CommandASTExpressionNode::Type::FunctionBody: {
+				for (auto& statement : *std::get<CommandASTFunctionBodyNode>(expression.value).commands) {
+					scan(statement);
+				}
+				break;
+			}
+			case CommandASTExpressionNode::Type::Condition: {
+				auto& condition = std::get<CommandASTConditionNode>(expression.value);
+				scan(condition.condition);
+				scan(condition.true_branch);
+				scan(condition.false_branch);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Assignment: {
+				auto& assignment = std::get<CommandASTAssignmentNode>(expression.value);
+				if (assignment.target != nullptr && assignment.target->type == CommandASTExpressionNode::Type::Identifier
+					&& assignment.expression != nullptr && assignment.expression->type == CommandASTExpressionNode::Type::FunctionBody) {
+					auto& commands = std::get<CommandASTFunctionBodyNode>(assignment.expression->value).commands;
+					body_names.insert_or_assign(commands.get(), std::pair{ std::get<CommandASTIdentifierNode>(assignment.target->value).name, std::weak_ptr<const void>{ commands } });
+				}
+				scan(assignment.target);
+				scan(assignment.expression);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Return: {
+				scan(std::get<CommandASTReturnNode>(expression.value).expression);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Loop: {
+				scan(std::get<CommandASTLoopNode>(expression.value).argument);
+				break;
+			}
+			case CommandASTExpressionNode::Type::Accessing: {
+				scan(std::get<CommandASTAccessingNode>(expression.value).expression);
+				break;
+			}
+			default:
+				break;
+			}
+		}
+	};
+}
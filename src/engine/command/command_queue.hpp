@@ -0,0 +1,67 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Unbounded lock-free queue of many producers and a single consumer: `push` from any thread, `pop` from one only.
+	/// Pushing is a single exchange on the head, so producers never wait for each other nor for the consumer.
+	/// A value pushed by a producer which is between its exchange and linking the node isn't popped until it's linked,
+	/// the consumer sees the queue as empty meanwhile.
+	/// </summary>
+	template<typename T>
+	struct CommandQueue
+	{
+		CommandQueue() : head{ &stub }, tail{ &stub } {
+		}
+
+		CommandQueue(const CommandQueue&) = delete;
+
+		~CommandQueue() {
+			while (pop().has_value()) {
+			}
+			if (tail != &stub) {
+				delete tail;
+			}
+		}
+
+		auto push(T value) -> void {
+			auto node = new Node{ { nullptr }, std::move(value) };
+			auto previous = head.exchange(node, std::memory_order_acq_rel);
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		auto pop() -> std::optional<T> {
+			auto next = tail->next.load(std::memory_order_acquire);
+			if (next == nullptr) {
+				return std::nullopt;
+			}
+			// `next` becomes the node in front of the queue, whose value is already taken.
+			auto value = std::move(next->value);
+			next->value.reset();
+			if (tail != &stub) {
+				delete tail;
+			}
+			tail = next;
+			return value;
+		}
+
+		/// <summary>
+		/// Whether nothing is queued, counting the values pushed but not linked yet, which `pop` doesn't return meanwhile.
+		/// Only the consumer may call it.
+		/// </summary>
+		auto empty() const -> bool {
+			return head.load(std::memory_order_acquire) == tail;
+		}
+
+	private:
+		struct Node
+		{
+			std::atomic<Node*> next;
+			std::optional<T> value;
+		};
+
+		Node stub{ { nullptr }, std::nullopt };
+		std::atomic<Node*> head; // the last pushed, written by producers.
+		Node* tail; // the last popped, only touched by the consumer.
+	};
+}
@@ -1,2 +1,433 @@
 #pragma once
 
+namespace arx
+{
+	struct CommandToken
+	{
+		enum class Type : uint8_t
+		{
+			None,
+			Comment,
+			Name,
+			Number,
+			String,
+			Separator,
+			Operator,
+			Condition,
+			Special,
+			FunctionRelated,
+			Eof,
+		};
+
+		/// <summary>
+		/// Separators, operators and the other symbols, so the parser doesn't compare strings.
+		/// `Positive`, `Negative` and `Call` are never read, the parser uses them for the precedence of unary operators and callings.
+		/// </summary>
+		enum class Symbol : uint8_t
+		{
+			None,
+			OpenParenthesis,
+			CloseParenthesis,
+			OpenBracket,
+			CloseBracket,
+			OpenBrace,
+			CloseBrace,
+			Comma,
+			Semicolon,
+			Assign,
+			LocalAssign,
+			Add,
+			Subtract,
+			Multiply,
+			Divide,
+			Modulo,
+			Exponent,
+			Equal,
+			NotEqual,
+			LessThan,
+			LessThanOrEqual,
+			GreaterThan,
+			GreaterThanOrEqual,
+			Not,
+			Question,
+			Colon,
+			Delete,
+			Access,
+			Ampersand,
+			Bar,
+			Tilde,
+			Backtick,
+			Return,
+			Argument,
+			Self,
+			Loop,
+			Positive,
+			Negative,
+			Call,
+		};
+
+		Type type;
+		Symbol symbol = Symbol::None;
+
+		/// <summary>
+		/// A view into the reader's buffer, only valid until the reader is fed again.
+		/// Strings are viewed without their quotes and with their escapes undecoded, see `unescape`.
+		/// </summary>
+		std::string_view value;
+		CommandSourcePosition position;
+	};
+
+	/// <summary>
+	/// Splits source text into tokens without copying them.
+	/// Text can be fed in any pieces: a token that runs to the end of the fed text is held back until
+	/// the following text completes it, or until the stream is finished.
+	/// </summary>
+	struct CommandReader
+	{
+		auto feed(std::string_view text) -> void {
+			buffer.erase(0, offset);
+			offset = 0;
+			buffer.append(text);
+		}
+
+		/// <summary>
+		/// Reads the next complete token. When `finishing`, the end of the buffer is the end of the stream,
+		/// otherwise a token touching it is left for the next `feed`.
+		/// </summary>
+		auto next(bool finishing) -> std::optional<CommandToken> {
+			while (true) {
+				while (offset < buffer.size() && (is_empty(buffer[offset]) || is_eof(buffer[offset]))) {
+					if (buffer[offset++] == '\n') {
+						++here.line;
+						here.column = 1;
+					}
+					else {
+						++here.column;
+					}
+				}
+				if (offset == buffer.size()) {
+					return std::nullopt;
+				}
+
+				size_t start = offset;
+				char c = buffer[start];
+				if (c == '/' && start + 1 < buffer.size() && buffer[start + 1] == '/') {
+					auto end = buffer.find('\n', start + 2);
+					if (end == std::string::npos) {
+						if (!finishing) {
+							return std::nullopt;
+						}
+						end = buffer.size();
+					}
+					advance(end);
+					continue;
+				}
+
+				if (is_letter(c)) {
+					return read_run(CommandToken::Type::Name, CommandToken::Symbol::None, finishing, [](char c) { return is_letter(c) || is_digit(c); });
+				}
+				if (is_digit(c)) {
+					return read_run(CommandToken::Type::Number, CommandToken::Symbol::None, finishing, [](char c) { return is_digit(c); });
+				}
+				if (c == '"') {
+					return read_string(finishing);
+				}
+				if (is_separator(c)) {
+					return read_symbol(CommandToken::Type::Separator, separator_of(c), 1);
+				}
+				if (is_function_related(c)) {
+					size_t end = start;
+					while (end < buffer.size() && buffer[end] == c) {
+						++end;
+					}
+					if (end == buffer.size() && !finishing) {
+						return std::nullopt;
+					}
+					if (end - start == 1 && (c == '<' || c == '>') && buffer[end] == '=') {
+						return read_symbol(CommandToken::Type::Operator, c == '<' ? CommandToken::Symbol::LessThanOrEqual : CommandToken::Symbol::GreaterThanOrEqual, 2);
+					}
+					return read_symbol(CommandToken::Type::FunctionRelated, function_related_of(c), end - start);
+				}
+				if (is_comparator(c) || c == ':') {
+					if (start + 1 == buffer.size() && !finishing) {
+						return std::nullopt;
+					}
+					if (start + 1 < buffer.size() && buffer[start + 1] == '=') {
+						return read_symbol(CommandToken::Type::Operator, c == '=' ? CommandToken::Symbol::Equal : c == '!' ? CommandToken::Symbol::NotEqual : CommandToken::Symbol::LocalAssign, 2);
+					}
+					if (c == ':') {
+						return read_symbol(CommandToken::Type::Condition, CommandToken::Symbol::Colon, 1);
+					}
+					return read_symbol(CommandToken::Type::Operator, c == '=' ? CommandToken::Symbol::Assign : CommandToken::Symbol::Not, 1);
+				}
+				if (is_operator(c)) {
+					if (c == '/' && start + 1 == buffer.size() && !finishing) {
+						return std::nullopt; // Might be a comment.
+					}
+					return read_symbol(CommandToken::Type::Operator, operator_of(c), 1);
+				}
+				if (c == '?') {
+					return read_symbol(CommandToken::Type::Condition, CommandToken::Symbol::Question, 1);
+				}
+				if (is_special(c)) {
+					return read_symbol(CommandToken::Type::Special, special_of(c), 1);
+				}
+				size_t end = start + 1;
+				while (end < buffer.size() && (static_cast<uint8_t>(buffer[end]) & 0xC0) == 0x80) {
+					++end; // the rest of a multibyte character.
+				}
+				CommandException exception{ "Unexpected character`{}`.", std::string_view{ buffer }.substr(start, end - start) };
+				exception.locate(here);
+				advance(end);
+				throw exception;
+			}
+		}
+
+		/// <summary>
+		/// Drops everything fed but not read yet.
+		/// </summary>
+		auto clear() -> void {
+			buffer.clear();
+			offset = 0;
+		}
+
+		/// <summary>
+		/// Starts counting lines and columns from the beginning again, for a new source.
+		/// </summary>
+		auto restart() -> void {
+			clear();
+			here = { 1, 1 };
+		}
+
+		auto pending() const -> bool {
+			return offset < buffer.size();
+		}
+
+		/// <summary>
+		/// Decodes the escapes of a string token.
+		/// </summary>
+		static auto unescape(std::string_view text) -> std::string {
+			std::string str;
+			str.reserve(text.size());
+			for (size_t i = 0; i < text.size(); ++i) {
+				char c = text[i];
+				if (c != '\\') {
+					str += c;
+					continue;
+				}
+				if (++i == text.size()) {
+					break;
+				}
+				c = text[i];
+				switch (c)
+				{
+				case 'n':
+					str += '\n';
+					break;
+				case 'r':
+					str += '\r';
+					break;
+				case 't':
+					str += '\t';
+					break;
+				case 'b':
+					str += '\b';
+					break;
+				case 'f':
+					str += '\f';
+					break;
+				case 'v':
+					str += '\v';
+					break;
+				case 'a':
+					str += '\a';
+					break;
+				case '\\':
+					str += '\\';
+					break;
+				case '\'':
+					str += '\'';
+					break;
+				case '"':
+					str += '"';
+					break;
+				case '?':
+					str += '?';
+					break;
+				case '0':
+					str += '\0';
+					break;
+				case 'x': {
+					str.push_back(static_cast<char>(read_hex(text, i, 2)));
+					break;
+				}
+				case 'u': {
+					str.push_back(static_cast<char>(read_hex(text, i, 4)));
+					break;
+				}
+				default:
+					throw CommandException("Invalid escape character: {}", c);
+					break;
+				}
+			}
+			return str;
+		}
+
+	private:
+		std::string buffer;
+		size_t offset = 0;
+		CommandSourcePosition here{ 1, 1 }; // of `offset`.
+
+		auto advance(size_t end) -> void {
+			for (; offset < end; ++offset) {
+				if (buffer[offset] == '\n') {
+					++here.line;
+					here.column = 1;
+				}
+				else if ((static_cast<uint8_t>(buffer[offset]) & 0xC0) != 0x80) {
+					++here.column; // columns count characters, not the bytes they're encoded in.
+				}
+			}
+		}
+
+		auto read_symbol(CommandToken::Type type, CommandToken::Symbol symbol, size_t length) -> CommandToken {
+			CommandToken token{ type, symbol, std::string_view{ buffer }.substr(offset, length), here };
+			offset += length; // names, numbers and symbols are ascii on a single line.
+			here.column += static_cast<uint32_t>(length);
+			return token;
+		}
+
+		template<typename P>
+		auto read_run(CommandToken::Type type, CommandToken::Symbol symbol, bool finishing, P&& predicate) -> std::optional<CommandToken> {
+			size_t end = offset;
+			while (end < buffer.size() && predicate(buffer[end])) {
+				++end;
+			}
+			if (end == buffer.size() && !finishing) {
+				return std::nullopt;
+			}
+			return read_symbol(type, symbol, end - offset);
+		}
+
+		auto read_string(bool finishing) -> std::optional<CommandToken> {
+			size_t end = offset + 1;
+			while (end < buffer.size() && buffer[end] != '"') {
+				end += buffer[end] == '\\' ? 2 : 1;
+			}
+			if (end >= buffer.size()) {
+				if (!finishing) {
+					return std::nullopt;
+				}
+				CommandException exception{ "String is not closed." };
+				exception.locate(here);
+				advance(buffer.size());
+				throw exception;
+			}
+			CommandToken token{ CommandToken::Type::String, CommandToken::Symbol::None, std::string_view{ buffer }.substr(offset + 1, end - offset - 1), here };
+			advance(end + 1);
+			return token;
+		}
+
+		static auto read_hex(std::string_view text, size_t& i, int digits) -> uint16_t {
+			uint16_t hex = 0;
+			for (int d = 0; d < digits; ++d) {
+				if (++i == text.size()) {
+					--i;
+					break;
+				}
+				char c = text[i];
+				if (!is_hex(c)) {
+					throw CommandException("Invalid hex character: {}", c);
+				}
+				hex <<= 4;
+				if (c >= '0' && c <= '9') {
+					hex |= c - '0';
+				}
+				else if (is_lower(c)) {
+					hex |= c - 'a' + 10;
+				}
+				else {
+					hex |= c - 'A' + 10;
+				}
+			}
+			return hex;
+		}
+
+		static auto separator_of(char c) -> CommandToken::Symbol {
+			switch (c) {
+			case '(': return CommandToken::Symbol::OpenParenthesis;
+			case ')': return CommandToken::Symbol::CloseParenthesis;
+			case '[': return CommandToken::Symbol::OpenBracket;
+			case ']': return CommandToken::Symbol::CloseBracket;
+			case '{': return CommandToken::Symbol::OpenBrace;
+			case '}': return CommandToken::Symbol::CloseBrace;
+			case ',': return CommandToken::Symbol::Comma;
+			default: return CommandToken::Symbol::Semicolon;
+			}
+		}
+
+		static auto function_related_of(char c) -> CommandToken::Symbol {
+			switch (c) {
+			case '<': return CommandToken::Symbol::Return;
+			case '>': return CommandToken::Symbol::Argument;
+			case '$': return CommandToken::Symbol::Self;
+			default: return CommandToken::Symbol::Loop;
+			}
+		}
+
+		static auto operator_of(char c) -> CommandToken::Symbol {
+			switch (c) {
+			case '+': return CommandToken::Symbol::Add;
+			case '-': return CommandToken::Symbol::Subtract;
+			case '*': return CommandToken::Symbol::Multiply;
+			case '/': return CommandToken::Symbol::Divide;
+			default: return CommandToken::Symbol::Exponent;
+			}
+		}
+
+		static auto special_of(char c) -> CommandToken::Symbol {
+			switch (c) {
+			case '#': return CommandToken::Symbol::Delete;
+			case '@': return CommandToken::Symbol::Access;
+			case '&': return CommandToken::Symbol::Ampersand;
+			case '|': return CommandToken::Symbol::Bar;
+			case '~': return CommandToken::Symbol::Tilde;
+			default: return CommandToken::Symbol::Backtick;
+			}
+		}
+
+		static auto is_empty(char c) -> bool {
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+		static auto is_letter(char c) -> bool {
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c == '_');
+		}
+		static auto is_digit(char c) -> bool {
+			return (c >= '0' && c <= '9') || (c == '.');
+		}
+		static auto is_separator(char c) -> bool {
+			return c == '(' || c == ')' || c == '{' || c == '}' || c == '[' || c == ']' || c == ',' || c == ';';
+		}
+		static auto is_comparator(char c) -> bool {
+			return c == '=' || c == '!'; // `<` and `>` are read with the function related symbols.
+		}
+		static auto is_function_related(char c) -> bool {
+			return c == '$' || c == '%' || c == '<' || c == '>'; // Cenvrons are not used as brackets in ACL.
+		}
+		static auto is_operator(char c) -> bool {
+			return c == '+' || c == '-' || c == '*' || c == '/' || c == '^';
+		}
+		static auto is_special(char c) -> bool {
+			return c == '#' || c == '@' || c == '&' || c == '|' || c == '~' || c == '`';
+		}
+		static auto is_eof(char c) -> bool {
+			return c == '\0';
+		}
+		static auto is_hex(char c) -> bool {
+			return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+		}
+		static auto is_lower(char c) -> bool {
+			return c >= 'a' && c <= 'z';
+		}
+	};
+}
@@ -7,46 +7,498 @@ namespace arx
 		std::ostream& output;
 		std::ostream& error;
 
+		// Where `print` of the basic library writes, as text on `output` unless its consumer is replaced. Flushed on demand, see `run`.
+		CommandSink sink;
+
 		CommandKernel kernel;
-		CommandParser<CommandKernel> parser;
-		CommandLexer<CommandKernel> lexer;
+		CommandMachine machine;
+		CommandParser<CommandMachine> parser;
+		CommandLexer<CommandMachine> lexer;
+
+		// `run_code` parses code into scripts once and excutes them from here after.
+		CommandScriptCache cache{ 256 };
+		CommandScriptParser script_parser;
+
+		// Where `import` finds modules.
+		CommandModuleRegistry* modules = &CommandModuleRegistry::standard();
+
+		// Whether `run_file` keeps compiled scripts in `.arxc` files.
+		bool archiving = true;
+
+		// Shared with other runtimes, see `CommandContext`, or `nullptr`.
+		std::shared_ptr<CommandContext> context;
+
+		// Whether a `CommandScheduler` runs the slices of the runtime on its threads, which `post` effects as a worker thread does.
+		bool scheduled = false;
 
 		bool exit = false;
 
-		CommandRuntime(std::istream& input, std::ostream& output, std::ostream& error = std::cerr) : input{ input }, output{ output }, error{ error }, kernel{ }, parser{ kernel }, lexer{ parser } {
+		CommandRuntime(std::istream& input, std::ostream& output, std::ostream& error = std::cerr) : input{ input }, output{ output }, error{ error }, sink{ CommandSink::text(output) }, kernel{ }, machine{ kernel }, parser{ machine }, lexer{ parser } {
+			kernel.importer = [this](const std::string& name) {
+				return import(name);
+			};
+		}
+
+		/// <summary>
+		/// A runtime sharing the symbols, libraries, modules and scripts of `context` with the other runtimes created from it,
+		/// each of which may run on its own thread.
+		/// </summary>
+		CommandRuntime(std::shared_ptr<CommandContext> context, std::istream& input, std::ostream& output, std::ostream& error = std::cerr) :
+			input{ input }, output{ output }, error{ error }, sink{ CommandSink::text(output) }, kernel{ context->symbols }, machine{ kernel }, parser{ machine }, lexer{ parser }, modules{ context->modules }, context{ std::move(context) } {
+			kernel.importer = [this](const std::string& name) {
+				return import(name);
+			};
+			set_optimizing(this->context->optimizing);
+			this->context->load_to(kernel);
+		}
+
+		CommandRuntime(const CommandRuntime&) = delete; // the kernel's importer refers to it.
+
+		~CommandRuntime() {
+			shutdown();
+			sink.flush();
 		}
 
 		auto load_library(CommandLibrary&& library) -> void {
 			library.load_to(kernel);
 		}
 
+		/// <summary>
+		/// Brings a module into the top scope, and returns the identifiers which couldn't be bound.
+		/// The first import of a module in this runtime interns its names, or builds its library, or compiles its script,
+		/// later ones only bind the values or excute the chunks.
+		/// </summary>
+		auto import(const std::string& name) -> std::vector<CommandValue> {
+			auto found = imports.find(name);
+			if (found == imports.end()) {
+				auto module = modules->find(name);
+				if (module == nullptr) {
+					throw CommandException("Module `{}` doesn't exist.", name);
+				}
+				found = imports.emplace(name, prepare(std::move(module))).first;
+			}
+			auto& imported = found->second;
+
+			std::vector<CommandValue> failed_identifiers;
+			for (auto& [symbol, value] : imported.values) {
+				if (!kernel.add_identifier(symbol, CommandValue{ value }, true)) {
+					failed_identifiers.push_back(CommandValue{ CommandValue::Type::String, kernel.symbols.name(symbol) });
+				}
+			}
+			if (imported.module->script != nullptr) {
+				excute_module(imported);
+			}
+			return failed_identifiers;
+		}
+
+		auto set_optimizing(bool optimizing) -> void {
+			parser.optimizing = optimizing;
+			script_parser.parser.optimizing = optimizing;
+			kernel.optimizing = optimizing;
+			cache.clear();
+		}
+
+		/// <summary>
+		/// Excutes the input as one stream. It's still read by lines so the statements of a line are excuted once it's entered,
+		/// but a string may continue on the next lines.
+		/// The sink is flushed before waiting for a line, so not when the input already holds it, as when it's read from a file.
+		/// </summary>
 		auto run() -> int {
+			std::string line;
 			while (!exit) {
-				output.flush();
-				std::string line;
+				if (input.rdbuf()->in_avail() <= 0) {
+					sink.flush();
+				}
 				std::getline(input, line);
-				run_code(line);
+				line += '\n';
+				stream(line, false);
 				if (input.eof()) {
 					break;
 				}
 			}
+			if (!exit) {
+				stream({ }, true);
+			}
+			sink.flush();
 			return 0;
 		}
 
-		auto run_code(const std::string& code) -> void {
-			try {
-				lexer << code;
+		/// <summary>
+		/// Excutes a complete piece of code, its lines are counted from 1 in errors.
+		/// The parsed code is cached, running the same code again skips lexing and parsing, and compiling once it's compiled.
+		/// </summary>
+		auto run_code(std::string_view code) -> void {
+			if (cache.capacity == 0) {
+				lexer.reader.restart();
+				stream(code, true);
+				return;
 			}
-			catch (const CommandException& exception) {
-				error << exception.what() << std::endl;
-				parser.awaiting_expression = CommandASTExpressionNode::make_empty();
-				while (parser.processing_nodes.size() > 1) {
-					parser.processing_nodes.pop();
+			auto script = cache.find(code);
+			if (script == nullptr) {
+				script = prepare_script(code);
+				cache.insert(code, script);
+			}
+			run_script(*script);
+		}
+
+		auto parse(std::string_view code) -> std::shared_ptr<CommandScript> {
+			return script_parser.parse(code);
+		}
+
+		/// <summary>
+		/// The script of a piece of code: the one another runtime of the context shared, or it's parsed,
+		/// and when there's a context, compiled and shared with the other runtimes.
+		/// </summary>
+		auto prepare_script(std::string_view code) -> std::shared_ptr<CommandScript> {
+			if (context == nullptr || script_parser.parser.optimizing != context->optimizing) {
+				return parse(code);
+			}
+			if (auto script = context->find(code)) {
+				return script;
+			}
+			auto script = parse(code);
+			for (auto& step : script->steps) {
+				if (!step.statement.has_value()) {
+					continue;
 				}
-				while (kernel.scope_stack.size() > 1) {
-					kernel.scope_stack.pop_back();
+				try {
+					step.chunk = machine.compiler.compile(*step.statement);
 				}
+				catch (const CommandException&) { // reported where the statement is excuted, by every runtime.
+				}
+			}
+			return context->share(code, std::move(script));
+		}
+
+		/// <summary>
+		/// Excutes a file as `run_code` does. In compiled mode, unless `archiving` is off, its compiled statements are saved next to it
+		/// as `<name>.arxc`, and loaded from there instead of parsing and compiling the file again while it's unchanged.
+		/// Returns false if the file can't be read.
+		/// </summary>
+		auto run_file(const std::filesystem::path& path) -> bool {
+			std::ifstream file{ path, std::ios::binary };
+			if (!file.is_open()) {
+				return false;
+			}
+			std::stringstream code;
+			code << file.rdbuf();
+			auto source = code.str();
+			if (machine.mode == CommandMachine::Mode::Reference || !archiving || kernel.profiler.enabled) { // the profiler names bodies from the statements.
+				run_code(source);
+				return true;
+			}
+
+			auto archive = std::filesystem::path{ path }.replace_extension(".arxc");
+			auto script = CommandScriptArchive::load(archive, source, kernel.symbols, kernel.optimizing);
+			if (script == nullptr) {
+				script = parse(source);
+				bool compiled = true;
+				for (auto& step : script->steps) {
+					if (!step.statement.has_value()) {
+						continue;
+					}
+					try {
+						step.chunk = machine.compiler.compile(*step.statement);
+					}
+					catch (const CommandException&) { // reported where the statement is excuted, and not saved.
+						compiled = false;
+					}
+				}
+				if (compiled) {
+					CommandScriptArchive::save(archive, *script, source, kernel.symbols, kernel.optimizing);
+				}
+			}
+			run_script(*script);
+			return true;
+		}
+
+		/// <summary>
+		/// Queues a complete piece of code to be excuted in slices by `resume`, after the code queued before it.
+		/// Nothing else should be excuted by the runtime while code is pending, since it would run inside the scopes of the suspended code.
+		/// </summary>
+		auto start(std::string_view code) -> void {
+			auto script = cache.capacity == 0 ? nullptr : cache.find(code);
+			if (script == nullptr) {
+				script = prepare_script(code);
+				cache.insert(code, script);
+			}
+			sliced.push_back({ std::move(script), 0 });
+		}
+
+		/// <summary>
+		/// Excutes the queued code until it's all excuted or the budget is exhausted, and returns whether code is still pending.
+		/// The compiled machine suspends a statement between bodies or rounds of a loop, the reference tree walker only between statements.
+		/// </summary>
+		auto resume(const CommandMachine::Budget& budget) -> bool {
+			machine.begin_slice(budget);
+			auto start_time = std::chrono::steady_clock::now();
+			while (!sliced.empty()) {
+				auto& [script, index] = sliced.front();
+				if (machine.suspended()) {
+					std::optional<uint32_t> level;
+					if (guard([&] { level = machine.resume(); }) && !level.has_value()) {
+						return true;
+					}
+					++index;
+				}
+				if (exit) {
+					break;
+				}
+				if (index == script->steps.size()) {
+					sliced.pop_front();
+					continue;
+				}
+				if (machine.exhausted() || (budget.time.count() != 0 && std::chrono::steady_clock::now() - start_time >= budget.time)) {
+					return true;
+				}
+
+				auto& step = script->steps[index];
+				if (!step.statement.has_value() && step.chunk == nullptr) {
+					report(step.error);
+					++index;
+					continue;
+				}
+				if (kernel.profiler.enabled && step.statement.has_value()) {
+					kernel.profiler.scan(*step.statement);
+				}
+				std::optional<uint32_t> level = 0;
+				guard([&] {
+					if (machine.mode == CommandMachine::Mode::Reference) {
+						kernel.excute_statement(*step.statement);
+						return;
+					}
+					if (step.chunk == nullptr) {
+						step.chunk = machine.compiler.compile(*step.statement);
+					}
+					level = machine.excute_sliced(step.chunk);
+				});
+				if (!level.has_value()) {
+					return true;
+				}
+				++index;
+			}
+			sliced.clear();
+			return false;
+		}
+
+		/// <summary>
+		/// Whether code started or submitted isn't completely excuted yet.
+		/// </summary>
+		auto pending() const -> bool {
+			return outstanding.load(std::memory_order_acquire) != 0 || (!worker.joinable() && !sliced.empty());
+		}
+
+		/// <summary>
+		/// Starts excuting code on a worker thread of the runtime: from now on code is sent with `submit`,
+		/// and nothing but `submit`, `post`, `drain` and `pending` may be called from other threads until `shutdown`.
+		/// Libraries acting on the engine `post` their effects, which the thread owning the engine applies with `drain`.
+		/// </summary>
+		auto launch() -> void {
+			if (worker.joinable()) {
+				return;
+			}
+			stopping.store(false, std::memory_order_relaxed);
+			worker = std::thread{ [this] { work(); } };
+		}
+
+		/// <summary>
+		/// Excutes the code already submitted, waiting for the submissions still being queued, then stops the worker thread.
+		/// </summary>
+		auto shutdown() -> void {
+			if (!worker.joinable()) {
+				return;
+			}
+			stopping.store(true, std::memory_order_release); // code submitted before is seen in the queue once the worker sees this.
+			signal.fetch_add(1, std::memory_order_release);
+			signal.notify_one();
+			worker.join();
+		}
+
+		auto working() const -> bool {
+			return worker.joinable();
+		}
+
+		/// <summary>
+		/// Queues code for the worker thread, from any thread, without waiting. It's excuted as `run_code` does.
+		/// </summary>
+		auto submit(std::string code) -> void {
+			outstanding.fetch_add(1, std::memory_order_relaxed);
+			submissions.push(std::move(code));
+			signal.fetch_add(1, std::memory_order_release);
+			signal.notify_one();
+		}
+
+		/// <summary>
+		/// Queues an effect of a script on the engine, to be applied by `drain` on the thread owning the engine.
+		/// Without a worker thread, and unless it's `scheduled`, it's applied right away.
+		/// </summary>
+		auto post(std::function<void()> effect) -> void {
+			if (!worker.joinable() && !scheduled) {
+				effect();
+				return;
+			}
+			effects.push(std::move(effect));
+		}
+
+		/// <summary>
+		/// Applies the effects posted so far, in the order they were posted, and returns how many.
+		/// Only one thread may drain, usually once per frame.
+		/// </summary>
+		auto drain() -> size_t {
+			size_t count = 0;
+			while (auto effect = effects.pop()) {
+				(*effect)();
+				++count;
+			}
+			return count;
+		}
+
+		auto run_script(CommandScript& script) -> void {
+			for (auto& step : script.steps) {
+				if (exit) {
+					break;
+				}
+				if (!step.statement.has_value() && step.chunk == nullptr) {
+					report(step.error);
+					continue;
+				}
+				if (kernel.profiler.enabled && step.statement.has_value()) {
+					kernel.profiler.scan(*step.statement);
+				}
+				guard([&] {
+					if (machine.mode == CommandMachine::Mode::Reference) {
+						kernel.excute_statement(*step.statement);
+						return;
+					}
+					if (step.chunk == nullptr) {
+						step.chunk = machine.compiler.compile(*step.statement);
+					}
+					machine.excute(step.chunk);
+				});
+			}
+		}
+
+	private:
+		// Background mode, the worker thread is the only consumer of `submissions` and the only producer of `effects`.
+		CommandQueue<std::string> submissions;
+		CommandQueue<std::function<void()>> effects;
+		std::atomic<uint32_t> signal{ 0 }; // bumped after every submission, which the worker waits on when it's idle.
+		std::atomic<size_t> outstanding{ 0 };
+		std::atomic<bool> stopping{ false };
+		std::thread worker;
+
+		auto work() -> void {
+			while (true) {
+				auto seen = signal.load(std::memory_order_acquire);
+				while (auto code = submissions.pop()) {
+					run_code(*code);
+					sink.flush();
+					outstanding.fetch_sub(1, std::memory_order_release);
+				}
+				if (stopping.load(std::memory_order_acquire)) {
+					if (submissions.empty()) {
+						break;
+					}
+					std::this_thread::yield(); // a producer is between pushing its code and linking it.
+					continue;
+				}
+				signal.wait(seen, std::memory_order_acquire);
+			}
+		}
+
+		struct SlicedScript
+		{
+			std::shared_ptr<CommandScript> script;
+			size_t index; // of the next step, or of the suspended one.
+		};
+		std::deque<SlicedScript> sliced;
+
+		struct Import
+		{
+			std::shared_ptr<const CommandModule> module;
+			std::vector<std::pair<uint32_t, CommandValue>> values{ };
+			std::vector<std::shared_ptr<const CommandChunk>> chunks{ }; // of the statements of the module's script, compiled on its first import.
+		};
+		std::unordered_map<std::string, Import> imports;
+
+		// Values of modules are shared by every runtime, they're bound through handles of this runtime.
+		auto prepare(std::shared_ptr<const CommandModule>&& module) -> Import {
+			Import imported{ std::move(module) };
+			for (auto& [name, value] : imported.module->values) {
+				imported.values.emplace_back(kernel.symbols.intern(name), CommandValue::forwarding(value));
+			}
+			if (imported.module->factory) {
+				for (auto& [name, value] : imported.module->factory(kernel).variables) {
+					imported.values.emplace_back(kernel.symbols.intern(name), std::move(value));
+				}
+			}
+			return imported;
+		}
+
+		// Errors of the module are errors of the import, which may happen anywhere in a script.
+		auto excute_module(Import& imported) -> void {
+			auto& steps = imported.module->script->steps;
+			if (kernel.profiler.enabled) {
+				for (auto& step : steps) {
+					if (step.statement.has_value()) {
+						kernel.profiler.scan(*step.statement);
+					}
+				}
+			}
+			if (imported.chunks.empty() && machine.mode == CommandMachine::Mode::Compiled) {
+				for (auto& step : steps) {
+					if (!step.statement.has_value()) {
+						throw CommandException("Module `{}`: {}", imported.module->name, step.error);
+					}
+					imported.chunks.push_back(machine.compiler.compile(*step.statement));
+				}
+			}
+			for (size_t i = 0; i < steps.size(); ++i) {
+				if (!steps[i].statement.has_value()) {
+					throw CommandException("Module `{}`: {}", imported.module->name, steps[i].error);
+				}
+				if (machine.mode == CommandMachine::Mode::Reference) {
+					kernel.excute_statement(*steps[i].statement);
+				}
+				else {
+					machine.excute(imported.chunks[i]);
+				}
+			}
+		}
+
+		// An error only drops the statement it happened in, the following ones are still excuted.
+		auto stream(std::string_view text, bool finishing) -> void {
+			lexer.reader.feed(text);
+			while (!guard([&] { lexer.read(finishing); })) {
+				parser.recover();
+			}
+			if (finishing) {
+				lexer.reader.clear();
+			}
+		}
+
+		// Errors come after what was printed before them.
+		auto report(std::string_view message) -> void {
+			sink.flush();
+			error << message << std::endl;
+		}
+
+		// Cycles of lists are collected after the guarded statements, unless one is suspended, since nothing refers into lists between statements.
+		template<typename F>
+		auto guard(F&& action) -> bool {
+			auto completed = true;
+			try {
+				action();
+			}
+			catch (const CommandException& exception) {
+				report(exception.what());
+				kernel.restore(kernel.global_mark());
+				completed = false;
+			}
+			if (!machine.suspended()) {
+				kernel.collector.maybe_collect();
 			}
+			return completed;
 		}
 	};
-}
\ No newline at end of file
+}
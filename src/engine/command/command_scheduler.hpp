@@ -0,0 +1,110 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Runs the code `start`ed on many runtimes, like one per NPC, across a pool of threads.
+	/// Every `tick` gives each runtime with pending code a slice of the budget; runtimes are claimed one at a time by whichever thread is free,
+	/// the calling one included, so a runtime is only ever excuted by one thread at once and the threads stay busy while runtimes are left.
+	/// Runtimes don't share mutable state unless their libraries do, those created from one `CommandContext` share what's immutable or thread-safe.
+	/// Effects the runtimes `post` are queued for `drain` while they're added.
+	/// Only the thread owning the scheduler may add, remove or tick runtimes.
+	/// </summary>
+	struct CommandScheduler
+	{
+		CommandScheduler(size_t thread_count = std::max(1u, std::thread::hardware_concurrency())) {
+			for (size_t i = 1; i < thread_count; ++i) {
+				threads.emplace_back([this] { work(); });
+			}
+		}
+
+		CommandScheduler(const CommandScheduler&) = delete;
+
+		~CommandScheduler() {
+			stopping.store(true, std::memory_order_relaxed);
+			generation.fetch_add(1, std::memory_order_release);
+			generation.notify_all();
+			for (auto& thread : threads) {
+				thread.join();
+			}
+		}
+
+		auto add(CommandRuntime& runtime) -> void {
+			runtime.scheduled = true;
+			runtimes.push_back(&runtime);
+		}
+
+		auto remove(CommandRuntime& runtime) -> void {
+			runtime.scheduled = false;
+			std::erase(runtimes, &runtime);
+		}
+
+		auto size() const -> size_t {
+			return runtimes.size();
+		}
+
+		// The threads excuting slices, the one calling `tick` included.
+		auto thread_count() const -> size_t {
+			return threads.size() + 1;
+		}
+
+		/// <summary>
+		/// Gives every runtime with pending code a slice of `budget`, returns once they're all over, with how many runtimes still have code pending.
+		/// </summary>
+		auto tick(const CommandMachine::Budget& budget = { }) -> size_t {
+			this->budget = budget;
+			next.store(0, std::memory_order_relaxed);
+			left.store(0, std::memory_order_relaxed);
+			active.store(threads.size(), std::memory_order_relaxed);
+			generation.fetch_add(1, std::memory_order_release);
+			generation.notify_all();
+			run_slices();
+			for (auto count = active.load(std::memory_order_acquire); count != 0; count = active.load(std::memory_order_acquire)) {
+				active.wait(count, std::memory_order_acquire);
+			}
+			return left.load(std::memory_order_relaxed);
+		}
+
+		/// <summary>
+		/// Ticks until no runtime has code pending.
+		/// </summary>
+		auto run(const CommandMachine::Budget& budget = { }) -> void {
+			while (tick(budget) != 0) {
+			}
+		}
+
+	private:
+		std::vector<CommandRuntime*> runtimes;
+		std::vector<std::thread> threads;
+		CommandMachine::Budget budget;
+		std::atomic<size_t> next{ 0 }; // the index of the next runtime to be claimed in this tick.
+		std::atomic<size_t> left{ 0 };
+		std::atomic<size_t> active{ 0 }; // threads of the pool still excuting slices of this tick.
+		std::atomic<uint32_t> generation{ 0 }; // bumped by every tick, which the threads of the pool wait on.
+		std::atomic<bool> stopping{ false };
+
+		auto run_slices() -> void {
+			for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < runtimes.size(); i = next.fetch_add(1, std::memory_order_relaxed)) {
+				auto& runtime = *runtimes[i];
+				if (runtime.pending() && runtime.resume(budget)) {
+					left.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		auto work() -> void {
+			uint32_t seen = 0;
+			while (true) {
+				generation.wait(seen, std::memory_order_acquire);
+				seen = generation.load(std::memory_order_acquire);
+				if (stopping.load(std::memory_order_relaxed)) {
+					break;
+				}
+				run_slices();
+				if (active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					active.notify_one();
+				}
+			}
+		}
+	};
+}
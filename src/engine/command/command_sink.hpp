@@ -0,0 +1,74 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Where `print` sends what scripts output: the values themselves, buffered until the sink is flushed,
+	/// so a script printing every frame neither formats text nor writes to a stream unless the consumer does.
+	/// `consumer` is handed the values written since the last flush, in order, on `flush` or once `capacity` values are buffered.
+	/// The buffer keeps its storage between flushes, and holds references to the values, so a list printed and then modified prints as it was.
+	/// `text` adapts an `std::ostream`, on which every value is a line, as arxemand prints them.
+	/// A sink is used by the thread excuting the scripts only.
+	/// </summary>
+	struct CommandSink
+	{
+		using Consumer = std::function<void(std::span<const CommandValue>)>;
+
+		Consumer consumer;
+		size_t capacity = 4096; // values buffered before the sink flushes itself, 0 being only on `flush`.
+
+		CommandSink() = default;
+
+		CommandSink(Consumer consumer) : consumer{ std::move(consumer) } {
+		}
+
+		auto write(CommandValue::Arguments values) -> void {
+			buffer.insert(buffer.end(), values.begin(), values.end());
+			if (capacity != 0 && buffer.size() >= capacity) {
+				flush();
+			}
+		}
+
+		auto flush() -> void {
+			if (buffer.empty()) {
+				return;
+			}
+			if (consumer) {
+				consumer(buffer);
+			}
+			buffer.clear();
+		}
+
+		// Values written since the last flush.
+		auto size() const -> size_t {
+			return buffer.size();
+		}
+
+		/// <summary>
+		/// Writes every value on a line of `output`, the whole batch at once, then flushes the stream.
+		/// </summary>
+		static auto text(std::ostream& output) -> Consumer {
+			return [&output, lines = std::string{ }](std::span<const CommandValue> values) mutable {
+				lines.clear();
+				for (auto& value : values) {
+					// Numbers as `to_string` formats them, without a string each.
+					if (value.is_integer()) {
+						std::format_to(std::back_inserter(lines), "{}.000000\n", value.integer);
+					}
+					else if (value.type == CommandValue::Type::Number) {
+						std::format_to(std::back_inserter(lines), "{:f}\n", value.number);
+					}
+					else {
+						lines += value.to_string();
+						lines += '\n';
+					}
+				}
+				output.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+				output.flush();
+			};
+		}
+
+	private:
+		std::vector<CommandValue> buffer;
+	};
+}
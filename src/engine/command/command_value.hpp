@@ -0,0 +1,635 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// A 16 bytes value. Empties and numbers are stored inline,
+	/// strings, lists and functions are refcounted handles: strings are immutable, lists are copied on write,
+	/// so copying a value never copies its contents.
+	/// A number is either `integral`, a 64-bit integer, or a double. Arithmetic on integers stays exact and is promoted to a double
+	/// when the result isn't an integer or overflows, so a number prints the same either way.
+	/// Lists of numbers made by bulk operations are packed, their elements stored as a dense array of floats.
+	/// </summary>
+	struct CommandValue
+	{
+		enum class Type : uint8_t
+		{
+			Empty,
+			Number,
+			String,
+			List,
+			Function,
+			Macro,
+		};
+
+		using List = std::vector<CommandValue>;
+		using Arguments = std::span<const CommandValue>; // borrowed from the caller for the duration of a call.
+		using Function = std::function<uint32_t(Arguments, CommandValue*)>;
+		using Native = uint32_t(*)(const void* target, const CommandValue& argument, CommandValue*); // `argument` as passed, not spread.
+
+		struct Object {
+			std::atomic<uint32_t> references{ 1 };
+		};
+		struct StringObject : Object {
+			std::string text;
+			StringObject(std::string&& text) : text{ std::move(text) } { }
+		};
+		struct ListObject : Object {
+			List elements; // of a packed list, unpacked from `numbers` by the first `as_list`, after which both are kept.
+			std::vector<float> numbers;
+			bool packed = false;
+			std::once_flag unpacking;
+			bool tracked = false; // and so held by a `CommandCollector`, which doesn't count as sharing it.
+			ListObject(List&& elements) : elements{ std::move(elements) } { }
+			ListObject(std::vector<float>&& numbers) : numbers{ std::move(numbers) }, packed{ true } { }
+		};
+		struct FunctionObject : Object {
+			Function function;
+			Native native = nullptr; // the thunk of a bound builtin, called with `native_target`, the target of `function`, skipping its type erasure.
+			const void* native_target = nullptr;
+			FunctionObject(Function&& function) : function{ std::move(function) } { }
+		};
+
+		Type type;
+		bool integral = false; // of a number.
+		union {
+			bool boolean;
+			double number;
+			int64_t integer;
+			StringObject* string_object;
+			ListObject* list_object;
+			FunctionObject* function_object;
+			Object* object;
+		};
+
+		CommandValue() : type{ Type::Empty }, boolean{ true } {
+		}
+
+		CommandValue(Type type, bool value = true) : type{ type }, boolean{ value } {
+		}
+
+		CommandValue(Type type, float value) : type{ type }, number{ value } {
+		}
+
+		CommandValue(Type type, double value) : type{ type }, number{ value } {
+		}
+
+		CommandValue(Type type, std::string value) : type{ type }, string_object{ new StringObject{ std::move(value) } } {
+		}
+
+		CommandValue(Type type, const char* value) : CommandValue{ type, std::string{ value } } {
+		}
+
+		CommandValue(Type type, List value) : type{ type }, list_object{ new ListObject{ std::move(value) } } {
+		}
+
+		CommandValue(Type type, Function value) : type{ type }, function_object{ new FunctionObject{ std::move(value) } } {
+		}
+
+		static auto from_integer(int64_t value) -> CommandValue {
+			CommandValue result;
+			result.type = Type::Number;
+			result.integral = true;
+			result.integer = value;
+			return result;
+		}
+
+		static auto packed(std::vector<float> numbers) -> CommandValue {
+			CommandValue value;
+			value.type = Type::List;
+			value.list_object = new ListObject{ std::move(numbers) };
+			return value;
+		}
+
+		/// <summary>
+		/// A function object of its own which calls `function`, for a runtime to call a function it shares with runtimes on other threads
+		/// without all of them counting references on the same object. A bound builtin is still called directly. Other values are copied.
+		/// </summary>
+		static auto forwarding(const CommandValue& function) -> CommandValue {
+			if (function.type != Type::Function && function.type != Type::Macro) {
+				return function;
+			}
+			CommandValue value{ function.type, Function{ [function](Arguments arguments, CommandValue* result) -> uint32_t {
+				return function.as_function()(arguments, result);
+			} } };
+			value.function_object->native = function.function_object->native;
+			value.function_object->native_target = function.function_object->native_target; // kept alive by the copy of `function`.
+			return value;
+		}
+
+		CommandValue(const CommandValue& other) : type{ other.type }, integral{ other.integral }, object{ other.object } {
+			retain();
+		}
+
+		CommandValue(CommandValue&& other) noexcept : type{ other.type }, integral{ other.integral }, object{ other.object } {
+			other.type = Type::Empty;
+			other.boolean = true;
+		}
+
+		auto operator=(const CommandValue& other) -> CommandValue& {
+			if (this != &other) {
+				other.retain();
+				release();
+				type = other.type;
+				integral = other.integral;
+				object = other.object;
+			}
+			return *this;
+		}
+
+		auto operator=(CommandValue&& other) noexcept -> CommandValue& {
+			if (this != &other) {
+				release();
+				type = other.type;
+				integral = other.integral;
+				object = other.object;
+				other.type = Type::Empty;
+				other.boolean = true;
+			}
+			return *this;
+		}
+
+		~CommandValue() {
+			release();
+		}
+
+		auto is_object() const -> bool {
+			return type >= Type::String;
+		}
+
+		auto as_boolean() const -> bool {
+			return boolean;
+		}
+
+		auto as_number() const -> double {
+			return integral ? static_cast<double>(integer) : number;
+		}
+
+		auto is_integer() const -> bool {
+			return type == Type::Number && integral;
+		}
+
+		// The number rounded to the nearest integer, as indices are.
+		auto as_integer() const -> int64_t {
+			return integral ? integer : std::llround(number);
+		}
+
+		auto as_string() const -> const std::string& {
+			return string_object->text;
+		}
+
+		auto as_list() const -> const List& {
+			if (list_object->packed) {
+				std::call_once(list_object->unpacking, [object = list_object] {
+					object->elements.reserve(object->numbers.size());
+					for (auto number : object->numbers) {
+						object->elements.emplace_back(Type::Number, number);
+					}
+				});
+			}
+			return list_object->elements;
+		}
+
+		auto is_packed() const -> bool {
+			return list_object->packed;
+		}
+
+		auto as_numbers() const -> const std::vector<float>& {
+			return list_object->numbers;
+		}
+
+		auto list_size() const -> size_t {
+			return list_object->packed ? list_object->numbers.size() : list_object->elements.size();
+		}
+
+		// Detaches the list from other values sharing it before handing out a mutable reference, a packed list is unpacked for good.
+		auto as_list_mut() -> List& {
+			if (list_object->references.load(std::memory_order_acquire) != (list_object->tracked ? 2u : 1u)) {
+				auto copy = new ListObject{ List{ as_list() } };
+				release();
+				list_object = copy;
+			}
+			else if (list_object->packed) {
+				as_list();
+				list_object->numbers = { };
+				list_object->packed = false;
+			}
+			return list_object->elements;
+		}
+
+		auto as_function() const -> const Function& {
+			return function_object->function;
+		}
+
+		auto is_native() const -> bool {
+			return function_object->native != nullptr;
+		}
+
+		auto call_native(const CommandValue& argument, CommandValue* result) const -> uint32_t {
+			return function_object->native(function_object->native_target, argument, result);
+		}
+
+		// What a callee receives when this value is passed to it, a list is spread into its elements.
+		auto as_arguments() const -> Arguments {
+			return type == Type::List ? Arguments{ as_list() } : Arguments{ this, 1 };
+		}
+
+		// The same value seen as another type, used to turn functions into macros and back.
+		auto retyped(Type type) const -> CommandValue {
+			auto result = *this;
+			result.type = type;
+			return result;
+		}
+
+		auto to_string() const -> std::string {
+			switch (type) {
+			case Type::Empty: {
+				return boolean ? "()" : "(-)";
+			}
+			case Type::Number: {
+				return integral ? std::format("{}.000000", integer) : std::to_string(number);
+			}
+			case Type::String: {
+				return as_string();
+			}
+			case Type::List: {
+				std::string result = "[";
+				if (is_packed()) {
+					for (auto number : as_numbers()) {
+						result += std::to_string(number) + ", ";
+					}
+				}
+				else {
+					for (const auto& item : as_list()) {
+						result += item.to_string() + ", ";
+					}
+				}
+				if (result.size() > 1) {
+					result.pop_back();
+					result.pop_back();
+				}
+				result += "]";
+				return result;
+			}
+			case Type::Function: {
+				return "function";
+			}
+			case Type::Macro: {
+				return "marco";
+			}
+			default: {
+				return "unknown";
+			}
+			}
+		}
+
+		auto operator+() const -> CommandValue {
+			return *this;
+		}
+
+		auto operator-() const -> CommandValue {
+			if (type == Type::Empty) {
+				return CommandValue{ Type::Empty, !boolean };
+			}
+			else if (type == Type::Number) {
+				if (integral && integer != std::numeric_limits<int64_t>::min()) {
+					return from_integer(-integer);
+				}
+				return CommandValue{ Type::Number, -as_number() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator+(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty) {
+				return other;
+			}
+			if (other.type == Type::Empty) {
+				return *this;
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				if (integral && other.integral && !adding_overflows(integer, other.integer)) {
+					return from_integer(integer + other.integer);
+				}
+				return CommandValue{ Type::Number, as_number() + other.as_number() };
+			}
+			if (type == Type::List && is_packed() && (other.type == Type::Number || (other.type == Type::List && other.is_packed()))) {
+				std::vector<float> result;
+				auto appended = other.type == Type::Number ? 1 : other.as_numbers().size();
+				result.reserve(as_numbers().size() + appended);
+				result.insert(result.end(), as_numbers().begin(), as_numbers().end());
+				if (other.type == Type::Number) {
+					result.push_back(static_cast<float>(other.as_number()));
+				}
+				else {
+					result.insert(result.end(), other.as_numbers().begin(), other.as_numbers().end());
+				}
+				return packed(std::move(result));
+			}
+			if (type == Type::List) {
+				List result;
+				if (other.type == Type::List) {
+					result.reserve(as_list().size() + other.as_list().size());
+					result.insert(result.end(), as_list().begin(), as_list().end());
+					result.insert(result.end(), other.as_list().begin(), other.as_list().end());
+				}
+				else {
+					result.reserve(as_list().size() + 1);
+					result.insert(result.end(), as_list().begin(), as_list().end());
+					result.push_back(other);
+				}
+				return CommandValue{ Type::List, std::move(result) };
+			}
+			if (type == Type::String || other.type == Type::String) {
+				return CommandValue{ Type::String, to_string() + other.to_string() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator-(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty || other.type == Type::Empty) {
+				return -other;
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				if (integral && other.integral && !subtracting_overflows(integer, other.integer)) {
+					return from_integer(integer - other.integer);
+				}
+				return CommandValue{ Type::Number, as_number() - other.as_number() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator*(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty && other.type == Type::Empty) {
+				return CommandValue(Type::Empty, boolean == other.boolean);
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				if (integral && other.integral && !multiplying_overflows(integer, other.integer)) {
+					return from_integer(integer * other.integer);
+				}
+				return CommandValue{ Type::Number, as_number() * other.as_number() };
+			}
+			if (type == Type::Empty && other.type == Type::Number) {
+				return boolean ? other : -other;
+			}
+			if (type == Type::Number && other.type == Type::Empty) {
+				return other.boolean ? *this : -*this;
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator/(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Number && other.type == Type::Number) {
+				if (integral && other.integral && other.integer != 0 && !(integer == std::numeric_limits<int64_t>::min() && other.integer == -1) && integer % other.integer == 0) {
+					return from_integer(integer / other.integer);
+				}
+				return CommandValue{ Type::Number, as_number() / other.as_number() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator%(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Number && other.type == Type::Number) {
+				if (integral && other.integral && other.integer != 0) {
+					return from_integer(other.integer == -1 ? 0 : integer % other.integer);
+				}
+				return CommandValue{ Type::Number, std::fmod(as_number(), other.as_number()) };
+			}
+			return CommandValue{ Type::Empty, true };
+		}
+
+		auto operator==(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty && other.type == Type::Empty) {
+				return CommandValue{ Type::Empty, boolean == other.boolean };
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				return CommandValue{ Type::Empty, integral && other.integral ? integer == other.integer : as_number() == other.as_number() };
+			}
+			if (type == Type::String && other.type == Type::String) {
+				return CommandValue{ Type::Empty, as_string() == other.as_string() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator!=(const CommandValue& other) const -> CommandValue {
+			auto result = *this == other;
+			result.boolean = !result.boolean;
+			return result;
+		}
+
+		auto operator<(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty && other.type == Type::Empty) {
+				return CommandValue{ Type::Empty, boolean < other.boolean };
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				return CommandValue{ Type::Empty, integral && other.integral ? integer < other.integer : as_number() < other.as_number() };
+			}
+			if (type == Type::String && other.type == Type::String) {
+				return CommandValue{ Type::Empty, as_string() < other.as_string() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator<=(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty && other.type == Type::Empty) {
+				return CommandValue{ Type::Empty, boolean <= other.boolean };
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				return CommandValue{ Type::Empty, integral && other.integral ? integer <= other.integer : as_number() <= other.as_number() };
+			}
+			if (type == Type::String && other.type == Type::String) {
+				return CommandValue{ Type::Empty, as_string() <= other.as_string() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator>(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty && other.type == Type::Empty) {
+				return CommandValue{ Type::Empty, boolean > other.boolean };
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				return CommandValue{ Type::Empty, integral && other.integral ? integer > other.integer : as_number() > other.as_number() };
+			}
+			if (type == Type::String && other.type == Type::String) {
+				return CommandValue{ Type::Empty, as_string() > other.as_string() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator>=(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Empty && other.type == Type::Empty) {
+				return CommandValue{ Type::Empty, boolean >= other.boolean };
+			}
+			if (type == Type::Number && other.type == Type::Number) {
+				return CommandValue{ Type::Empty, integral && other.integral ? integer >= other.integer : as_number() >= other.as_number() };
+			}
+			if (type == Type::String && other.type == Type::String) {
+				return CommandValue{ Type::Empty, as_string() >= other.as_string() };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto operator!() const -> CommandValue {
+			if (type == Type::Empty) {
+				return CommandValue{ Type::Empty, !boolean };
+			}
+			return CommandValue{ Type::Empty, false };
+		}
+
+		auto power(const CommandValue& other) const -> CommandValue {
+			if (type == Type::Number && other.type == Type::Number) {
+				if (integral && other.integral && other.integer >= 0) {
+					// by squaring, unless it overflows.
+					int64_t result = 1;
+					int64_t base = integer;
+					auto exponent = other.integer;
+					while (true) {
+						if ((exponent & 1) != 0) {
+							if (multiplying_overflows(result, base)) {
+								break;
+							}
+							result *= base;
+						}
+						exponent >>= 1;
+						if (exponent == 0) {
+							return from_integer(result);
+						}
+						if (multiplying_overflows(base, base)) {
+							break;
+						}
+						base *= base;
+					}
+				}
+				return CommandValue{ Type::Number, std::pow(as_number(), other.as_number()) };
+			}
+			return CommandValue{ Type::Empty, true };
+		}
+
+	private:
+		static auto adding_overflows(int64_t left, int64_t right) -> bool {
+			return right > 0 ? left > std::numeric_limits<int64_t>::max() - right : left < std::numeric_limits<int64_t>::min() - right;
+		}
+
+		static auto subtracting_overflows(int64_t left, int64_t right) -> bool {
+			return right < 0 ? left > std::numeric_limits<int64_t>::max() + right : left < std::numeric_limits<int64_t>::min() + right;
+		}
+
+		// Conservative: products within a factor of two of the limits count as overflowing, and are computed as doubles.
+		static auto multiplying_overflows(int64_t left, int64_t right) -> bool {
+			return std::abs(static_cast<double>(left) * static_cast<double>(right)) >= 0x1p62;
+		}
+
+		auto retain() const -> void {
+			if (is_object()) {
+				object->references.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		auto release() -> void {
+			if (is_object() && object->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				destroy();
+			}
+		}
+
+		// Apart from `release`, so that releasing stays small enough to be inlined into the loops releasing many values.
+		auto destroy() -> void {
+			switch (type) {
+			case Type::String: {
+				delete string_object;
+				break;
+			}
+			case Type::List: {
+				delete list_object;
+				break;
+			}
+			default: {
+				delete function_object;
+				break;
+			}
+			}
+		}
+	};
+	static_assert(sizeof(CommandValue) == 16);
+
+	inline auto to_string(const CommandValue::Type& type) -> std::string {
+		switch (type) {
+		case CommandValue::Type::Empty: {
+			return "Empty";
+		}
+		case CommandValue::Type::Number: {
+			return "Number";
+		}
+		case CommandValue::Type::String: {
+			return "String";
+		}
+		case CommandValue::Type::List: {
+			return "List";
+		}
+		case CommandValue::Type::Function: {
+			return "Function";
+		}
+		case CommandValue::Type::Macro: {
+			return "Marco";
+		}
+		default: {
+			return "Unknown";
+		}
+		}
+	}
+
+	/// <summary>
+	/// Applies an operation to evaluated operands, `right` is ignored by unary operations.
+	/// </summary>
+	inline auto operate(CommandASTOperationNode::Type type, const CommandValue& left, const CommandValue& right) -> CommandValue {
+		switch (type)
+		{
+		case CommandASTOperationNode::Type::Add: {
+			return left + right;
+		}
+		case CommandASTOperationNode::Type::Subtract: {
+			return left - right;
+		}
+		case CommandASTOperationNode::Type::Multiply: {
+			return left * right;
+		}
+		case CommandASTOperationNode::Type::Divide: {
+			return left / right;
+		}
+		case CommandASTOperationNode::Type::Positive: {
+			return +left;
+		}
+		case CommandASTOperationNode::Type::Negative: {
+			return -left;
+		}
+		case CommandASTOperationNode::Type::Not: {
+			return !left;
+		}
+		case CommandASTOperationNode::Type::Modulo: {
+			return left % right;
+		}
+		case CommandASTOperationNode::Type::Exponent: {
+			return left.power(right);
+		}
+		case CommandASTOperationNode::Type::Equal: {
+			return left == right;
+		}
+		case CommandASTOperationNode::Type::NotEqual: {
+			return left != right;
+		}
+		case CommandASTOperationNode::Type::LessThan: {
+			return left < right;
+		}
+		case CommandASTOperationNode::Type::LessThanOrEqual: {
+			return left <= right;
+		}
+		case CommandASTOperationNode::Type::GreaterThan: {
+			return left > right;
+		}
+		case CommandASTOperationNode::Type::GreaterThanOrEqual: {
+			return left >= right;
+		}
+		default:
+			throw CommandException("Unknow operation.");
+		}
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Watches script files, and tells which of their top level statements are new since the files were last read.
+	/// `poll` returns the code of every file written since, in which the statements already excuted are blanked out,
+	/// so excuting it runs only the new and changed statements, whose errors are located as in the file.
+	/// A changed definition like `f = { ... };` is a new statement, which rebinds `f` once excuted, while unchanged initialisation isn't run again.
+	/// Statements are told apart by their text, from their first token to their `;`, so moving a statement or editing the comments around it runs nothing.
+	/// Statements removed from a file aren't undone.
+	/// </summary>
+	struct CommandWatcher
+	{
+		/// <summary>
+		/// Watches a file, the first `poll` returns all of its code.
+		/// </summary>
+		auto watch(const std::filesystem::path& path) -> void {
+			if (std::find_if(files.begin(), files.end(), [&](const File& file) { return file.path == path; }) == files.end()) {
+				files.push_back({ path });
+			}
+		}
+
+		auto unwatch(const std::filesystem::path& path) -> void {
+			std::erase_if(files, [&](const File& file) { return file.path == path; });
+		}
+
+		/// <summary>
+		/// The code to excute for the watched files written since the last poll, which only costs checking their times otherwise.
+		/// </summary>
+		auto poll() -> std::vector<std::string> {
+			std::vector<std::string> codes;
+			for (auto& file : files) {
+				std::error_code error;
+				auto time = std::filesystem::last_write_time(file.path, error);
+				if (error || time == file.time) {
+					continue;
+				}
+				std::ifstream stream{ file.path, std::ios::binary };
+				if (!stream.is_open()) {
+					continue;
+				}
+				file.time = time;
+				std::stringstream source;
+				source << stream.rdbuf();
+				if (auto code = update(file, source.str()); code.has_value()) {
+					codes.push_back(std::move(*code));
+				}
+			}
+			return codes;
+		}
+
+	private:
+		struct File
+		{
+			std::filesystem::path path;
+			std::filesystem::file_time_type time{ };
+			std::unordered_map<std::string, size_t> statements{ }; // the texts of those excuted, counted since a statement may be repeated.
+		};
+		std::vector<File> files;
+
+		// The code of the new source, or nothing if none of its statements is new.
+		static auto update(File& file, const std::string& source) -> std::optional<std::string> {
+			std::string code(source.size(), ' ');
+			for (size_t i = 0; i < source.size(); ++i) {
+				if (source[i] == '\n') {
+					code[i] = '\n'; // lines are kept, so positions are those of the file.
+				}
+			}
+			auto previous = std::move(file.statements);
+			file.statements.clear();
+			size_t changed_end = 0;
+			for (auto [begin, end] : split(source)) {
+				std::string text{ source.substr(begin, end - begin) };
+				if (auto found = previous.find(text); found != previous.end() && found->second != 0) {
+					--found->second;
+				}
+				else {
+					std::copy(source.begin() + begin, source.begin() + end, code.begin() + begin);
+					changed_end = end;
+				}
+				++file.statements[std::move(text)];
+			}
+			if (changed_end == 0) {
+				return std::nullopt;
+			}
+			code.resize(changed_end); // nothing to lex after the last changed statement.
+			return code;
+		}
+
+		// The ranges of the top level statements, from their first token to their `;`, or to the end of an incomplete last one.
+		// Only comments, strings and brackets need to be known to find them, so they're found without lexing.
+		static auto split(std::string_view source) -> std::vector<std::pair<size_t, size_t>> {
+			std::vector<std::pair<size_t, size_t>> ranges;
+			auto begin = std::string_view::npos;
+			int64_t depth = 0;
+			for (size_t i = 0; i < source.size(); ++i) {
+				auto c = source[i];
+				if (c == '/' && i + 1 < source.size() && source[i + 1] == '/') {
+					auto end = source.find('\n', i);
+					i = end == std::string_view::npos ? source.size() : end;
+					continue;
+				}
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+					continue;
+				}
+				if (begin == std::string_view::npos) {
+					begin = i;
+				}
+				if (c == '"') {
+					for (++i; i < source.size() && source[i] != '"'; ++i) {
+						i += source[i] == '\\' ? 1 : 0;
+					}
+				}
+				else if (c == '(' || c == '{' || c == '[') {
+					++depth;
+				}
+				else if (c == ')' || c == '}' || c == ']') {
+					--depth;
+				}
+				else if (c == ';' && depth <= 0) {
+					ranges.emplace_back(begin, i + 1);
+					begin = std::string_view::npos;
+					depth = 0;
+				}
+			}
+			if (begin != std::string_view::npos) {
+				auto end = source.find_last_not_of(" \t\r\n");
+				ranges.emplace_back(begin, end + 1);
+			}
+			return ranges;
+		}
+	};
+}
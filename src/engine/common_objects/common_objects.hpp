@@ -1 +1,2 @@
-#include "space_transform.hpp"
\ No newline at end of file
+#include "space_transform.hpp"
+#include "entity_transform.hpp"
\ No newline at end of file
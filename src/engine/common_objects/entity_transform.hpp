@@ -0,0 +1,70 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// Where an entity of an `EntityWorld` is, in world space, stored by value among the other entities' transforms.
+	/// Unlike a `SpaceTransform` it has no parent nor children, so it can be moved in memory,
+	/// and its matrix is only recomputed by `get_matrix()` after the position, rotation or scale changed.
+	/// </summary>
+	struct EntityTransform
+	{
+	public:
+		auto set_position(const glm::vec3& pos) -> void {
+			position = pos;
+			changed = true;
+		}
+		auto get_position() const -> glm::vec3 {
+			return position;
+		}
+
+		auto set_rotation(const glm::quat& rotat) -> void {
+			rotation = rotat;
+			changed = true;
+		}
+		auto get_rotation() const -> glm::quat {
+			return rotation;
+		}
+
+		auto set_scale(const glm::vec3& scal) -> void {
+			scale = scal;
+			changed = true;
+		}
+		auto get_scale() const -> glm::vec3 {
+			return scale;
+		}
+
+		auto set_matrix(const glm::mat4& mat) -> void {
+			matrix = mat;
+			position = arx::get_position(mat);
+			scale = arx::get_scale(mat);
+			rotation = arx::get_rotation(mat);
+			changed = false;
+		}
+		auto get_matrix() -> const glm::mat4& {
+			if (changed)
+			{
+				matrix = glm::translate(glm::mat4(1.f), position) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.f), scale);
+				changed = false;
+			}
+			return matrix;
+		}
+
+	public:
+		EntityTransform() = default;
+		EntityTransform(const glm::vec3& position, const glm::quat& rotation = { 1.f, 0.f, 0.f, 0.f }, const glm::vec3& scale = { 1.f, 1.f, 1.f }) :
+			position{ position }, rotation{ rotation }, scale{ scale } {
+		}
+		EntityTransform(const glm::mat4& matrix) {
+			set_matrix(matrix);
+		}
+
+	public:
+		glm::vec3 position = { 0.f, 0.f, 0.f };
+		glm::quat rotation = { 1.f, 0.f, 0.f, 0.f };
+		glm::vec3 scale = { 1.f, 1.f, 1.f };
+		glm::mat4 matrix{ 1.f };
+
+		bool changed = true;
+	};
+}
@@ -8,6 +8,7 @@
 
 #include <set>
 
+#include "physics_objects/entity_rigid_dynamic.hpp"
 #include "physics_objects/physics_system.hpp"
 #include "physics_objects/rigid_dynamic_component.hpp"
 #include "physics_objects/rigid_static_component.hpp"
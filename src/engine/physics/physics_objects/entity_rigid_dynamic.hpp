@@ -0,0 +1,13 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// A rigid dynamic moving the `EntityTransform` of its entity, simulated by the `PhysicsSystem` the `EntityWorld` is given to.
+	/// The system adds the actor to its scene, at the transform, on its first update, and the actor is released by its owner.
+	/// </summary>
+	struct EntityRigidDynamic
+	{
+		RigidDynamic* rigid_dynamic;
+	};
+}
@@ -38,6 +38,9 @@ namespace arx
 				for (auto [actor, transform] : associations) {
 					actor->setGlobalPose(PhysicsTransform(cnv<PhysicsMat44>(transform->get_global_matrix())));
 				}
+				if (world != nullptr) {
+					add_entities();
+				}
 				if (physx_engine != nullptr) {
 					physx_engine->simulate(time_delta);
 				}
@@ -46,6 +49,13 @@ namespace arx
 						transform->set_global_matrix(cnv<glm::mat4>(PhysicsMat44(rigid_dynamic->getGlobalPose())));
 					}
 				}
+				if (world != nullptr) {
+					world->query<EntityTransform, EntityRigidDynamic>().each([](EntityTransform& transform, EntityRigidDynamic& body) {
+						if (!body.rigid_dynamic->isSleeping()) {
+							transform.set_matrix(cnv<glm::mat4>(PhysicsMat44(body.rigid_dynamic->getGlobalPose())));
+						}
+					});
+				}
 				// Normally rigid statics don't move.
 				// In case they do, it must be managed by this system, so we can update the transform at that time.
 				// So anyway, there's no need to update them here.
@@ -64,6 +74,13 @@ namespace arx
 			return time_delta;
 		}
 
+		/// <summary>
+		/// Simulates the entities of the world having an `EntityTransform` and an `EntityRigidDynamic`, from the next update on.
+		/// </summary>
+		auto set_world(EntityWorld* world) -> void {
+			this->world = world;
+		}
+
 		auto add_rigid_dynamic(RigidDynamic* rigid_dynamic, SpaceTransform* transform) -> void {
 			rigid_dynamics.insert({ rigid_dynamic, transform });
 			scene->addActor(*rigid_dynamic);
@@ -89,6 +106,17 @@ namespace arx
 			associations.erase(associations.find(actor));
 		}
 
+	private:
+		// Adds the actors of the entities not in a scene yet to this one, where their transforms are.
+		auto add_entities() -> void {
+			world->query<EntityTransform, EntityRigidDynamic>().each([&](EntityTransform& transform, EntityRigidDynamic& body) {
+				if (body.rigid_dynamic->getScene() == nullptr) {
+					body.rigid_dynamic->setGlobalPose(PhysicsTransform(cnv<PhysicsMat44>(transform.get_matrix())));
+					scene->addActor(*body.rigid_dynamic);
+				}
+			});
+		}
+
 	public:
 		bool mobilized = false;
 		float time_delta = 0.02f;
@@ -96,6 +124,7 @@ namespace arx
 		std::multiset<std::tuple<RigidDynamic*, SpaceTransform*>> rigid_dynamics;
 		std::unordered_map<RigidActor*, SpaceTransform*> associations;
 		PhysicsScene* scene = nullptr;
+		EntityWorld* world = nullptr;
 		PhysXEngine* physx_engine;
 
 	public:
@@ -5,8 +5,10 @@
 #include "../bricks/game_bricks.hpp"
 #include "../common_objects/common_objects.hpp"
 
+#include <numeric>
 #include <set>
 
+#include "graphics_objects/entity_mesh_model.hpp"
 #include "graphics_objects/graphics_system.hpp"
 #include "graphics_objects/mesh_model_component.hpp"
 #include "graphics_objects/ui_element_component.hpp"
\ No newline at end of file
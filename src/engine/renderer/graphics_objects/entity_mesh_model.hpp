@@ -0,0 +1,13 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// A mesh model drawn at the `EntityTransform` of its entity, by the `GraphicsSystem` the `EntityWorld` is given to.
+	/// </summary>
+	struct EntityMeshModel
+	{
+		MeshModel* model;
+		Material* material;
+	};
+}
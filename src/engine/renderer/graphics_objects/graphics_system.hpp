@@ -15,6 +15,7 @@ namespace arx
 				renderer->mesh_models.insert(&mesh_models);
 				renderer->ui_elements.insert(&ui_elements);
 				renderer->debug_mesh_models.insert(&debug_mesh_models);
+				renderer->mesh_model_lists.insert(&entity_mesh_models);
 				mobilized = true;
 			}
 		}
@@ -23,6 +24,7 @@ namespace arx
 				renderer->mesh_models.erase(&mesh_models);
 				renderer->ui_elements.erase(&ui_elements);
 				renderer->debug_mesh_models.erase(&debug_mesh_models);
+				renderer->mesh_model_lists.erase(&entity_mesh_models);
 				mobilized = false;
 			}
 		}
@@ -35,6 +37,9 @@ namespace arx
 						last_transform = transform;
 					}
 				}
+				if (world != nullptr) {
+					update_entities();
+				}
 				if (xr_plugin != nullptr) {
 					xr_plugin->update(camera_offset_transform != nullptr ? camera_offset_transform->get_global_matrix() : glm::mat4{ 1.f });
 				}
@@ -59,6 +64,17 @@ namespace arx
 			return camera_offset_transform;
 		}
 
+		/// <summary>
+		/// Draws the entities of the world having an `EntityTransform` and an `EntityMeshModel`, from the next update on.
+		/// </summary>
+		auto set_world(EntityWorld* world) -> void {
+			this->world = world;
+			if (world == nullptr) {
+				entity_keys.clear();
+				entity_mesh_models.clear();
+			}
+		}
+
 		auto add_mesh_model(MeshModel* model, Material* material, SpaceTransform* transform) -> void {
 			mesh_models.insert({ material, model, &(transform->global_matrix) });
 			transforms.insert(transform);
@@ -125,6 +141,46 @@ namespace arx
 //#endif
 		}
 
+	private:
+		// Lists the mesh models of the entities for the renderer, sorted by material then model as the multisets are,
+		// with the matrices copied, so the renderer doesn't point into the world, whose components move.
+		// The list is only sorted again when the mesh models of the rows changed, otherwise the matrices are written in their places.
+		auto update_entities() -> void {
+			auto query = world->query<EntityTransform, EntityMeshModel>();
+			auto count = query.size();
+			bool reordered = count != entity_keys.size();
+			entity_keys.resize(count);
+			size_t row = 0;
+			query.each([&](EntityTransform&, EntityMeshModel& mesh_model) {
+				std::tuple<Material*, MeshModel*> key{ mesh_model.material, mesh_model.model };
+				if (entity_keys[row] != key) {
+					entity_keys[row] = key;
+					reordered = true;
+				}
+				++row;
+			});
+
+			if (reordered) {
+				std::vector<uint32_t> order(count);
+				std::iota(order.begin(), order.end(), 0);
+				std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return entity_keys[a] < entity_keys[b]; });
+				entity_matrices.resize(count);
+				entity_slots.resize(count);
+				entity_mesh_models.clear();
+				for (size_t slot = 0; slot < count; ++slot) {
+					entity_slots[order[slot]] = static_cast<uint32_t>(slot);
+					auto [material, model] = entity_keys[order[slot]];
+					entity_mesh_models.push_back({ material, model, &entity_matrices[slot] });
+				}
+			}
+
+			row = 0;
+			query.each([&](EntityTransform& transform, EntityMeshModel&) {
+				entity_matrices[entity_slots[row++]] = transform.get_matrix();
+			});
+		}
+
+	public:
 		struct {
 			Material* collider_green = nullptr;
 			Material* trigger_blue = nullptr;
@@ -136,6 +192,11 @@ namespace arx
 		std::list<std::tuple<Bitmap*, UIElement*, glm::mat4*>> ui_elements;
 		std::multiset<std::tuple<Material*, MeshModel*, glm::mat4*>> debug_mesh_models;
 		std::multiset<SpaceTransform*> transforms;
+		EntityWorld* world = nullptr;
+		std::vector<std::tuple<Material*, MeshModel*>> entity_keys; // by row of the query.
+		std::vector<uint32_t> entity_slots; // by row of the query, where its matrix is in `entity_matrices`.
+		std::vector<glm::mat4> entity_matrices;
+		std::vector<std::tuple<Material*, MeshModel*, glm::mat4*>> entity_mesh_models;
 		VulkanRenderer* renderer;
 		OpenXRPlugin* xr_plugin;
 	};
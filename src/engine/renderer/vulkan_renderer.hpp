@@ -180,7 +180,7 @@ namespace arx
 				command_buffer.beginRenderPass(swap_chains[view]->get_render_pass_begin_info(image_index), vk::SubpassContents::eInline);		// <======= Render Pass Begin. TODO: use subpasses.
 
 				bool have_text = false;
-				bool have_mesh = (debug_mode != DebugMode::OnlyDebug) && !mesh_models.empty();
+				bool have_mesh = (debug_mode != DebugMode::OnlyDebug) && (!mesh_models.empty() || !mesh_model_lists.empty());
 				bool have_ui = !ui_elements.empty();
 				bool have_debug = (debug_mode != DebugMode::NoDebug) && !debug_mesh_models.empty();
 
@@ -250,9 +250,10 @@ namespace arx
 					command_buffer.setScissor(0, 1, swap_chains[view]->getScissor());		// <======== Set Scissors.
 
 					// Draw something.
+					glm::mat4 mat_projection_view = mat_projection * mat_camera_view; // outside the lambda, which can't capture structured bindings before C++20.
 					struct { Material* material; MeshModel* mesh_model; glm::mat4* model_transform; } last = { nullptr, nullptr, nullptr };
-					for (auto& models : mesh_models) {
-						for (auto [material, mesh_model, model_transform] : *models) {
+					auto draw_mesh_models = [&](auto& models) {
+						for (auto [material, mesh_model, model_transform] : models) {
 							if (material != last.material) {
 								last.material = material;
 								command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layouts.world_pipeline_layout, 0, { material->descriptor_set }, { });
@@ -266,11 +267,17 @@ namespace arx
 								last.model_transform = model_transform;
 								std::array<PushConstantData, 1> data;
 								data[0].modelMatrix = *model_transform;
-								data[0].projectionView = mat_projection * mat_camera_view * (*model_transform);
+								data[0].projectionView = mat_projection_view * (*model_transform);
 								command_buffer.pushConstants<PushConstantData>(pipeline_layouts.world_pipeline_layout, vk::ShaderStageFlagBits::eVertex, 0, data);
 							}
 							command_buffer.drawIndexed(mesh_model->index_count, 1, 0, 0, 0);
 						}
+					};
+					for (auto& models : mesh_models) {
+						draw_mesh_models(*models);
+					}
+					for (auto& models : mesh_model_lists) {
+						draw_mesh_models(*models);
 					}
 					// End Draw.
 				}
@@ -1839,6 +1846,7 @@ namespace arx
 
 	public: // Not Owning. Don't try to destroy them.
 		std::unordered_set<std::multiset<std::tuple<Material*, MeshModel*, glm::mat4*>>*> mesh_models;	// What a crazy type :D
+		std::unordered_set<std::vector<std::tuple<Material*, MeshModel*, glm::mat4*>>*> mesh_model_lists; // sorted as the multisets, rebuilt every frame.
 		std::unordered_set<std::list<std::tuple<Bitmap*, UIElement*, glm::mat4*>>*> ui_elements;
 		std::unordered_set<std::multiset<std::tuple<Material*, MeshModel*, glm::mat4*>>*> debug_mesh_models;
 	};
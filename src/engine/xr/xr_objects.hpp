@@ -8,6 +8,7 @@
 
 #include <set>
 
+#include "xr_objects/entity_xr_controller.hpp"
 #include "xr_objects/xr_system.hpp"
 #include "xr_objects/xr_controller.hpp"
 #include "xr_objects/xr_point_interactor.hpp"
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace arx
+{
+	/// <summary>
+	/// A controller moving the `EntityTransform` of its entity, tracked by the `XRSystem` the `EntityWorld` is given to.
+	/// </summary>
+	struct EntityXRController
+	{
+		uint32_t controller_id;
+	};
+}
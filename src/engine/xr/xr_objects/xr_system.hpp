@@ -25,6 +25,13 @@ namespace arx
 				transform->set_local_position(cnv<glm::vec3>(xr_plugin->input_state.hand_locations[controller_id].pose.position));
 				transform->set_local_rotation(cnv<glm::quat>(xr_plugin->input_state.hand_locations[controller_id].pose.orientation));
 			}
+			if (world != nullptr) {
+				world->query<EntityTransform, EntityXRController>().each([&](EntityTransform& transform, EntityXRController& controller) {
+					auto& pose = xr_plugin->input_state.hand_locations[controller.controller_id].pose;
+					transform.set_position(cnv<glm::vec3>(pose.position));
+					transform.set_rotation(cnv<glm::quat>(pose.orientation));
+				});
+			}
 			for (auto interactor : interactors) {
 				interactor->pass_actions();
 			}
@@ -41,6 +48,13 @@ namespace arx
 			controllers.erase(controllers.find({ controller_id, nullptr }));
 		}
 
+		/// <summary>
+		/// Tracks the entities of the world having an `EntityTransform` and an `EntityXRController`, from the next update on.
+		/// </summary>
+		auto set_world(EntityWorld* world) -> void {
+			this->world = world;
+		}
+
 		auto add_interactor(Interactor* interactor) -> void {
 			interactors.insert(interactor);
 		}
@@ -52,6 +66,7 @@ namespace arx
 		std::unordered_map<PhysicsActor*, void*> point_interactables;
 		std::unordered_map<PhysicsActor*, void*> grab_interactables;
 		std::multiset<std::tuple<uint32_t, SpaceTransform*>> controllers;
+		EntityWorld* world = nullptr;
 		OpenXRPlugin* xr_plugin;
 	};
 
@@ -1,18 +1,76 @@
 #include "../engine/command/command.hpp"
 
 #include <fstream>
+#include <sstream>
+
+auto load_libraries(arx::CommandRuntime& runtime, const std::unordered_set<std::string>& libraries) -> bool {
+	for (auto& name : libraries) {
+		if (name == "basic") {
+			runtime.load_library(arx::CommandLibrary::basic_library(std::cin, runtime.sink, runtime.kernel, runtime.exit));
+			continue;
+		}
+		try {
+			runtime.import(name);
+		}
+		catch (const arx::CommandException& exception) {
+			std::cerr << "Unknown library: " << name << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// Runs the script with both the compiled machine and the reference tree walker, and compares their outputs.
+auto cross_check(std::istream& file, const std::unordered_set<std::string>& libraries, bool optimizing) -> int {
+	std::stringstream source;
+	source << file.rdbuf();
+
+	std::string outputs[2];
+	arx::CommandMachine::Mode modes[2] = { arx::CommandMachine::Mode::Compiled, arx::CommandMachine::Mode::Reference };
+	for (size_t i = 0; i < 2; ++i) {
+		std::istringstream input{ source.str() };
+		std::ostringstream output;
+		arx::CommandRuntime runtime{ input, output, output };
+		runtime.machine.mode = modes[i];
+		runtime.set_optimizing(optimizing);
+		if (!load_libraries(runtime, libraries)) {
+			return 1;
+		}
+		runtime.run();
+		outputs[i] = output.str();
+	}
+
+	if (outputs[0] != outputs[1]) {
+		std::cout << "Cross-check failed, compiled output:" << std::endl << outputs[0];
+		std::cout << "Reference output:" << std::endl << outputs[1];
+		return 1;
+	}
+	std::cout << outputs[0];
+	std::cout << "Cross-check passed." << std::endl;
+	return 0;
+}
 
 auto main(int argument_count, char* arguments[]) -> int {
 	bool ast_mode = false;
+	bool reference_mode = false;
+	bool cross_check_mode = false;
+	bool optimizing = true;
+	bool caching = true;
+	bool profiling = false;
 	std::unordered_set<std::string> libraries = { "basic" };
 
 	std::ifstream file;
+	std::filesystem::path path;
+	arx::CommandModuleRegistry::standard().search_paths.push_back(std::filesystem::current_path());
 
 	for (int i = 1; i < argument_count; ++i) {
 		std::string_view argument{ arguments[i] };
 
 		if (argument[0] != '-') {
-			file.open(argument.data());
+			path = argument;
+			file.open(path);
+			// Modules imported by the script are looked for next to it.
+			arx::CommandModuleRegistry::standard().search_paths.push_back(std::filesystem::path{ argument }.parent_path());
 			break;
 		}
 		else if (argument == "-h" || argument == "--help") {
@@ -21,6 +79,11 @@ auto main(int argument_count, char* arguments[]) -> int {
 			std::cout << "  -h, --help\t\t\tShow this help message and exit" << std::endl;
 			std::cout << "  -a, --ast\t\t\tPrint the AST of the program and exit" << std::endl;
 			std::cout << "  -n, --no-basic\t\tDo not load the basic library" << std::endl;
+			std::cout << "  -r, --reference\t\tExcute with the reference tree walker instead of the compiled machine" << std::endl;
+			std::cout << "  --cross-check\t\t\tExcute the file in both modes and compare their outputs" << std::endl;
+			std::cout << "  --no-optimize\t\t\tDo not fold constants or prune constant conditions" << std::endl;
+			std::cout << "  --no-cache\t\t\tDo not load or save the compiled file (.arxc) next to the file" << std::endl;
+			std::cout << "  --profile\t\t\tPrint the calls and time of every function and builtin once excuted" << std::endl;
 			std::cout << "  --lib=<name>[,<name>...]\tLoad the specified libraries" << std::endl;
 			return 0;
 		}
@@ -30,6 +93,21 @@ auto main(int argument_count, char* arguments[]) -> int {
 		else if (argument == "-n" || argument == "--no-basic") {
 			libraries.erase("basic");
 		}
+		else if (argument == "-r" || argument == "--reference") {
+			reference_mode = true;
+		}
+		else if (argument == "--cross-check") {
+			cross_check_mode = true;
+		}
+		else if (argument == "--no-optimize") {
+			optimizing = false;
+		}
+		else if (argument == "--no-cache") {
+			caching = false;
+		}
+		else if (argument == "--profile") {
+			profiling = true;
+		}
 		else if (argument.rfind("--lib=", 0) == 0) {
 			std::string name;
 			for (const char c : argument.substr(6)) {
@@ -53,25 +131,38 @@ auto main(int argument_count, char* arguments[]) -> int {
 
 	if (ast_mode) {
 		arx::CommandASTPrinterRuntime runtime{ file.is_open() ? file : std::cin, std::cout };
+		runtime.parser.optimizing = optimizing;
 		runtime.run();
-	} else {
-		arx::CommandRuntime runtime{ file.is_open() ? file : std::cin, std::cout };
-		for (auto& name : libraries) {
-			if (name == "basic") {
-				runtime.load_library(arx::CommandLibrary::basic_library(std::cin, std::cout, runtime.kernel, runtime.exit));
-			}
-			else if (name == "math") {
-				runtime.load_library(arx::CommandLibrary::math_library());
-			}
-			else if (name == "string") {
-				runtime.load_library(arx::CommandLibrary::string_library());
-			}
-			else {
-				std::cerr << "Unknown library: " << name << std::endl;
-				return 1;
-			}
+	}
+	else if (cross_check_mode) {
+		if (!file.is_open()) {
+			std::cerr << "--cross-check requires a file." << std::endl;
+			return 1;
+		}
+		return cross_check(file, libraries, optimizing);
+	}
+	else {
+		arx::CommandRuntime runtime{ std::cin, std::cout };
+		if (reference_mode) {
+			runtime.machine.mode = arx::CommandMachine::Mode::Reference;
+		}
+		runtime.set_optimizing(optimizing);
+		runtime.archiving = caching;
+		runtime.kernel.profiler.enabled = profiling;
+		if (!load_libraries(runtime, libraries)) {
+			return 1;
+		}
+		if (path.empty()) {
+			runtime.run();
+		}
+		else if (!runtime.run_file(path)) {
+			std::cerr << "Cannot open " << path.string() << std::endl;
+			return 1;
+		}
+		if (profiling) {
+			runtime.sink.flush();
+			runtime.kernel.profiler.print(std::cerr);
 		}
-		return runtime.run();
 	}
 	return 0;
 }
\ No newline at end of file
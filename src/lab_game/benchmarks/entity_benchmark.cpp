@@ -0,0 +1,267 @@
+#include "../../engine/bricks/game_bricks.hpp"
+#include "../../engine/common_objects/common_objects.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string_view>
+
+// Compares iterating entities stored by an `EntityWorld` with the pointer chasing path of the systems,
+// where every component is allocated on its own and systems walk multisets of pointers to them.
+// Usage: entity_benchmark [options]
+// Each pass is one of what the systems do every frame, measured on both paths:
+//   move      writes a new position into every transform, as physics and XR do.
+//   matrices  recomputes the matrices of the transforms, as `GraphicsSystem::update` does.
+//   draw      walks the (material, model, matrix) triples, as the renderer does, the entities' list being updated first, as `GraphicsSystem` does.
+// Materials and models stand in for the renderer's, so only the memory accesses are measured, not Vulkan.
+
+struct Material { int id; };
+struct MeshModel { int id; };
+struct Body { int id; }; // stands in for a `RigidDynamic`.
+
+// As `arx::EntityMeshModel`, which needs the renderer.
+struct EntityMeshModel
+{
+	MeshModel* model;
+	Material* material;
+};
+
+struct Options
+{
+	size_t entities = 10000;
+	double minimum_seconds = 0.3;
+	size_t minimum_rounds = 5;
+};
+
+// The current path: components allocated one by one, among the other allocations of a scene, and registered as pointers.
+struct PointerScene
+{
+	std::vector<std::unique_ptr<arx::SpaceTransform>> transforms_owned;
+	std::vector<std::unique_ptr<char[]>> others; // what else the components allocate, which scatters them.
+	std::multiset<std::tuple<Body*, arx::SpaceTransform*>> bodies;
+	std::multiset<arx::SpaceTransform*> transforms;
+	std::multiset<std::tuple<Material*, MeshModel*, glm::mat4*>> mesh_models;
+};
+
+// The same scene as entities.
+struct EntityScene
+{
+	arx::EntityWorld world;
+	std::vector<std::tuple<Material*, MeshModel*>> keys;
+	std::vector<uint32_t> slots;
+	std::vector<glm::mat4> matrices;
+	std::vector<std::tuple<Material*, MeshModel*, glm::mat4*>> mesh_models;
+
+	// As `GraphicsSystem::update_entities`.
+	auto update_mesh_models() -> void {
+		auto query = world.query<arx::EntityTransform, EntityMeshModel>();
+		auto count = query.size();
+		bool reordered = count != keys.size();
+		keys.resize(count);
+		size_t row = 0;
+		query.each([&](arx::EntityTransform&, EntityMeshModel& mesh_model) {
+			std::tuple<Material*, MeshModel*> key{ mesh_model.material, mesh_model.model };
+			if (keys[row] != key) {
+				keys[row] = key;
+				reordered = true;
+			}
+			++row;
+		});
+
+		if (reordered) {
+			std::vector<uint32_t> order(count);
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+			matrices.resize(count);
+			slots.resize(count);
+			mesh_models.clear();
+			for (size_t slot = 0; slot < count; ++slot) {
+				slots[order[slot]] = static_cast<uint32_t>(slot);
+				auto [material, model] = keys[order[slot]];
+				mesh_models.push_back({ material, model, &matrices[slot] });
+			}
+		}
+
+		row = 0;
+		query.each([&](arx::EntityTransform& transform, EntityMeshModel&) {
+			matrices[slots[row++]] = transform.get_matrix();
+		});
+	}
+};
+
+struct Pass
+{
+	std::string_view name;
+	std::function<float()> pointers;
+	std::function<float()> entities;
+};
+
+// The median time of a round in nanoseconds.
+auto measure(const std::function<float()>& round, const Options& options, float& sink) -> double {
+	sink += round(); // warming up.
+	std::vector<double> times;
+	double total_seconds = 0;
+	while (times.size() < options.minimum_rounds || total_seconds < options.minimum_seconds) {
+		auto start = std::chrono::steady_clock::now();
+		sink += round();
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		times.push_back(std::chrono::duration<double, std::nano>(elapsed).count());
+		total_seconds += times.back() / 1e9;
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+auto main(int argument_count, char* arguments[]) -> int {
+	Options options;
+	for (int i = 1; i < argument_count; ++i) {
+		std::string_view argument{ arguments[i] };
+
+		if (argument == "-h" || argument == "--help") {
+			std::cout << "Usage: entity_benchmark [options]" << std::endl;
+			std::cout << "Options:" << std::endl;
+			std::cout << "  -h, --help\t\t\tShow this help message and exit" << std::endl;
+			std::cout << "  --entities=<count>\t\tCreate this many entities (default 10000)" << std::endl;
+			std::cout << "  --min-time=<seconds>\t\tRun rounds for at least this long per pass and path (default 0.3)" << std::endl;
+			std::cout << "  --min-rounds=<count>\t\tRun at least this many rounds per pass and path (default 5)" << std::endl;
+			return 0;
+		}
+		else if (argument.rfind("--entities=", 0) == 0) {
+			options.entities = std::max<size_t>(1, std::stoul(std::string{ argument.substr(11) }));
+		}
+		else if (argument.rfind("--min-time=", 0) == 0) {
+			options.minimum_seconds = std::stod(std::string{ argument.substr(11) });
+		}
+		else if (argument.rfind("--min-rounds=", 0) == 0) {
+			options.minimum_rounds = std::max<size_t>(1, std::stoul(std::string{ argument.substr(13) }));
+		}
+		else {
+			std::cerr << "Unknown option: " << argument << std::endl;
+			return 1;
+		}
+	}
+
+	std::mt19937 random{ 42 };
+	std::vector<Material> materials(8);
+	std::vector<MeshModel> models(16);
+	std::vector<Body> bodies(options.entities);
+	std::uniform_int_distribution<size_t> pick_material{ 0, materials.size() - 1 };
+	std::uniform_int_distribution<size_t> pick_model{ 0, models.size() - 1 };
+	std::uniform_int_distribution<size_t> other_size{ 64, 512 };
+
+	PointerScene pointers;
+	EntityScene entities;
+	for (size_t i = 0; i < options.entities; ++i) {
+		glm::vec3 position{ static_cast<float>(i % 100), static_cast<float>(i / 100), 0.f };
+		auto material = &materials[pick_material(random)];
+		auto model = &models[pick_model(random)];
+
+		auto& transform = *pointers.transforms_owned.emplace_back(std::make_unique<arx::SpaceTransform>(position));
+		pointers.others.push_back(std::make_unique<char[]>(other_size(random)));
+		pointers.bodies.insert({ &bodies[i], &transform });
+		pointers.transforms.insert(&transform);
+		pointers.mesh_models.insert({ material, model, &transform.global_matrix });
+
+		entities.world.create(arx::EntityTransform{ position }, Body{ static_cast<int>(i) }, EntityMeshModel{ model, material });
+	}
+
+	float step = 0.f;
+	std::vector<Pass> passes{
+		{
+			"move",
+			[&] {
+				step += 0.001f;
+				for (auto [body, transform] : pointers.bodies) {
+					transform->set_local_position({ transform->local_position.x, transform->local_position.y, step });
+				}
+				return 0.f;
+			},
+			[&] {
+				step += 0.001f;
+				entities.world.query<arx::EntityTransform, Body>().each([&](arx::EntityTransform& transform, Body&) {
+					transform.set_position({ transform.position.x, transform.position.y, step });
+				});
+				return 0.f;
+			},
+		},
+		{
+			"matrices",
+			[&] {
+				float sum = 0.f;
+				for (auto transform : pointers.transforms) {
+					transform->global_changed = true;
+					transform->local_changed = true;
+					sum += (*std::get<1>(transform->update_matrix()))[3][2];
+				}
+				return sum;
+			},
+			[&] {
+				float sum = 0.f;
+				entities.world.query<arx::EntityTransform>().each([&](arx::EntityTransform& transform) {
+					transform.changed = true;
+					sum += transform.get_matrix()[3][2];
+				});
+				return sum;
+			},
+		},
+		{
+			"draw",
+			[&] {
+				float sum = 0.f;
+				Material* last_material = nullptr;
+				MeshModel* last_model = nullptr;
+				for (auto [material, model, matrix] : pointers.mesh_models) {
+					sum += material != last_material ? static_cast<float>(material->id) : 0.f;
+					sum += model != last_model ? static_cast<float>(model->id) : 0.f;
+					last_material = material;
+					last_model = model;
+					sum += (*matrix)[3][0];
+				}
+				return sum;
+			},
+			[&] {
+				entities.update_mesh_models();
+				float sum = 0.f;
+				Material* last_material = nullptr;
+				MeshModel* last_model = nullptr;
+				for (auto [material, model, matrix] : entities.mesh_models) {
+					sum += material != last_material ? static_cast<float>(material->id) : 0.f;
+					sum += model != last_model ? static_cast<float>(model->id) : 0.f;
+					last_material = material;
+					last_model = model;
+					sum += (*matrix)[3][0];
+				}
+				return sum;
+			},
+		},
+	};
+
+	std::cout << std::left << std::setw(12) << "pass" << std::right << std::setw(10) << "entities"
+		<< std::setw(16) << "pointers ns/e" << std::setw(16) << "entities ns/e" << std::setw(10) << "speedup" << std::endl;
+	std::cout.setf(std::ios::fixed);
+
+	float sink = 0.f;
+	double pointers_total = 0;
+	double entities_total = 0;
+	auto print = [&](std::string_view name, double pointers_nanoseconds, double entities_nanoseconds) {
+		auto count = static_cast<double>(options.entities);
+		std::cout << std::left << std::setw(12) << name << std::right << std::setw(10) << options.entities
+			<< std::setw(16) << std::setprecision(2) << pointers_nanoseconds / count
+			<< std::setw(16) << std::setprecision(2) << entities_nanoseconds / count
+			<< std::setw(9) << std::setprecision(2) << pointers_nanoseconds / entities_nanoseconds << 'x' << std::endl;
+	};
+	for (auto& pass : passes) {
+		auto pointers_nanoseconds = measure(pass.pointers, options, sink);
+		auto entities_nanoseconds = measure(pass.entities, options, sink);
+		pointers_total += pointers_nanoseconds;
+		entities_total += entities_nanoseconds;
+		print(pass.name, pointers_nanoseconds, entities_nanoseconds);
+	}
+	print("frame", pointers_total, entities_total);
+	return sink == 12345.f ? 1 : 0; // keeps the passes from being optimized out.
+}
@@ -0,0 +1,426 @@
+#include "../../engine/command/command.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <sstream>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Runs the `.arx` workloads the way arxemand does, and reports the time, heap allocations and peak memory of each.
+// Usage: interpreter_benchmark [options] [workload...]
+// An operation is one run of a whole workload on a fresh runtime, libraries loaded outside the measurement,
+// so the numbers of two revisions built from the same workloads can be compared directly, e.g. with `--csv` and `--baseline`.
+
+#ifndef ARXEMAND_WORKLOADS_DIR
+#define ARXEMAND_WORKLOADS_DIR "benchmarks/workloads"
+#endif
+
+static std::atomic<uint64_t> allocation_count{ 0 };
+
+// Every form of the global operators is replaced, so that whichever of them a container picks, its allocations are counted and freed by the matching function.
+// Freeing is kept out of line, GCC would otherwise take the inlined `free` for one mismatching `operator new`.
+#if defined(_MSC_VER)
+#define ARXEMAND_OUT_OF_LINE __declspec(noinline)
+#else
+#define ARXEMAND_OUT_OF_LINE __attribute__((noinline))
+#endif
+
+static auto allocate(size_t size) noexcept -> void* {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+static auto allocate(size_t size, std::align_val_t alignment) noexcept -> void* {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	auto bytes = static_cast<size_t>(alignment);
+#if defined(_WIN32)
+	return _aligned_malloc(size == 0 ? 1 : size, bytes);
+#else
+	return std::aligned_alloc(bytes, (size + bytes - 1) / bytes * bytes + (size == 0 ? bytes : 0)); // a multiple of the alignment.
+#endif
+}
+
+ARXEMAND_OUT_OF_LINE static auto release(void* pointer) noexcept -> void {
+	std::free(pointer);
+}
+
+ARXEMAND_OUT_OF_LINE static auto release(void* pointer, std::align_val_t) noexcept -> void {
+#if defined(_WIN32)
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+auto operator new(size_t size) -> void* {
+	if (auto pointer = allocate(size)) {
+		return pointer;
+	}
+	throw std::bad_alloc{ };
+}
+
+auto operator new(size_t size, std::align_val_t alignment) -> void* {
+	if (auto pointer = allocate(size, alignment)) {
+		return pointer;
+	}
+	throw std::bad_alloc{ };
+}
+
+auto operator new(size_t size, const std::nothrow_t&) noexcept -> void* {
+	return allocate(size);
+}
+
+auto operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept -> void* {
+	return allocate(size, alignment);
+}
+
+auto operator new[](size_t size) -> void* {
+	return operator new(size);
+}
+
+auto operator new[](size_t size, std::align_val_t alignment) -> void* {
+	return operator new(size, alignment);
+}
+
+auto operator new[](size_t size, const std::nothrow_t&) noexcept -> void* {
+	return allocate(size);
+}
+
+auto operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept -> void* {
+	return allocate(size, alignment);
+}
+
+auto operator delete(void* pointer) noexcept -> void {
+	release(pointer);
+}
+
+auto operator delete(void* pointer, size_t) noexcept -> void {
+	release(pointer);
+}
+
+auto operator delete(void* pointer, const std::nothrow_t&) noexcept -> void {
+	release(pointer);
+}
+
+auto operator delete(void* pointer, std::align_val_t alignment) noexcept -> void {
+	release(pointer, alignment);
+}
+
+auto operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept -> void {
+	release(pointer, alignment);
+}
+
+auto operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept -> void {
+	release(pointer, alignment);
+}
+
+auto operator delete[](void* pointer) noexcept -> void {
+	release(pointer);
+}
+
+auto operator delete[](void* pointer, size_t) noexcept -> void {
+	release(pointer);
+}
+
+auto operator delete[](void* pointer, const std::nothrow_t&) noexcept -> void {
+	release(pointer);
+}
+
+auto operator delete[](void* pointer, std::align_val_t alignment) noexcept -> void {
+	release(pointer, alignment);
+}
+
+auto operator delete[](void* pointer, size_t, std::align_val_t alignment) noexcept -> void {
+	release(pointer, alignment);
+}
+
+auto operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept -> void {
+	release(pointer, alignment);
+}
+
+// Resets the peak so it's measured per workload where the system allows it; elsewhere the peak only grows across workloads.
+auto reset_peak_memory() -> void {
+#if defined(__linux__)
+	std::ofstream{ "/proc/self/clear_refs" } << "5";
+#endif
+}
+
+// In KiB.
+auto peak_memory() -> uint64_t {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{ };
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize / 1024;
+#else
+#if defined(__linux__)
+	std::ifstream status{ "/proc/self/status" };
+	std::string line;
+	while (std::getline(status, line)) {
+		if (line.rfind("VmHWM:", 0) == 0) {
+			return std::stoull(line.substr(6));
+		}
+	}
+#endif
+	rusage usage{ };
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+struct Workload
+{
+	std::string name;
+	std::string source;
+};
+
+struct Result
+{
+	std::string name;
+	size_t operations = 0;
+	double nanoseconds = 0; // per operation, the median of all operations.
+	double allocations = 0; // per operation.
+	uint64_t peak_kilobytes = 0;
+};
+
+struct Options
+{
+	arx::CommandMachine::Mode mode = arx::CommandMachine::Mode::Compiled;
+	bool optimizing = true;
+	double minimum_seconds = 1.0;
+	size_t minimum_operations = 5;
+	std::filesystem::path directory = ARXEMAND_WORKLOADS_DIR;
+	std::vector<std::string> names;
+	std::string csv;
+	std::string baseline;
+};
+
+// One operation, returning the errors it printed.
+auto run_once(const Workload& workload, const Options& options, double& nanoseconds, uint64_t& allocations) -> std::string {
+	std::istringstream input;
+	std::ostringstream output;
+	std::ostringstream errors;
+	arx::CommandRuntime runtime{ input, output, errors };
+	runtime.machine.mode = options.mode;
+	runtime.set_optimizing(options.optimizing);
+	runtime.load_library(arx::CommandLibrary::basic_library(input, runtime.sink, runtime.kernel, runtime.exit));
+	runtime.import("math");
+	runtime.import("string");
+
+	auto allocated = allocation_count.load(std::memory_order_relaxed);
+	auto start = std::chrono::steady_clock::now();
+	runtime.run_code(workload.source);
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	allocations = allocation_count.load(std::memory_order_relaxed) - allocated;
+	nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count();
+	return errors.str();
+}
+
+auto measure(const Workload& workload, const Options& options) -> std::optional<Result> {
+	Result result{ workload.name };
+	double nanoseconds = 0;
+	uint64_t allocations = 0;
+
+	reset_peak_memory();
+	if (auto errors = run_once(workload, options, nanoseconds, allocations); !errors.empty()) { // warming up.
+		std::cerr << workload.name << " failed:" << std::endl << errors;
+		return std::nullopt;
+	}
+
+	std::vector<double> times;
+	uint64_t total_allocations = 0;
+	double total_seconds = 0;
+	while (times.size() < options.minimum_operations || total_seconds < options.minimum_seconds) {
+		run_once(workload, options, nanoseconds, allocations);
+		times.push_back(nanoseconds);
+		total_allocations += allocations;
+		total_seconds += nanoseconds / 1e9;
+	}
+	std::sort(times.begin(), times.end());
+
+	result.operations = times.size();
+	result.nanoseconds = times[times.size() / 2];
+	result.allocations = static_cast<double>(total_allocations) / times.size();
+	result.peak_kilobytes = peak_memory();
+	return result;
+}
+
+auto load_workloads(const Options& options) -> std::vector<Workload> {
+	std::vector<Workload> workloads;
+	std::error_code error;
+	for (auto& entry : std::filesystem::directory_iterator{ options.directory, error }) {
+		if (entry.path().extension() != ".arx") {
+			continue;
+		}
+		auto name = entry.path().stem().string();
+		if (!options.names.empty() && std::find(options.names.begin(), options.names.end(), name) == options.names.end()) {
+			continue;
+		}
+		std::ifstream file{ entry.path() };
+		std::stringstream source;
+		source << file.rdbuf();
+		workloads.push_back({ std::move(name), source.str() });
+	}
+	if (error) {
+		std::cerr << "Cannot read " << options.directory.string() << ": " << error.message() << std::endl;
+	}
+	std::sort(workloads.begin(), workloads.end(), [](const Workload& a, const Workload& b) { return a.name < b.name; });
+	return workloads;
+}
+
+auto write_csv(const std::string& path, const std::vector<Result>& results) -> void {
+	std::ofstream file{ path };
+	file.setf(std::ios::fixed);
+	file.precision(1);
+	file << "workload,operations,ns_per_op,allocations_per_op,peak_rss_kib" << std::endl;
+	for (auto& result : results) {
+		file << result.name << ',' << result.operations << ',' << result.nanoseconds << ',' << result.allocations << ',' << result.peak_kilobytes << std::endl;
+	}
+}
+
+auto read_csv(const std::string& path) -> std::map<std::string, Result> {
+	std::map<std::string, Result> results;
+	std::ifstream file{ path };
+	if (!file.is_open()) {
+		std::cerr << "Cannot open " << path << std::endl;
+		return results;
+	}
+	std::string line;
+	std::getline(file, line); // the header.
+	while (std::getline(file, line)) {
+		std::istringstream fields{ line };
+		Result result;
+		std::string field;
+		std::getline(fields, result.name, ',');
+		std::getline(fields, field, ','); result.operations = std::stoull(field);
+		std::getline(fields, field, ','); result.nanoseconds = std::stod(field);
+		std::getline(fields, field, ','); result.allocations = std::stod(field);
+		std::getline(fields, field, ','); result.peak_kilobytes = std::stoull(field);
+		results.emplace(result.name, result);
+	}
+	return results;
+}
+
+auto change(double current, double baseline) -> std::string {
+	if (baseline == 0) {
+		return current == 0 ? "+0.0%" : "n/a";
+	}
+	std::ostringstream text;
+	text.setf(std::ios::fixed | std::ios::showpos);
+	text.precision(1);
+	text << (current - baseline) / baseline * 100 << '%';
+	return text.str();
+}
+
+auto print_results(const std::vector<Result>& results, const std::map<std::string, Result>& baseline) -> void {
+	std::cout << std::left << std::setw(20) << "workload" << std::right
+		<< std::setw(8) << "ops" << std::setw(16) << "ns/op" << std::setw(14) << "allocs/op" << std::setw(16) << "peak RSS (KiB)";
+	if (!baseline.empty()) {
+		std::cout << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op" << std::setw(12) << "peak RSS";
+	}
+	std::cout << std::endl;
+
+	std::cout.setf(std::ios::fixed);
+	std::cout.precision(0);
+	for (auto& result : results) {
+		std::cout << std::left << std::setw(20) << result.name << std::right
+			<< std::setw(8) << result.operations << std::setw(16) << result.nanoseconds
+			<< std::setw(14) << std::setprecision(1) << result.allocations << std::setprecision(0)
+			<< std::setw(16) << result.peak_kilobytes;
+		if (auto found = baseline.find(result.name); found != baseline.end()) {
+			auto& base = found->second;
+			std::cout << std::setw(12) << change(result.nanoseconds, base.nanoseconds)
+				<< std::setw(12) << change(result.allocations, base.allocations)
+				<< std::setw(12) << change(static_cast<double>(result.peak_kilobytes), static_cast<double>(base.peak_kilobytes));
+		}
+		std::cout << std::endl;
+	}
+}
+
+auto main(int argument_count, char* arguments[]) -> int {
+	Options options;
+	for (int i = 1; i < argument_count; ++i) {
+		std::string_view argument{ arguments[i] };
+
+		if (argument == "-h" || argument == "--help") {
+			std::cout << "Usage: interpreter_benchmark [options] [workload...]" << std::endl;
+			std::cout << "Options:" << std::endl;
+			std::cout << "  -h, --help\t\t\tShow this help message and exit" << std::endl;
+			std::cout << "  -r, --reference\t\tExcute with the reference tree walker instead of the compiled machine" << std::endl;
+			std::cout << "  --no-optimize\t\t\tDo not fold constants or prune constant conditions" << std::endl;
+			std::cout << "  --workloads=<directory>\tRead the .arx workloads from the directory" << std::endl;
+			std::cout << "  --min-time=<seconds>\t\tRun each workload for at least this long (default 1)" << std::endl;
+			std::cout << "  --min-ops=<count>\t\tRun each workload at least this many times (default 5)" << std::endl;
+			std::cout << "  --csv=<file>\t\t\tWrite the results to a CSV file" << std::endl;
+			std::cout << "  --baseline=<file>\t\tCompare with the results of an earlier --csv" << std::endl;
+			return 0;
+		}
+		else if (argument == "-r" || argument == "--reference") {
+			options.mode = arx::CommandMachine::Mode::Reference;
+		}
+		else if (argument == "--no-optimize") {
+			options.optimizing = false;
+		}
+		else if (argument.rfind("--workloads=", 0) == 0) {
+			options.directory = argument.substr(12);
+		}
+		else if (argument.rfind("--min-time=", 0) == 0) {
+			options.minimum_seconds = std::stod(std::string{ argument.substr(11) });
+		}
+		else if (argument.rfind("--min-ops=", 0) == 0) {
+			options.minimum_operations = std::max<size_t>(1, std::stoul(std::string{ argument.substr(10) }));
+		}
+		else if (argument.rfind("--csv=", 0) == 0) {
+			options.csv = argument.substr(6);
+		}
+		else if (argument.rfind("--baseline=", 0) == 0) {
+			options.baseline = argument.substr(11);
+		}
+		else if (argument[0] == '-') {
+			std::cerr << "Unknown option: " << argument << std::endl;
+			return 1;
+		}
+		else {
+			options.names.emplace_back(argument);
+		}
+	}
+
+	auto workloads = load_workloads(options);
+	if (workloads.empty()) {
+		std::cerr << "No workloads found in " << options.directory.string() << std::endl;
+		return 1;
+	}
+
+	bool failed = false;
+	std::vector<Result> results;
+	for (auto& workload : workloads) {
+		if (auto result = measure(workload, options)) {
+			results.push_back(std::move(*result));
+		}
+		else {
+			failed = true;
+		}
+	}
+
+	print_results(results, options.baseline.empty() ? std::map<std::string, Result>{ } : read_csv(options.baseline));
+	if (!options.csv.empty()) {
+		write_csv(options.csv, results);
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#include "../../engine/command/command.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+// Measures how fast command source is turned into tokens, and into statements.
+// Usage: lexer_benchmark [file] [rounds]
+// Without a file, a generated script of a few megabytes is used.
+
+struct DiscardingInterpreter
+{
+	size_t statements = 0;
+
+	auto operator<<(const arx::CommandASTStatementNode&) -> DiscardingInterpreter& {
+		++statements;
+		return *this;
+	}
+};
+
+auto generate_source() -> std::string {
+	const std::string_view sample =
+		"// Generated benchmark source.\n"
+		"fib = { >1 < 2 ? < >1 : < fib(>1 - 1) + fib(>1 - 2); };\n"
+		"count = { i := 0; s := 0; { s = s + i * 2.5; i = i + 1; i < 1000 ? % ; }(); < s; };\n"
+		"greeting = \"Hello,\\tworld!\\n\";\n"
+		"values = 1, 2.25, -3, (4 ^ 2) / 8, 10 % 3;\n"
+		"check = { [x] = >1; x >= 0 ? < x != 0 : < (-); };\n";
+	std::string source;
+	while (source.size() < 4 * 1024 * 1024) {
+		source += sample;
+	}
+	return source;
+}
+
+template<typename F>
+auto measure(size_t rounds, F&& action) -> double {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < rounds; ++i) {
+		action();
+	}
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+auto main(int argument_count, char* arguments[]) -> int {
+	std::string source;
+	if (argument_count > 1) {
+		std::ifstream file{ arguments[1] };
+		if (!file.is_open()) {
+			std::cerr << "Cannot open " << arguments[1] << std::endl;
+			return 1;
+		}
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		source = buffer.str();
+	}
+	else {
+		source = generate_source();
+	}
+	size_t rounds = argument_count > 2 ? std::stoul(arguments[2]) : 20;
+	constexpr size_t chunk_size = arx::CommandLexer<DiscardingInterpreter>::chunk_size;
+
+	size_t tokens = 0;
+	auto lexing = measure(rounds, [&] {
+		arx::CommandReader reader;
+		tokens = 0;
+		for (size_t offset = 0; offset < source.size(); offset += chunk_size) {
+			reader.feed(std::string_view{ source }.substr(offset, chunk_size));
+			while (reader.next(false)) {
+				++tokens;
+			}
+		}
+		while (reader.next(true)) {
+			++tokens;
+		}
+	});
+
+	size_t statements = 0;
+	auto parsing = measure(rounds, [&] {
+		DiscardingInterpreter interpreter;
+		arx::CommandParser<DiscardingInterpreter> parser{ interpreter };
+		parser.optimizing = false;
+		arx::CommandLexer<DiscardingInterpreter> lexer{ parser };
+		std::istringstream input{ source };
+		input >> lexer;
+		statements = interpreter.statements;
+	});
+
+	auto megabytes = static_cast<double>(source.size()) * rounds / (1024.0 * 1024.0);
+	std::cout << "source: " << source.size() << " bytes, " << tokens << " tokens, " << statements << " statements, " << rounds << " rounds" << std::endl;
+	std::cout << "lex:         " << megabytes / lexing << " MB/s, " << tokens * rounds / lexing / 1e6 << " M tokens/s" << std::endl;
+	std::cout << "lex + parse: " << megabytes / parsing << " MB/s, " << statements * rounds / parsing / 1e6 << " M statements/s" << std::endl;
+	return 0;
+}
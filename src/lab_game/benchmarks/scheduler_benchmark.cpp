@@ -0,0 +1,201 @@
+#include "../../engine/command/command.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// Runs the `.arx` workloads on many runtimes at once with a `CommandScheduler`, for 1, 2, 4... threads up to `--threads`,
+// and reports how the throughput scales with the threads.
+// Usage: scheduler_benchmark [options] [workload...]
+// A round starts the workload on every runtime, created from one `CommandContext` outside the measurement, and runs them all to the end.
+// Scaling is only linear up to the cores of the machine, which `--threads` defaults to.
+
+#ifndef ARXEMAND_WORKLOADS_DIR
+#define ARXEMAND_WORKLOADS_DIR "benchmarks/workloads"
+#endif
+
+struct Workload
+{
+	std::string name;
+	std::string source;
+};
+
+struct Options
+{
+	arx::CommandMachine::Mode mode = arx::CommandMachine::Mode::Compiled;
+	size_t runtimes = 64;
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	uint64_t instructions = 100000; // per slice.
+	double minimum_seconds = 0.5;
+	size_t minimum_rounds = 3;
+	std::filesystem::path directory = ARXEMAND_WORKLOADS_DIR;
+	std::vector<std::string> names;
+};
+
+// Everything a runtime writes to, so it isn't shared by the runtimes.
+struct Streams
+{
+	std::istringstream input;
+	std::ostringstream output;
+	std::ostringstream errors;
+};
+
+// One round, returning its time in nanoseconds, and the errors of the first runtime.
+auto run_round(const Workload& workload, const Options& options, const std::shared_ptr<arx::CommandContext>& context, arx::CommandScheduler& scheduler, std::string& errors) -> double {
+	std::vector<std::unique_ptr<Streams>> streams;
+	std::vector<std::unique_ptr<arx::CommandRuntime>> runtimes;
+	for (size_t i = 0; i < options.runtimes; ++i) {
+		auto& stream = *streams.emplace_back(std::make_unique<Streams>());
+		auto& runtime = *runtimes.emplace_back(std::make_unique<arx::CommandRuntime>(context, stream.input, stream.output, stream.errors));
+		runtime.machine.mode = options.mode;
+		runtime.load_library(arx::CommandLibrary::basic_library(stream.input, runtime.sink, runtime.kernel, runtime.exit));
+		runtime.import("math");
+		runtime.import("string");
+		runtime.start(workload.source);
+		scheduler.add(runtime);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	scheduler.run({ options.instructions, std::chrono::microseconds{ 0 } });
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	for (auto& runtime : runtimes) {
+		scheduler.remove(*runtime);
+	}
+	errors = streams.front()->errors.str();
+	return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+// The median time of a round on `thread_count` threads, or nothing if the workload failed.
+auto measure(const Workload& workload, const Options& options, size_t thread_count) -> std::optional<double> {
+	auto context = std::make_shared<arx::CommandContext>();
+	arx::CommandScheduler scheduler{ thread_count };
+	std::string errors;
+	run_round(workload, options, context, scheduler, errors); // warming up, which compiles the shared script.
+	if (!errors.empty()) {
+		std::cerr << workload.name << " failed:" << std::endl << errors;
+		return std::nullopt;
+	}
+
+	std::vector<double> times;
+	double total_seconds = 0;
+	while (times.size() < options.minimum_rounds || total_seconds < options.minimum_seconds) {
+		times.push_back(run_round(workload, options, context, scheduler, errors));
+		total_seconds += times.back() / 1e9;
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+auto load_workloads(const Options& options) -> std::vector<Workload> {
+	std::vector<Workload> workloads;
+	std::error_code error;
+	for (auto& entry : std::filesystem::directory_iterator{ options.directory, error }) {
+		if (entry.path().extension() != ".arx") {
+			continue;
+		}
+		auto name = entry.path().stem().string();
+		if (!options.names.empty() && std::find(options.names.begin(), options.names.end(), name) == options.names.end()) {
+			continue;
+		}
+		std::ifstream file{ entry.path() };
+		std::stringstream source;
+		source << file.rdbuf();
+		workloads.push_back({ std::move(name), source.str() });
+	}
+	if (error) {
+		std::cerr << "Cannot read " << options.directory.string() << ": " << error.message() << std::endl;
+	}
+	std::sort(workloads.begin(), workloads.end(), [](const Workload& a, const Workload& b) { return a.name < b.name; });
+	return workloads;
+}
+
+auto main(int argument_count, char* arguments[]) -> int {
+	Options options;
+	for (int i = 1; i < argument_count; ++i) {
+		std::string_view argument{ arguments[i] };
+
+		if (argument == "-h" || argument == "--help") {
+			std::cout << "Usage: scheduler_benchmark [options] [workload...]" << std::endl;
+			std::cout << "Options:" << std::endl;
+			std::cout << "  -h, --help\t\t\tShow this help message and exit" << std::endl;
+			std::cout << "  -r, --reference\t\tExcute with the reference tree walker instead of the compiled machine" << std::endl;
+			std::cout << "  --runtimes=<count>\t\tRun the workload on this many runtimes at once (default 64)" << std::endl;
+			std::cout << "  --threads=<count>\t\tScale up to this many threads (default: the cores of the machine)" << std::endl;
+			std::cout << "  --slice=<instructions>\tExcute slices of this many instructions (default 100000)" << std::endl;
+			std::cout << "  --workloads=<directory>\tRead the .arx workloads from the directory" << std::endl;
+			std::cout << "  --min-time=<seconds>\t\tRun rounds for at least this long per thread count (default 0.5)" << std::endl;
+			std::cout << "  --min-rounds=<count>\t\tRun at least this many rounds per thread count (default 3)" << std::endl;
+			return 0;
+		}
+		else if (argument == "-r" || argument == "--reference") {
+			options.mode = arx::CommandMachine::Mode::Reference;
+		}
+		else if (argument.rfind("--runtimes=", 0) == 0) {
+			options.runtimes = std::max<size_t>(1, std::stoul(std::string{ argument.substr(11) }));
+		}
+		else if (argument.rfind("--threads=", 0) == 0) {
+			options.threads = std::max<size_t>(1, std::stoul(std::string{ argument.substr(10) }));
+		}
+		else if (argument.rfind("--slice=", 0) == 0) {
+			options.instructions = std::stoull(std::string{ argument.substr(8) });
+		}
+		else if (argument.rfind("--workloads=", 0) == 0) {
+			options.directory = argument.substr(12);
+		}
+		else if (argument.rfind("--min-time=", 0) == 0) {
+			options.minimum_seconds = std::stod(std::string{ argument.substr(11) });
+		}
+		else if (argument.rfind("--min-rounds=", 0) == 0) {
+			options.minimum_rounds = std::max<size_t>(1, std::stoul(std::string{ argument.substr(13) }));
+		}
+		else if (argument[0] == '-') {
+			std::cerr << "Unknown option: " << argument << std::endl;
+			return 1;
+		}
+		else {
+			options.names.emplace_back(argument);
+		}
+	}
+
+	auto workloads = load_workloads(options);
+	if (workloads.empty()) {
+		std::cerr << "No workloads found in " << options.directory.string() << std::endl;
+		return 1;
+	}
+
+	std::vector<size_t> thread_counts;
+	for (size_t count = 1; count < options.threads; count *= 2) {
+		thread_counts.push_back(count);
+	}
+	thread_counts.push_back(options.threads);
+
+	std::cout << std::left << std::setw(20) << "workload" << std::right << std::setw(10) << "threads" << std::setw(10) << "runtimes"
+		<< std::setw(14) << "ms/round" << std::setw(14) << "runtimes/s" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::endl;
+	std::cout.setf(std::ios::fixed);
+
+	bool failed = false;
+	for (auto& workload : workloads) {
+		std::optional<double> single;
+		for (auto thread_count : thread_counts) {
+			auto nanoseconds = measure(workload, options, thread_count);
+			if (!nanoseconds.has_value()) {
+				failed = true;
+				break;
+			}
+			if (!single.has_value()) {
+				single = nanoseconds;
+			}
+			auto speedup = *single / *nanoseconds;
+			std::cout << std::left << std::setw(20) << workload.name << std::right << std::setw(10) << thread_count << std::setw(10) << options.runtimes
+				<< std::setw(14) << std::setprecision(2) << *nanoseconds / 1e6
+				<< std::setw(14) << std::setprecision(0) << options.runtimes / (*nanoseconds / 1e9)
+				<< std::setw(9) << std::setprecision(2) << speedup << 'x'
+				<< std::setw(11) << std::setprecision(0) << speedup / thread_count * 100 << '%' << std::endl;
+		}
+	}
+	return failed ? 1 : 0;
+}
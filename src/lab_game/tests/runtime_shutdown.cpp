@@ -0,0 +1,70 @@
+#include "../../engine/command/command.hpp"
+
+#include <sstream>
+
+// Submits code from several threads while the worker thread is shut down: every submission which returned before `shutdown` was called
+// must have been excuted once it returns, even if another producer was still linking an earlier one, and its posted effect applied by `drain`.
+// Usage: runtime_shutdown [trials]
+
+constexpr size_t producer_count = 4;
+constexpr size_t submissions_per_producer = 64;
+
+// Returns false if a submission returned before `shutdown` was lost.
+auto trial() -> bool {
+	std::istringstream input;
+	std::ostringstream output;
+	std::ostringstream errors;
+	arx::CommandRuntime runtime{ input, output, errors };
+	size_t applied = 0; // only touched by the effects, which this thread applies.
+	arx::CommandLibrary library;
+	library.add_function("tick", [&runtime, &applied](arx::CommandValue::Arguments, arx::CommandValue*) -> uint32_t {
+		runtime.post([&applied] { ++applied; });
+		return 0;
+	});
+	runtime.load_library(std::move(library));
+	runtime.launch();
+
+	std::atomic<size_t> submitted{ 0 };
+	std::vector<std::thread> producers;
+	for (size_t i = 0; i < producer_count; ++i) {
+		producers.emplace_back([&runtime, &submitted] {
+			for (size_t j = 0; j < submissions_per_producer; ++j) {
+				runtime.submit("tick();");
+				submitted.fetch_add(1, std::memory_order_release);
+			}
+		});
+	}
+
+	while (submitted.load(std::memory_order_acquire) < producer_count * submissions_per_producer / 2) {
+		runtime.drain();
+	}
+	auto submitted_before = submitted.load(std::memory_order_acquire);
+	runtime.shutdown();
+	runtime.drain();
+	auto applied_before = applied;
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	if (applied_before < submitted_before) {
+		std::cerr << submitted_before << " submitted before the shutdown, " << applied_before << " excuted." << std::endl;
+		return false;
+	}
+	if (!errors.str().empty()) {
+		std::cerr << errors.str();
+		return false;
+	}
+	return true;
+}
+
+auto main(int argument_count, char* arguments[]) -> int {
+	size_t trials = argument_count > 1 ? std::stoull(arguments[1]) : 200;
+	for (size_t i = 0; i < trials; ++i) {
+		if (!trial()) {
+			std::cerr << "Trial " << i << " failed." << std::endl;
+			return 1;
+		}
+	}
+	std::cout << trials << " trials passed." << std::endl;
+	return 0;
+}
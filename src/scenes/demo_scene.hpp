@@ -313,6 +313,9 @@ namespace arx
 				entities.panel.text.text.set_content(std::to_string(value));
 			};
 
+			// Long commands are spread over several frames rather than dropping them.
+			systems.command_system.budget.time = std::chrono::milliseconds{ 2 };
+
 			/*command_runtime->kernel.add_method("teleport", [&](const std::vector<arx::CommandValue>& arguments, arx::CommandValue& result) {
 				if (arguments.size() != 3) {
 					throw arx::CommandException{ "`teleport` requires 3 arguments. \nHint: `teleport` is used to set xr_offset. \nUsage: `teleport(x, y, z)`" };